@@ -78,6 +78,13 @@ create_table_func_from_csv() {
     done < $file
     code=${code::-1}
 
+    # flat table after A2SData, constant initialized,
+    # before the function so that its position below is not shifted
+    write_declare_map=$(awk '/struct A2SData/ {found=1} found && /};/ {print NR; exit}' $output_file)
+    write_declare_map=$(($write_declare_map + 1))
+    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset = ${code_offset};" $output_file
+    sed -i "${write_declare_map}i\    static constexpr A2SData ${function_name}Data[] = {${code}};" $output_file
+
     awk "/float TableTemplate/,/};/" $template_file > /tmp/mjointsstrokehh
     sed -i "s/TableTemplate/${function_name}/g" /tmp/mjointsstrokehh
 
@@ -92,11 +99,6 @@ create_table_func_from_csv() {
 	write_to_line=$(($write_to_line + 1))
     done < /tmp/mjointsstrokehh
 
-    write_declare_map=$(grep -n -m 1 "};" $output_file | cut -d ':' -f1)
-    write_declare_map=$(($write_declare_map + 1))
-    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset = ${code_offset};" $output_file
-    sed -i "${write_declare_map}i\    static const std::vector<std::pair<float, float>> ${function_name}Map = {${code}};" $output_file
-
     sed -i "${write_to_top_line}i\    //////////////////////////////////////////////////" $output_file
     sed -i "${write_to_top_line}i\ " $output_file
 }
@@ -145,6 +147,13 @@ create_rp_table_func_from_csv() {
     code2="${code2}"
     code2=${code2::-2}
 
+    write_declare_map=$(awk '/struct A2SData/ {found=1} found && /};/ {print NR; exit}' $output_file)
+    write_declare_map=$(($write_declare_map + 1))
+    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset1 = ${code1_offset};" $output_file
+    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset2 = ${code2_offset};" $output_file
+    sed -i "${write_declare_map}i\    static constexpr A2SData ${function_name}Data1[] = {${code1}};" $output_file
+    sed -i "${write_declare_map}i\    static constexpr A2SData ${function_name}Data2[] = {${code2}};" $output_file
+
     awk "/dualJoint TableTemplate/,/};/" $template_file > /tmp/mjointsstrokehh
     sed -i "s/TableTemplate/${function_name}/g" /tmp/mjointsstrokehh
 
@@ -159,13 +168,6 @@ create_rp_table_func_from_csv() {
 	write_to_line=$(($write_to_line + 1))
     done < /tmp/mjointsstrokehh
 
-    write_declare_map=$(grep -n -m 1 "};" $output_file | cut -d ':' -f1)
-    write_declare_map=$(($write_declare_map + 1))
-    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset1 = ${code1_offset};" $output_file
-    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset2 = ${code2_offset};" $output_file
-    sed -i "${write_declare_map}i\    static const std::vector<std::pair<float, float>> ${function_name}Map1 = {${code1}};" $output_file
-    sed -i "${write_declare_map}i\    static const std::vector<std::pair<float, float>> ${function_name}Map2 = {${code2}};" $output_file
-
     sed -i "${write_to_top_line}i\    //////////////////////////////////////////////////" $output_file
     sed -i "${write_to_top_line}i\ " $output_file
 }
@@ -247,7 +249,7 @@ sed -i "/#define/d" $output_source
 sed -i "/#endif/d" $output_source
 sed -i "s/};/}/g" $output_source
 sed -i "/static const int Array/ d" $output_source
-sed -i "/static const std::vector<std::pair<float, float>>/ d" $output_source
+sed -i "/static constexpr A2SData/ d" $output_source
 
 edit_start=$(grep -n -m 1 "//////" $output_file | cut -d ':' -f1)
 tail -n +$edit_start $output_file > /tmp/aero_modify_header
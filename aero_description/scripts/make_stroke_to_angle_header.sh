@@ -33,6 +33,19 @@ replace_meta_in_output_file() {
     done < /tmp/aero_CAN_order
 }
 
+# append one bucket (candidates and appendix of an integer stroke)
+# to flat table data, entries are "{angle,stroke,range}," each
+append_bucket() {
+    candidates=$1
+    appendix=$2
+
+    candidates_size=$(echo -n "${candidates}" | grep -o "}" | wc -l)
+    appendix_size=$(echo -n "${appendix}" | grep -o "}" | wc -l)
+    buckets="${buckets}{${data_size},${candidates_size},$((${data_size} + ${candidates_size})),${appendix_size}}, "
+    data="${data}${candidates}${appendix}"
+    data_size=$((${data_size} + ${candidates_size} + ${appendix_size}))
+}
+
 create_table_func_from_csv() {
     joint_name=$1
     # offset=$2
@@ -105,7 +118,9 @@ create_table_func_from_csv() {
 	idx=$(($idx + 1))
     done
 
-    code=''
+    data=''
+    data_size=0
+    buckets=''
     array_offset=0
 
     # negative stroke value case
@@ -115,7 +130,7 @@ create_table_func_from_csv() {
         e=${ntable[$idx]}
         if [[ $e != "" ]]
         then
-            code="${code}{{${e::-1}},{}}, "
+            append_bucket "$e" ""
             array_offset="-$idx"
         elif [[ ${#ntable[@]} -gt 1 ]]
         then
@@ -128,23 +143,17 @@ create_table_func_from_csv() {
         e=${ntable[$idx]}
 	if [[ $e != "" ]]
 	then
-            code="${code}{{${e::-1}},"
 	    j=1
 	    if [[ ${ntable[$(($idx + $j))]} == "" ]]
 	    then
 		j=2
 	    fi
 	    appendix=$(echo -e "${ntable[$(($idx + $j))]}")
-            if [[ "$appendix" = "" ]]
-            then
-                code="${code}{}}, "
-            else
-		code="${code}{${appendix::-1}}}, "
-            fi
+            append_bucket "$e" "$appendix"
         elif [[ $idx != 0 ]]
         then
             echo "   detected empty table in -${idx} of ${function_name}"
-            code="${code}{{{0,0.0f,0.0f}}, {}}, "
+            append_bucket "{0,0.0f,0.0f}," ""
 	fi
     done
 
@@ -154,26 +163,28 @@ create_table_func_from_csv() {
     do
 	if [[ $e != "" ]]
 	then
-            code="${code}{{${e::-1}},"
+	    appendix=""
 	    if [[ $idx -lt $((${#table[@]} - 1)) ]]
 	    then
 		appendix=$(echo -e "${table[$(($idx + 1))]}")
-                if [[ "$appendix" = "" ]]
-                then
-                    code="${code}{}}, "
-                else
-		    code="${code}{${appendix::-1}}}, "
-                fi
-            else
-                code="${code}{}}, "
 	    fi
+            append_bucket "$e" "$appendix"
         else
             echo "   detected empty table in ${idx} of ${function_name}"
-            code="${code}{{{0,0.0f,0.0f}}, {}}, "
+            append_bucket "{0,0.0f,0.0f}," ""
 	fi
 	idx=$(($idx + 1))
     done
-    code="${code::-2}"
+    data="${data::-1}"
+    buckets="${buckets::-2}"
+
+    # flat tables after S2ABucket, constant initialized,
+    # before the function so that its position below is not shifted
+    write_declare_map=$(awk '/struct S2ABucket/ {found=1} found && /};/ {print NR; exit}' $output_file)
+    write_declare_map=$(($write_declare_map + 1))
+    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset = ${array_offset};" $output_file
+    sed -i "${write_declare_map}i\    static constexpr S2ABucket ${function_name}Buckets[] = {${buckets}};" $output_file
+    sed -i "${write_declare_map}i\    static constexpr S2AData ${function_name}Data[] = {${data}};" $output_file
 
     awk "/float TableTemplate/,/};/" $template_file > /tmp/mjointsanglehh
     sed -i "s/TableTemplate/${function_name}/g" /tmp/mjointsanglehh
@@ -189,11 +200,6 @@ create_table_func_from_csv() {
 	write_to_line=$(($write_to_line + 1))
     done < /tmp/mjointsanglehh
 
-    write_declare_map=$(grep -n -m 1 "};" $output_file | cut -d ':' -f1)
-    write_declare_map=$(($write_declare_map + 1))
-    sed -i "${write_declare_map}i\    static const int Array${function_name}Offset = ${array_offset};" $output_file
-    sed -i "${write_declare_map}i\    static const std::vector<std::pair<std::vector<S2AData>, std::vector<S2AData>>> ${function_name}Candidates = {${code}};" $output_file
-
     sed -i "${write_to_top_line}i\    //////////////////////////////////////////////////" $output_file
     sed -i "${write_to_top_line}i\ " $output_file
 
@@ -267,7 +273,7 @@ sed -i "/#define/d" $output_source
 sed -i "/#endif/d" $output_source
 sed -i "s/};/}/g" $output_source
 sed -i "/static const int Array/ d" $output_source
-sed -i "/static const std::vector<std::pair<std::vector<S2AData>, std::vector<S2AData>>>/ d" $output_source
+sed -i "/static constexpr S2A/ d" $output_source
 
 edit_start=$(grep -n -m 1 "//////" $output_file | cut -d ':' -f1)
 tail -n +$edit_start $output_file > /tmp/aero_modify_header
@@ -17,9 +17,22 @@ namespace aero
       float two;
     };
 
+    struct A2SData
+    {
+      float stroke;
+      float interval;
+    };
+
+    //////////////////////////////////////////////////
+    void Angle2Stroke
+    (std::vector<int16_t>& _strokes, const std::vector<double>& _angles)
+    {
+      Angle2Stroke(_strokes.data(), _angles.data());
+    };
+
     //////////////////////////////////////////////////
     void Angle2Stroke
-    (std::vector<int16_t>& _strokes, const std::vector<double> _angles)
+    (int16_t* _strokes, const double* _angles)
     {
       float rad2Deg = 180.0 / M_PI;
       float scale = 100.0;
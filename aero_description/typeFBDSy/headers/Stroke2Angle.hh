@@ -18,9 +18,17 @@ namespace aero
       float range;
     };
 
+    struct S2ABucket
+    {
+      int candidates;
+      int candidates_size;
+      int appendix;
+      int appendix_size;
+    };
+
     //////////////////////////////////////////////////
     void Stroke2Angle
-    (std::vector<double>& _angles, const std::vector<int16_t> _strokes)
+    (std::vector<double>& _angles, const std::vector<int16_t>& _strokes)
     {
       float scale = 0.01;
       float left_wrist_roll_stroke =
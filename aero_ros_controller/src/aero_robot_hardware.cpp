@@ -40,7 +40,6 @@
 #include "aero_robot_hardware.h"
 #include <urdf/model.h>
 
-#include <thread>
 
 namespace aero_robot_hardware
 {
@@ -71,15 +70,34 @@ bool AeroRobotHW::init(ros::NodeHandle& root_nh, ros::NodeHandle &robot_hw_nh)//
   }  else {
     OVERLAP_SCALE_    = 2.8;     //
   }
+  robot_hw_nh.param("fused_cycle", FUSED_CYCLE_, false);
+  robot_hw_nh.param("telemetry_rate", TELEMETRY_RATE_, 0.0);
+  std::string capture_prefix;
+  robot_hw_nh.param("capture_prefix", capture_prefix, std::string(""));
+  std::string tables_dir, tables_cache;
+  robot_hw_nh.param("conversion_tables", tables_dir, std::string(""));
+  robot_hw_nh.param("conversion_tables_cache", tables_cache, std::string(""));
 
   ROS_INFO("upper_port: %s", port_upper.c_str());
   ROS_INFO("lower_port: %s", port_lower.c_str());
   ROS_INFO("cycle: %f [ms], overlap_scale %f", CONTROL_PERIOD_US_*0.001, OVERLAP_SCALE_);
+  ROS_INFO("fused_cycle: %d", FUSED_CYCLE_);
+  ROS_INFO("telemetry_rate: %f [Hz]", TELEMETRY_RATE_);
 
   // create controllersd
   controller_upper_.reset(new AeroUpperController(port_upper));
   controller_lower_.reset(new AeroLowerController(port_lower));
 
+  // record bus traffic for seed_replay
+  if (!capture_prefix.empty()) {
+    std::string upper_file = capture_prefix + "_upper.seedcap";
+    std::string lower_file = capture_prefix + "_lower.seedcap";
+    if (controller_upper_->start_capture(upper_file))
+      ROS_INFO("capture upper: %s", upper_file.c_str());
+    if (controller_lower_->start_capture(lower_file))
+      ROS_INFO("capture lower: %s", lower_file.c_str());
+  }
+
   // joint list
   number_of_angles_ =
     controller_upper_->get_number_of_angle_joints() +
@@ -97,6 +115,21 @@ bool AeroRobotHW::init(ros::NodeHandle& root_nh, ros::NodeHandle &robot_hw_nh)//
     }
   }
 
+  // conversion tables of robot description, must match built controllers
+  if (!tables_dir.empty()) {
+    tables_.reset(new ConversionTables());
+    if (tables_->load(tables_dir, tables_cache) &&
+        tables_->angle_joint_names() == joint_list_ &&
+        tables_->number_of_strokes() == AERO_DOF) {
+      ROS_INFO("conversion_tables: %s%s", tables_dir.c_str(),
+               tables_->from_cache() ? " (cached)" : "");
+    } else {
+      ROS_WARN("conversion_tables: %s does not match, using generated conversion",
+               tables_dir.c_str());
+      tables_.reset();
+    }
+  }
+
   // stroke list
 #if 0
   number_of_strokes_ =
@@ -113,7 +146,31 @@ bool AeroRobotHW::init(ros::NodeHandle& root_nh, ros::NodeHandle &robot_hw_nh)//
   }
 #endif
   prev_ref_positions_.resize(number_of_angles_);
+  prev_upper_state_.seq = 0;
+  prev_lower_state_.seq = 0;
+  act_stroke_velocities_.assign(AERO_DOF_UPPER + AERO_DOF_LOWER, 0.0);
   initialized_flag_ = false;
+  upper_position_replied_ = false;
+  lower_position_replied_ = false;
+
+  // keep 10% of period free, so jitter does not delay next read
+  double period_sec = CONTROL_PERIOD_US_ * 1e-6;
+  upper_telemetry_.reset(new TelemetryScheduler(period_sec, 0.1 * period_sec));
+  lower_telemetry_.reset(new TelemetryScheduler(period_sec, 0.1 * period_sec));
+  for (int i = 0; i < NUM_TELEMETRY; i++) {
+    upper_telemetry_->set_rate(static_cast<TelemetryItem>(i), TELEMETRY_RATE_);
+    lower_telemetry_->set_rate(static_cast<TelemetryItem>(i), TELEMETRY_RATE_);
+  }
+  upper_current_.resize(AERO_DOF_UPPER);
+  lower_current_.resize(AERO_DOF_LOWER);
+  upper_temperature_.resize(AERO_DOF_UPPER);
+  lower_temperature_.resize(AERO_DOF_LOWER);
+  if (TELEMETRY_RATE_ > 0.0) {
+    current_pub_ = robot_hw_nh.advertise<std_msgs::Int16MultiArray>("current", 1);
+    temperature_pub_ = robot_hw_nh.advertise<std_msgs::Int16MultiArray>("temperature", 1);
+    utilization_pub_ = robot_hw_nh.advertise<std_msgs::Float32MultiArray>("bus_utilization", 1);
+  }
+  last_telemetry_pub_ = ros::Time::now();
 
   std::string model_str;
   if (!root_nh.getParam("robot_description", model_str)) {
@@ -205,65 +262,90 @@ void AeroRobotHW::readPos(const ros::Time& time, const ros::Duration& period, bo
   mutex_upper_.lock();
   // TODO: thrading?? or making no wait
   if (update) {
+    // in fused cycle, the position returned by last write is used as is
+    bool update_upper = upper_send_enable_ &&
+      !(FUSED_CYCLE_ && upper_position_replied_);
+    bool update_lower = !(FUSED_CYCLE_ && lower_position_replied_);
+    upper_position_replied_ = false;
+    lower_position_replied_ = false;
 #if 0 // NO_THREAD
-    controller_upper_->update_position();
-    controller_lower_->update_position();
+    if (update_upper) controller_upper_->update_position();
+    if (update_lower) controller_lower_->update_position();
 #else
-    std::thread t1([&](){
-        if(upper_send_enable_) {
+    if (update_upper) {
+      bus_workers_.post(BUS_UPPER, [&](){
+          auto start = TelemetryScheduler::clock::now();
           controller_upper_->update_position();
-        }
-      });
-    std::thread t2([&](){
-        controller_lower_->update_position();
-      });
-    t1.join();
-    t2.join();
+          upper_telemetry_->record(TelemetryScheduler::clock::now() - start);
+        });
+    }
+    if (update_lower) {
+      bus_workers_.post(BUS_LOWER, [&](){
+          auto start = TelemetryScheduler::clock::now();
+          controller_lower_->update_position();
+          lower_telemetry_->record(TelemetryScheduler::clock::now() - start);
+        });
+    }
+    bus_workers_.wait();
 #endif
   }
-  // get upper actual positions
-  std::vector<int16_t> upper_act_strokes =
-    controller_upper_->get_actual_stroke_vector();
-  // get lower actual positions
-  std::vector<int16_t> lower_act_strokes =
-    controller_lower_->get_actual_stroke_vector();
   mutex_upper_.unlock();
   mutex_lower_.unlock();
 
+  // actual positions from snapshots, no lock and no copy of vectors
+  bool upper_ok = controller_upper_->get_state(upper_state_);
+  bool lower_ok = controller_lower_->get_state(lower_state_);
+
   // whole body strokes
   std::vector<int16_t> act_strokes (AERO_DOF_UPPER + AERO_DOF_LOWER);
-  if (upper_act_strokes.size() < AERO_DOF_UPPER) {
+  if (!upper_ok || upper_state_.size < AERO_DOF_UPPER) {
     for (size_t i = 0; i < AERO_DOF_UPPER; ++i) {
       act_strokes[i] = 0;
     }
   } else { // usually should enter else, enters if when port is not activated
     for (size_t i = 0; i < AERO_DOF_UPPER; ++i) {
-      act_strokes[i] = upper_act_strokes[i];
+      act_strokes[i] = upper_state_.actual[i];
     }
   }
-  if ( lower_act_strokes.size() < AERO_DOF_LOWER ) {
+  if (!lower_ok || lower_state_.size < AERO_DOF_LOWER) {
     for (size_t i = 0; i < AERO_DOF_LOWER; ++i) {
       act_strokes[i + AERO_DOF_UPPER] = 0; //??
     }
   } else { // usually should enter else, enters if when port is not activated
     for (size_t i = 0; i < AERO_DOF_LOWER; ++i) {
-      act_strokes[i + AERO_DOF_UPPER] = lower_act_strokes[i];
+      act_strokes[i + AERO_DOF_UPPER] = lower_state_.actual[i];
     }
   }
   // whole body positions from strokes
   std::vector<double> act_positions;
   act_positions.resize(number_of_angles_);
-  common::Stroke2Angle(act_positions, act_strokes);
+  if (tables_)
+    tables_->Stroke2Angle(act_positions, act_strokes);
+  else
+    common::Stroke2Angle(act_positions, act_strokes);
 
   // DEBUG
   // act_strokes
   // act_positions
   //
 
-  double tm = period.toSec();
+  // whole body velocities from the last two snapshots of each bus,
+  // buses publish on their own, not once per cycle;
+  // only the tables have the slopes, 0 with generated functions
+  updateStrokeVelocities(upper_ok, upper_state_, AERO_DOF_UPPER,
+                         prev_upper_state_, act_stroke_velocities_.data());
+  updateStrokeVelocities(lower_ok, lower_state_, AERO_DOF_LOWER,
+                         prev_lower_state_,
+                         act_stroke_velocities_.data() + AERO_DOF_UPPER);
+  std::vector<double> act_velocities(number_of_angles_, 0.0);
+  if (tables_) {
+    tables_->Stroke2AngleVelocity(act_velocities, act_strokes,
+                                  act_stroke_velocities_);
+  }
+
   for(unsigned int j=0; j < number_of_angles_; j++) {
     float position = act_positions[j];
-    float velocity = 0.0;
+    float velocity = act_velocities[j];
 
     if (joint_types_[j] == PRISMATIC) {
       joint_position_[j] = position;
@@ -286,6 +368,11 @@ void AeroRobotHW::readPos(const ros::Time& time, const ros::Duration& period, bo
 
 void AeroRobotHW::read(const ros::Time& time, const ros::Duration& period)
 {
+  // a control period starts here, motion frames first
+  auto cycle_start = TelemetryScheduler::clock::now();
+  upper_telemetry_->begin_cycle(cycle_start);
+  lower_telemetry_->begin_cycle(cycle_start);
+
   //
   mutex_upper_.lock();
   bool collision_status = controller_upper_->get_status();
@@ -352,9 +439,16 @@ void AeroRobotHW::write(const ros::Time& time, const ros::Duration& period)
   }
 
   std::vector<int16_t> ref_strokes(AERO_DOF);
-  common::Angle2Stroke(ref_strokes, ref_positions);
-  std::vector<int16_t> snt_strokes(ref_strokes);
-  common::UnusedAngle2Stroke(snt_strokes, mask_positions);
+  std::vector<int16_t> snt_strokes;
+  if (tables_) {
+    tables_->Angle2Stroke(ref_strokes, ref_positions);
+    snt_strokes = ref_strokes;
+    tables_->UnusedAngle2Stroke(snt_strokes, mask_positions);
+  } else {
+    common::Angle2Stroke(ref_strokes, ref_positions);
+    snt_strokes = ref_strokes;
+    common::UnusedAngle2Stroke(snt_strokes, mask_positions);
+  }
 
   // split strokes into upper and lower
   std::vector<int16_t> upper_strokes(snt_strokes.begin(), snt_strokes.begin() + AERO_DOF_UPPER);
@@ -366,27 +460,113 @@ void AeroRobotHW::write(const ros::Time& time, const ros::Duration& period)
   mutex_upper_.lock();
   {
 #if 0 // NO_THREAD
-    controller_upper_->set_position(upper_strokes, time_csec);
-    controller_lower_->set_position(lower_strokes, time_csec);
+    upper_position_replied_ =
+      controller_upper_->set_position(upper_strokes, time_csec);
+    lower_position_replied_ =
+      controller_lower_->set_position(lower_strokes, time_csec);
 #else
-    std::thread t1([&](){
-        controller_upper_->set_position(upper_strokes, time_csec);
-      });
-    std::thread t2([&](){
-        controller_lower_->set_position(lower_strokes, time_csec);
-      });
-    t1.join();
-    t2.join();
+    bus_workers_.run(
+        [&](){
+          auto start = TelemetryScheduler::clock::now();
+          upper_position_replied_ =
+            controller_upper_->set_position(upper_strokes, time_csec);
+          upper_telemetry_->record(TelemetryScheduler::clock::now() - start);
+          pollTelemetry(*controller_upper_, *upper_telemetry_,
+                        upper_current_, upper_temperature_);
+        },
+        [&](){
+          auto start = TelemetryScheduler::clock::now();
+          lower_position_replied_ =
+            controller_lower_->set_position(lower_strokes, time_csec);
+          lower_telemetry_->record(TelemetryScheduler::clock::now() - start);
+          pollTelemetry(*controller_lower_, *lower_telemetry_,
+                        lower_current_, lower_temperature_);
+        });
     //usleep( 1000 * 2 ); // why needed?
   }
 #endif
   mutex_upper_.unlock();
   mutex_lower_.unlock();
 
+  publishTelemetry(time);
+
   // read
   //readPos(time, period, false);
 }
 
+void AeroRobotHW::updateStrokeVelocities(bool _ok, const StrokeState& _state,
+                                         size_t _strokes, StrokeState& _prev,
+                                         double* _velocities)
+{
+  if (!_ok || _state.size < _strokes) {
+    // not read, no velocity and none from this state on
+    std::fill(_velocities, _velocities + _strokes, 0.0);
+    _prev.seq = 0;
+    return;
+  }
+  // not published since the last cycle, velocities stay
+  if (_state.seq == _prev.seq) return;
+
+  double tm = std::chrono::duration<double>(_state.stamp - _prev.stamp).count();
+  if (_prev.seq == 0 || _prev.size < _strokes || tm <= 0) {
+    std::fill(_velocities, _velocities + _strokes, 0.0);
+  } else {
+    for (size_t i = 0; i < _strokes; ++i) {
+      _velocities[i] = (_state.actual[i] - _prev.actual[i]) / tm;
+    }
+  }
+  _prev = _state;
+}
+
+void AeroRobotHW::pollTelemetry(AeroControllerProto& _controller,
+                                TelemetryScheduler& _scheduler,
+                                std::vector<int16_t>& _current,
+                                std::vector<int16_t>& _temperature)
+{
+  TelemetryItem item;
+  while (_scheduler.next(TelemetryScheduler::clock::now(), item)) {
+    auto start = TelemetryScheduler::clock::now();
+    switch (item) {
+    case TELEMETRY_CURRENT:
+      _controller.get_current(_current);
+      break;
+    case TELEMETRY_TEMPERATURE:
+      _controller.get_temperature(_temperature);
+      break;
+    case TELEMETRY_MISSTEP:
+      _controller.update_status();
+      break;
+    default:
+      break;
+    }
+    _scheduler.done(item, TelemetryScheduler::clock::now() - start);
+  }
+}
+
+void AeroRobotHW::publishTelemetry(const ros::Time& time)
+{
+  if (TELEMETRY_RATE_ <= 0.0) return;
+  if ((time - last_telemetry_pub_).toSec() < 1.0 / TELEMETRY_RATE_) return;
+  last_telemetry_pub_ = time;
+
+  // strokes of upper and lower in stroke order
+  std_msgs::Int16MultiArray current;
+  current.data.assign(upper_current_.begin(), upper_current_.end());
+  current.data.insert(current.data.end(), lower_current_.begin(), lower_current_.end());
+  current_pub_.publish(current);
+
+  std_msgs::Int16MultiArray temperature;
+  temperature.data.assign(upper_temperature_.begin(), upper_temperature_.end());
+  temperature.data.insert(temperature.data.end(), lower_temperature_.begin(), lower_temperature_.end());
+  temperature_pub_.publish(temperature);
+
+  std_msgs::Float32MultiArray utilization;
+  utilization.data.resize(2);
+  utilization.data[0] = upper_telemetry_->utilization();
+  utilization.data[1] = lower_telemetry_->utilization();
+  utilization_pub_.publish(utilization);
+}
+
 void AeroRobotHW::writeWheel(const std::vector< std::string> &_names, const std::vector<int16_t> &_vel, double _tm_sec) {
   ROS_DEBUG("wheel %d %d %d %d",
             _vel[0], _vel[1], _vel[2], _vel[3]);
@@ -52,6 +52,8 @@
 // ROS
 #include <ros/ros.h>
 #include <angles/angles.h>
+#include <std_msgs/Int16MultiArray.h>
+#include <std_msgs/Float32MultiArray.h>
 
 // URDF
 #include <urdf/model.h>
@@ -64,6 +66,9 @@
 #include "aero_hardware_interface/Stroke2Angle.hh"
 #include "aero_hardware_interface/Angle2Stroke.hh"
 #include "aero_hardware_interface/UnusedAngle2Stroke.hh"
+#include "aero_hardware_interface/ConversionTables.hh"
+#include "aero_hardware_interface/BusWorkerPool.hh"
+#include "aero_hardware_interface/TelemetryScheduler.hh"
 
 #include <mutex>
 
@@ -138,6 +143,17 @@ public:
   void writeWheel(const std::vector< std::string> &_names, const std::vector<int16_t> &_vel, double _tm_sec);
   void startWheelServo();
   void stopWheelServo();
+  /// poll telemetry in idle bus time, called on bus thread after motion frames
+  void pollTelemetry(AeroControllerProto& _controller,
+                     TelemetryScheduler& _scheduler,
+                     std::vector<int16_t>& _current,
+                     std::vector<int16_t>& _temperature);
+  void publishTelemetry(const ros::Time& time);
+  /// stroke velocities [stroke/s] of one bus from the actual strokes of
+  /// _state and _prev over the time between their publishes
+  void updateStrokeVelocities(bool _ok, const StrokeState& _state,
+                              size_t _strokes, StrokeState& _prev,
+                              double* _velocities);
 
   void handScript(uint16_t _sendnum, uint16_t _script) {
     mutex_upper_.lock();
@@ -198,15 +214,55 @@ protected:
 
   std::vector<double> prev_ref_positions_;
 
+  // snapshots of each bus the stroke velocities are from (seq 0 if none)
+  StrokeState prev_upper_state_;
+  StrokeState prev_lower_state_;
+
+  // whole body stroke velocities [stroke/s] for joint velocities
+  std::vector<double> act_stroke_velocities_;
+
   boost::shared_ptr<AeroUpperController > controller_upper_;
   boost::shared_ptr<AeroLowerController > controller_lower_;
 
+  // conversion tables loaded at runtime, generated functions if null
+  boost::shared_ptr<ConversionTables> tables_;
+
+  // one thread per bus to access upper and lower in parallel
+  BusWorkerPool bus_workers_;
+
+  // last state read from each controller in readPos
+  StrokeState upper_state_;
+  StrokeState lower_state_;
+
   bool initialized_flag_;
   bool upper_send_enable_;
 
   int   CONTROL_PERIOD_US_;
   float OVERLAP_SCALE_;
   int   BASE_COMMAND_PERIOD_MS_;
+  // use position returned by set_position as next read, skipping CMD_GET_POS
+  bool  FUSED_CYCLE_;
+
+  // true if last write stored the returned position of each bus
+  bool upper_position_replied_;
+  bool lower_position_replied_;
+
+  // rate of current, temperature and misstep polling, 0 to disable
+  double TELEMETRY_RATE_;
+
+  // fill idle bus time of each period with telemetry requests
+  boost::shared_ptr<TelemetryScheduler> upper_telemetry_;
+  boost::shared_ptr<TelemetryScheduler> lower_telemetry_;
+
+  std::vector<int16_t> upper_current_;
+  std::vector<int16_t> lower_current_;
+  std::vector<int16_t> upper_temperature_;
+  std::vector<int16_t> lower_temperature_;
+
+  ros::Publisher current_pub_;
+  ros::Publisher temperature_pub_;
+  ros::Publisher utilization_pub_;
+  ros::Time last_telemetry_pub_;
 
   std::mutex mutex_lower_;
   std::mutex mutex_upper_;
@@ -20,6 +20,7 @@ AeroUpperController::AeroUpperController(const std::string& _port) :
   get_command(CMD_GET_POS, stroke_cur_vector_);
   stroke_ref_vector_.assign(stroke_cur_vector_.begin(),
                             stroke_cur_vector_.end());
+  publish_state_();
 }
 
 //////////////////////////////////////////////////
@@ -32,8 +33,7 @@ void AeroUpperController::util_servo_on()
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
 
-  std::vector<uint8_t> dat;
-  dat.resize(8);
+  SeedFrame dat(SHORT_DATA_LENGTH);
   dat[0] = 0xfd;  // header
   dat[1] = 0xdf;  // header
   dat[2] = 0x04;  // data length
@@ -50,8 +50,7 @@ void AeroUpperController::util_servo_off()
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
 
-  std::vector<uint8_t> dat;
-  dat.resize(8);
+  SeedFrame dat(SHORT_DATA_LENGTH);
   dat[0] = 0xfd;  // header
   dat[1] = 0xdf;  // header
   dat[2] = 0x04;  // data length
@@ -93,6 +92,7 @@ AeroLowerController::AeroLowerController(const std::string& _port) :
   get_command(CMD_GET_POS, stroke_cur_vector_);
   stroke_ref_vector_.assign(stroke_cur_vector_.begin(),
                             stroke_cur_vector_.end());
+  publish_state_();
 }
 
 //////////////////////////////////////////////////
@@ -129,10 +129,12 @@ void AeroLowerController::servo_command(int16_t _d0, int16_t _d1)
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
 
-  std::vector<int16_t> stroke_vector(stroke_joint_indices_.size(), _d0);
-  std::vector<uint8_t> dat(RAW_DATA_LENGTH);
+  SeedFrame dat;
 
-  stroke_to_raw_(stroke_vector, dat);
+  // keep this block without braces, make_controller.sh cuts at the first brace
+  for (size_t i = 0; i < stroke_joint_indices_.size(); ++i)
+    encode_short_(_d0, &dat[RAW_HEADER_OFFSET +
+                            stroke_joint_indices_[i].raw_index * 2]);
 
   // adding code
 
@@ -145,7 +147,7 @@ void AeroLowerController::set_wheel_velocity(
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
 
-  std::vector<uint8_t> dat(RAW_DATA_LENGTH);
+  SeedFrame dat;
 
   // use previous reference strokes to keep its positions
   stroke_to_raw_(stroke_ref_vector_, dat);
@@ -160,8 +162,7 @@ void AeroLowerController::set_wheel_velocity(
 
   // MoveAbs returns current stroke
   // MOVE_SPD also returns data, it is different behavior from Aero Command List ???
-  std::vector<uint8_t> dummy;
-  dummy.resize(RAW_DATA_LENGTH);
+  SeedFrame dummy;
   seed_.read(dummy);
 }
 
@@ -5,33 +5,57 @@ namespace aero
 
     float TableTemplate (float _angle)
     {
+      const int size =
+        static_cast<int>(sizeof(TableTemplateData) / sizeof(A2SData));
+      // out of table, saturate at the stroke of the edge entry
+      _angle = std::min(std::max(_angle,
+          static_cast<float>(ArrayTableTemplateOffset)),
+          static_cast<float>(ArrayTableTemplateOffset + size - 1));
       int roundedAngle = static_cast<int>(_angle);
-      if (_angle > roundedAngle + 0.001) ++roundedAngle;
+      roundedAngle += (_angle > roundedAngle + 0.001);
       int roundedAngleIndex = roundedAngle - ArrayTableTemplateOffset;
-      auto ref = TableTemplateMap.at(roundedAngleIndex);
-      float stroke = ref.first;
-      float interval = ref.second;
+      if(size - 1 < roundedAngleIndex) roundedAngleIndex = size - 1;
+      if(roundedAngleIndex < 0) roundedAngleIndex = 0;
+      roundedAngle = roundedAngleIndex + ArrayTableTemplateOffset;
+      const A2SData& ref = TableTemplateData[roundedAngleIndex];
 
-      return stroke - (roundedAngle - _angle) * interval;
+      return ref.stroke - (roundedAngle - _angle) * ref.interval;
     };
 
     dualJoint TableTemplate (float _angle1, float _angle2)
     {
+      const int size1 =
+        static_cast<int>(sizeof(TableTemplateData1) / sizeof(A2SData));
+      const int size2 =
+        static_cast<int>(sizeof(TableTemplateData2) / sizeof(A2SData));
+
+      // out of table, saturate at the strokes of the edge entries
+      _angle1 = std::min(std::max(_angle1,
+          static_cast<float>(ArrayTableTemplateOffset1)),
+          static_cast<float>(ArrayTableTemplateOffset1 + size1 - 1));
+      _angle2 = std::min(std::max(_angle2,
+          static_cast<float>(ArrayTableTemplateOffset2)),
+          static_cast<float>(ArrayTableTemplateOffset2 + size2 - 1));
+
       int roundedAngle1 = static_cast<int>(_angle1);
-      if (_angle1 > roundedAngle1 + 0.001) ++roundedAngle1;
+      roundedAngle1 += (_angle1 > roundedAngle1 + 0.001);
 
       int roundedAngle2 = static_cast<int>(_angle2);
-      if (_angle2 > roundedAngle2 + 0.001) ++roundedAngle2;
+      roundedAngle2 += (_angle2 > roundedAngle2 + 0.001);
 
       int roundedAngleIndex1 = roundedAngle1 - ArrayTableTemplateOffset1;
       int roundedAngleIndex2 = roundedAngle2 - ArrayTableTemplateOffset2;
-      auto ref1 = TableTemplateMap1.at(roundedAngleIndex1);
-      auto ref2 = TableTemplateMap2.at(roundedAngleIndex2);
-      float stroke1 = ref1.first, stroke2 = ref2.first;
-      float interval1 = ref1.second, interval2 = ref2.second;
+      if(size1 - 1 < roundedAngleIndex1) roundedAngleIndex1 = size1 - 1;
+      if(roundedAngleIndex1 < 0) roundedAngleIndex1 = 0;
+      if(size2 - 1 < roundedAngleIndex2) roundedAngleIndex2 = size2 - 1;
+      if(roundedAngleIndex2 < 0) roundedAngleIndex2 = 0;
+      roundedAngle1 = roundedAngleIndex1 + ArrayTableTemplateOffset1;
+      roundedAngle2 = roundedAngleIndex2 + ArrayTableTemplateOffset2;
+      const A2SData& ref1 = TableTemplateData1[roundedAngleIndex1];
+      const A2SData& ref2 = TableTemplateData2[roundedAngleIndex2];
 
-      stroke1 -= (roundedAngle1 - _angle1) * interval1;
-      stroke2 -= (roundedAngle2 - _angle2) * interval2;
+      float stroke1 = ref1.stroke - (roundedAngle1 - _angle1) * ref1.interval;
+      float stroke2 = ref2.stroke - (roundedAngle2 - _angle2) * ref2.interval;
 
       return {stroke2 + stroke1, stroke2 - stroke1} ;
     };
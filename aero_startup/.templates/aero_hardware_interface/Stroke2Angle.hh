@@ -5,69 +5,46 @@ namespace aero
 
     float TableTemplate (float _stroke)
     {
+      const int buckets =
+        static_cast<int>(sizeof(TableTemplateBuckets) / sizeof(S2ABucket));
       int roundedStroke = static_cast<int>(_stroke);
       int roundedStrokeIndex = roundedStroke - ArrayTableTemplateOffset;
-      if(static_cast<int>(TableTemplateCandidates.size() - 1) < roundedStrokeIndex) roundedStrokeIndex = static_cast<int>(TableTemplateCandidates.size() - 1); 
+      if(buckets - 1 < roundedStrokeIndex) roundedStrokeIndex = buckets - 1;
       if(roundedStrokeIndex < 0) roundedStrokeIndex = 0;
-      auto ref = TableTemplateCandidates.at(roundedStrokeIndex);
-      std::vector<S2AData> candidates = ref.first;
-      std::vector<S2AData> appendix = ref.second;
-
-      if (_stroke < 0) {
-        if (candidates.size() >= 2)
-          if (candidates[0].stroke < candidates[1].stroke)
-            std::reverse(candidates.begin(), candidates.end());
-
-        for (unsigned int i = 0; i < candidates.size(); ++i)
-          if (_stroke >= candidates[i].stroke)
-            if (candidates[i].range == 0)
-              return candidates[i].angle;
-            else
-              return candidates[i].angle
-                - (candidates[i].stroke - _stroke) / candidates[i].range;
-
-        if (appendix.size() >= 2)
-          if (appendix[0].stroke < appendix[1].stroke)
-            std::reverse(appendix.begin(), appendix.end());
-
-        if (appendix.size() == 0) {
-          return candidates[candidates.size() - 1].angle;
-        } else {
-          if (appendix[0].range == 0)
-            return appendix[0].angle;
+      const S2ABucket& ref = TableTemplateBuckets[roundedStrokeIndex];
+      const S2AData* candidates = TableTemplateData + ref.candidates;
+      const S2AData* appendix = TableTemplateData + ref.appendix;
+      int size = ref.candidates_size;
+      int appendixSize = ref.appendix_size;
+
+      // search from smaller |stroke|,
+      // descending tables are read backwards instead of reversed
+      bool negative = (_stroke < 0);
+      bool reversed = (size >= 2) &&
+        (negative ? (candidates[0].stroke < candidates[1].stroke)
+         : (candidates[0].stroke > candidates[1].stroke));
+
+      for (int k = 0; k < size; ++k) {
+        const S2AData& c = candidates[reversed ? size - 1 - k : k];
+        if (negative ? (_stroke >= c.stroke) : (_stroke <= c.stroke)) {
+          if (c.range == 0)
+            return c.angle;
           else
-            return appendix[0].angle
-              - (appendix[0].stroke - _stroke) / appendix[0].range;
+            return c.angle - (c.stroke - _stroke) / c.range;
         }
       }
 
-      else {
-        if (candidates.size() >= 2)
-          if (candidates[0].stroke > candidates[1].stroke)
-            std::reverse(candidates.begin(), candidates.end());
-
-        for (unsigned int i = 0; i < candidates.size(); ++i)
-          if (_stroke <= candidates[i].stroke)
-            if (candidates[i].range == 0)
-              return candidates[i].angle;
-            else
-              return candidates[i].angle
-                - (candidates[i].stroke - _stroke) / candidates[i].range;
-
-        if (appendix.size() >= 2)
-          if (appendix[0].stroke > appendix[1].stroke)
-            std::reverse(appendix.begin(), appendix.end());
-
-        if (appendix.size() == 0) {
-          return candidates[candidates.size() - 1].angle;
-        } else {
-          if (appendix[0].range == 0)
-            return appendix[0].angle;
-          else
-            return appendix[0].angle
-              - (appendix[0].stroke - _stroke) / appendix[0].range;
-        }
-      }
+      if (appendixSize == 0)
+        return candidates[reversed ? 0 : size - 1].angle;
+
+      bool appendixReversed = (appendixSize >= 2) &&
+        (negative ? (appendix[0].stroke < appendix[1].stroke)
+         : (appendix[0].stroke > appendix[1].stroke));
+      const S2AData& a = appendix[appendixReversed ? appendixSize - 1 : 0];
+      if (a.range == 0)
+        return a.angle;
+      else
+        return a.angle - (a.stroke - _stroke) / a.range;
     };
 
   }
@@ -9,7 +9,21 @@ AeroControllerNode::AeroControllerNode(const ros::NodeHandle& _nh,
                                        const std::string& _port_lower) :
   nh_(_nh), upper_(_port_upper), lower_(_port_lower), wheel_spinner_(1, &wheel_queue_),
   jointtraj_spinner_(1, &jointtraj_queue_),
-  speed_overwrite_spinner_(1, &speed_overwrite_queue_)
+  speed_overwrite_spinner_(1, &speed_overwrite_queue_),
+  // 10 csec frames, 10 csec longer so strokes do not stop between frames
+  upper_scheduler_(AERO_DOF_UPPER, 10, 10,
+                   [this](const std::vector<int16_t>& _strokes, uint16_t _csec) {
+                     std::vector<int16_t> strokes(_strokes);
+                     upper_bus_.call(PRIORITY_MOTION, [&](){
+                         upper_.set_position(strokes, _csec); });
+                   },
+                   [this]() { return CollisionAbort(); }),
+  lower_scheduler_(AERO_DOF_LOWER, 10, 10,
+                   [this](const std::vector<int16_t>& _strokes, uint16_t _csec) {
+                     std::vector<int16_t> strokes(_strokes);
+                     lower_bus_.call(PRIORITY_MOTION, [&](){
+                         lower_.set_position(strokes, _csec); });
+                   })
 {
   ROS_INFO("starting aero_hardware_interface");
 
@@ -30,6 +44,12 @@ AeroControllerNode::AeroControllerNode(const ros::NodeHandle& _nh,
   in_action_pub_ =
     nh_.advertise<std_msgs::Bool>("in_action", 10);
 
+  ROS_INFO(" create preemption latency publisher");
+  preemption_latency_pub_ =
+    nh_.advertise<std_msgs::Float32>("preemption_latency", 10);
+  upper_measured_ = 0;
+  lower_measured_ = 0;
+
   // ROS_INFO(" create cmdvel sub");
   // cmdvel_sub_ =
   //     nh_.subscribe(
@@ -48,6 +68,26 @@ AeroControllerNode::AeroControllerNode(const ros::NodeHandle& _nh,
          ros::VoidPtr(),
          &jointtraj_queue_);
   jointtraj_sub_ = nh_.subscribe(jointtraj_ops_);
+
+  // streamed upper trajectories, appended to running ones
+  ROS_INFO(" create command stream sub");
+  double stream_lookahead = 0.1, stream_timeout = 1.0;
+  nh_.param<double> ("stream_lookahead", stream_lookahead, 0.1);
+  nh_.param<double> ("stream_timeout", stream_timeout, 1.0);
+  stream_lookahead_usec_ = static_cast<int64_t>(stream_lookahead * 1e6);
+  stream_timeout_usec_ = static_cast<int64_t>(stream_timeout * 1e6);
+  stream_underruns_ = 0;
+  stream_latency_pub_ =
+    nh_.advertise<std_msgs::Float32>("stream_latency", 10);
+  jointtraj_stream_ops_ =
+    ros::SubscribeOptions::create<trajectory_msgs::JointTrajectory>(
+         "command_stream",
+         100,
+         boost::bind(&AeroControllerNode::JointTrajectoryStreamCallback,
+                     this, _1),
+         ros::VoidPtr(),
+         &jointtraj_queue_);
+  jointtraj_stream_sub_ = nh_.subscribe(jointtraj_stream_ops_);
   jointtraj_spinner_.start();
 
   // asynchronous speed overwrite command during trajectory run
@@ -142,6 +182,41 @@ AeroControllerNode::AeroControllerNode(const ros::NodeHandle& _nh,
           this);
   collision_abort_mode_ = 0;
 
+  std::string tables_dir, tables_cache;
+  nh_.param<std::string> ("conversion_tables", tables_dir, "");
+  nh_.param<std::string> ("conversion_tables_cache", tables_cache, "");
+  if (!tables_dir.empty()) {
+    ROS_INFO(" load conversion tables");
+    std::shared_ptr<common::ConversionTables> tables(
+        new common::ConversionTables());
+    std::vector<std::string> names(upper_.get_number_of_angle_joints()
+                                   + lower_.get_number_of_angle_joints());
+    common::AngleJointNames(names);
+    // strokes and joints must be those of the built controllers
+    if (tables->load(tables_dir, tables_cache) &&
+        tables->angle_joint_names() == names &&
+        tables->number_of_strokes() == AERO_DOF) {
+      tables_ = tables;
+      ROS_INFO(" using tables of %s%s", tables_dir.c_str(),
+               tables->from_cache() ? " (cached)" : "");
+    } else {
+      ROS_WARN(" tables of %s do not match, using generated conversion",
+               tables_dir.c_str());
+    }
+  }
+
+  // samples of interpolation curves, 0 evaluates curves directly
+  nh_.param<int> ("interpolation_table_size", interpolation_table_size_, 0);
+  // fit splines through upper trajectories instead of per point curves
+  nh_.param<bool> ("spline_trajectory", spline_trajectory_, false);
+  // time to blend from a running trajectory to one taking its joints,
+  // upper trajectories switch at once unless set
+  double upper_blend_window = 0.0, lower_blend_window = 0.2;
+  nh_.param<double> ("upper_blend_window", upper_blend_window, 0.0);
+  nh_.param<double> ("lower_blend_window", lower_blend_window, 0.2);
+  upper_scheduler_.set_blend(static_cast<int64_t>(upper_blend_window * 1e6));
+  lower_scheduler_.set_blend(static_cast<int64_t>(lower_blend_window * 1e6));
+
   bool get_state = true;
   nh_.param<bool> ("get_state", get_state, true);
 
@@ -160,11 +235,8 @@ AeroControllerNode::AeroControllerNode(const ros::NodeHandle& _nh,
     nh_.createTimer(ros::Duration(0.02),
                     &AeroControllerNode::PublishInAction, this);
 
-  global_thread_cnt_ = 0;
   send_joints_status_ = false;
 
-  lower_killed_thread_info_ = {{}, {}, 1, 0, 0, 1.0f};
-
   ROS_INFO(" done");
 }
 
@@ -173,6 +245,36 @@ AeroControllerNode::~AeroControllerNode()
 {
 }
 
+//////////////////////////////////////////////////
+void AeroControllerNode::Angle2Stroke(std::vector<int16_t>& _strokes,
+                                      const std::vector<double>& _angles)
+{
+  if (tables_)
+    tables_->Angle2Stroke(_strokes, _angles);
+  else
+    common::Angle2Stroke(_strokes, _angles);
+}
+
+//////////////////////////////////////////////////
+void AeroControllerNode::UnusedAngle2Stroke(std::vector<int16_t>& _strokes,
+                                            const std::vector<bool>& _angles)
+{
+  if (tables_)
+    tables_->UnusedAngle2Stroke(_strokes, _angles);
+  else
+    common::UnusedAngle2Stroke(_strokes, _angles);
+}
+
+//////////////////////////////////////////////////
+void AeroControllerNode::Stroke2Angle(std::vector<double>& _angles,
+                                      const std::vector<int16_t>& _strokes)
+{
+  if (tables_)
+    tables_->Stroke2Angle(_angles, _strokes);
+  else
+    common::Stroke2Angle(_angles, _strokes);
+}
+
 //////////////////////////////////////////////////
 // void AeroControllerNode::GoVelocityCallback(
 //     const geometry_msgs::Twist::ConstPtr& _msg)
@@ -183,262 +285,17 @@ AeroControllerNode::~AeroControllerNode()
 // }
 
 //////////////////////////////////////////////////
-void AeroControllerNode::JointTrajectoryThread(
-    std::vector<aero::interpolation::InterpolationPtr> _interpolation,
-    std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory,
-    int _trajectory_start_from,
-    int _split_start_from, float _factor)
+bool AeroControllerNode::CollisionAbort()
 {
-  ROS_INFO("starting upper joint trajectory thread");
-  auto start_time = aero::time::now();
-
-  uint16_t csec_per_frame = 10; // 10 fps
-  uint this_id;
-
-  // register current thread
-  mtx_threads_.lock();
-  std::vector<int> joints;
-  for (size_t i = 0; i < _stroke_trajectory[0].first.size(); ++i)
-    if (_stroke_trajectory[0].first.at(i) != 0x7fff)
-      joints.push_back(static_cast<int>(i));
-  registered_threads_.push_back({global_thread_cnt_, joints, false});
-  this_id = global_thread_cnt_++;
-  mtx_threads_.unlock();
-
-  // main process starts here
-
-  ROS_INFO("upper joint trajectory thread: starting!");
-
-  for (auto it = _stroke_trajectory.begin() + _trajectory_start_from;
-       it != _stroke_trajectory.end(); ++it) {
-    // check if any kill signal was provided to current thread
-    mtx_threads_.lock();
-    for (auto th = registered_threads_.begin(); th != registered_threads_.end(); ++th)
-      if (th->id == this_id) {
-        if (th->kill) {
-          // save info of killing thread
-          mtx_thread_graveyard_.lock();
-          thread_graveyard_.push_back({_stroke_trajectory, _interpolation,
-                static_cast<int>(it - _stroke_trajectory.begin()), 1, this_id, _factor});
-          mtx_thread_graveyard_.unlock();
-          // remove this thread info
-          registered_threads_.erase(th);
-          mtx_threads_.unlock();
-          ROS_WARN("upper joint trajectory thread: detected kill signal during trajectory!");
-          return;
-        }
-        break;
-      }
-    mtx_threads_.unlock();
-
-    // check if any collision happened during send trajectory
-    mtx_upper_.lock();
-    bool collision_status = upper_.get_status();
-    mtx_upper_.unlock();
-    if (collision_status && collision_abort_mode_ != 0) {
-      ROS_ERROR("upper joint trajectory thread: abort trajectory collision!");
-      if (collision_abort_mode_ == 1) {
-        mtx_upper_.lock();
-        upper_.reset_status();
-        mtx_upper_.unlock();
-      }
-      break;
-    }
-
-    int k = static_cast<int>(it - _stroke_trajectory.begin());
-    // from here, main process for trajectory it
-    // any movement faster than 100ms(10cs) will not interpolate = linear
-    if (it->second - (it-1)->second < 10
-        || _interpolation.at(k)->is(aero::interpolation::i_constant)
-        ) {
-      // check if elapsed time should be considered
-      int elapsed_csec = _split_start_from;
-      int runtime_csec;
-      if (elapsed_csec >= csec_per_frame)
-        runtime_csec = std::max(static_cast<int>(csec_per_frame), it->second - (it-1)->second + 5 + 1 - elapsed_csec); // skip elapsed time
-      else
-        runtime_csec = it->second - (it-1)->second + 5 + 1; // 5 csec(50[ms]) is to synchronize upper and lower and 1csec to smoothing trajectory
-      mtx_upper_.lock();
-      upper_.set_position(it->first, runtime_csec);
-      mtx_upper_.unlock();
-
-      // check for kill every csec_per_frame
-      int runtime_msec = (runtime_csec - 2) * 10;
-      int loops = runtime_msec / static_cast<int32_t>(csec_per_frame * 10);
-      int remain_msec = runtime_msec - loops * static_cast<int32_t>(csec_per_frame * 10);
-      if (loops > 0) {
-        for (int loop_count = 0; loop_count < loops; ++loop_count) {
-          // check if any kill signal was provided to current thread
-          mtx_threads_.lock();
-          for (auto th = registered_threads_.begin();
-               th != registered_threads_.end(); ++th)
-            if (th->id == this_id) {
-              if (th->kill) {
-                // save info of killing thread
-                mtx_thread_graveyard_.lock();
-                thread_graveyard_.push_back({_stroke_trajectory, _interpolation, k, loop_count * csec_per_frame + elapsed_csec, this_id, _factor});
-                mtx_thread_graveyard_.unlock();
-                // remove this thread info
-                registered_threads_.erase(th);
-                mtx_threads_.unlock();
-                ROS_WARN("upper joint trajectory thread: detected kill signal during command!");
-                return;
-              }
-              break;
-            }
-          mtx_threads_.unlock();
-          usleep(static_cast<int32_t>(csec_per_frame) * 10 * 1000);
-        }
-      }
-      if (remain_msec > 0)
-        usleep(remain_msec * 1000);
-      _split_start_from = 0;
-      continue;
-    }
-    // find number of splits in this trajectory
-    // time becomes slightly faster if not cleanly dividable
-    int splits = static_cast<int>((it->second - (it-1)->second) / csec_per_frame);
-    // send splitted stroke
-    for (size_t j = _split_start_from; j <= splits; ++j) {
-      // check if any kill signal was provided to current thread
-      mtx_threads_.lock();
-      for (auto th = registered_threads_.begin();
-           th != registered_threads_.end(); ++th)
-        if (th->id == this_id) {
-          if (th->kill) {
-            // save info of killing thread
-            mtx_thread_graveyard_.lock();
-            thread_graveyard_.push_back({_stroke_trajectory,
-                  _interpolation, k, static_cast<int>(j), this_id, _factor});
-            mtx_thread_graveyard_.unlock();
-            // remove this thread info
-            registered_threads_.erase(th);
-            mtx_threads_.unlock();
-            ROS_WARN("upper joint trajectory thread: detected kill signal during interpolation!");
-            return;
-          }
-          break;
-        }
-      mtx_threads_.unlock();
-
-      // from here, main process for split j
-      float t_param = _interpolation.at(k)->interpolate(
-          static_cast<float>(j) / splits);
-      if(j == splits) t_param = 1.0;
-      // calculate stroke in this split
-      std::vector<int16_t> stroke(it->first.size(), 0x7fff);
-      for (size_t i = 0; i < it->first.size(); ++i) {
-        if (it->first[i] == 0x7fff) continue; // skip non-send joints
-        stroke[i] =
-          (1 - t_param) * (it - 1)->first[i] + t_param * it->first[i];
-      }
-      // slightly longer time added for trajectory smoothness
-      mtx_upper_.lock();
-      upper_.set_position(stroke, csec_per_frame + 10);
-      mtx_upper_.unlock();
-      // 20ms sleep in set_position, subtract
-      if(j != splits) {
-        usleep(static_cast<int32_t>(csec_per_frame) * 10 * 1000 - 20000);
-      } else {// total time - used time
-        usleep(static_cast<int32_t>(it->second - (it-1)->second - (splits - 1) * csec_per_frame) * 10 * 1000 - 20000);
-      }
-    } // splits
-    _split_start_from = 1;
-  } // _stroke_trajectory
-
-  // remove finished thread
-  mtx_threads_.lock();
-  for (auto th = registered_threads_.begin(); th != registered_threads_.end(); ++th)
-    if (th->id == this_id) {
-      registered_threads_.erase(th);
-      break;
-    }
-  mtx_threads_.unlock();
-
-  ROS_INFO("finished upper joint trajectory thread %f",
-           aero::time::ms(aero::time::now() - start_time));
-}
-
-/////////////////////////////////////////////////
-void AeroControllerNode::LowerTrajectoryThread(
-    std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory)
-{
-  ROS_INFO("starting lower joint trajectory thread");
-  auto start_time = aero::time::now();
-
-  int csec_per_frame = 10;
-
-  mtx_lower_thread_.lock();
-  int traj_start_from = lower_killed_thread_info_.at_trajectory_num;
-  if (traj_start_from >= _stroke_trajectory.size()) {
-    lower_thread_.id = 0; // bad command, finish thread
-    mtx_lower_thread_.unlock();
-    ROS_WARN("bad lower trajectory detected! trajectory size is 0?");
-    return;
-  }
-  mtx_lower_thread_.unlock();
-
-  for (auto it = _stroke_trajectory.begin() + traj_start_from;
-       it != _stroke_trajectory.end(); ++it) {
-    // check for kill every csec_per_frame
-    mtx_lower_thread_.lock();
-    int elapsed_csec = lower_killed_thread_info_.at_split_num;
-    lower_killed_thread_info_.at_split_num = 0; // set for next frame
-    uint16_t csec_in_frame =
-      it->second - (it-1)->second - static_cast<uint16_t>(elapsed_csec);
-    // 20ms sleep in set_position, subtract
-    int msec_in_frame = static_cast<int>(csec_in_frame - 2) * 10;
-    int loops = msec_in_frame / (csec_per_frame * 10);
-    int remain_msec = msec_in_frame - loops * csec_per_frame * 10;
-
-    // check for kill signal
-    if (lower_thread_.kill) {
-      ROS_WARN("lower joint trajectory thread: detected kill signal one!");
-      lower_killed_thread_info_.trajectories = _stroke_trajectory;
-      lower_killed_thread_info_.at_trajectory_num =
-        static_cast<int>(it - _stroke_trajectory.begin());
-      lower_killed_thread_info_.at_split_num = elapsed_csec;
-      lower_thread_.kill = false;
-      mtx_lower_thread_.unlock();
-      return;
-    }
-    mtx_lower_thread_.unlock();
-
-    // send
-    mtx_lower_.lock();
-    lower_.set_position(it->first, csec_in_frame  + 10);
-    mtx_lower_.unlock();
- 
-    // check for kill during send
-    for (int loop_count = 0; loop_count < loops; ++loop_count) {
-      // check for kill signal
-      mtx_lower_thread_.lock();
-      if (lower_thread_.kill) {
-        ROS_WARN("lower joint trajectory thread: detected kill signal two!");
-        lower_killed_thread_info_.trajectories = _stroke_trajectory;
-        lower_killed_thread_info_.at_trajectory_num =
-          static_cast<int>(it - _stroke_trajectory.begin());
-        lower_killed_thread_info_.at_split_num =
-          loop_count * csec_per_frame + elapsed_csec;
-        lower_thread_.kill = false;
-        mtx_lower_thread_.unlock();
-        return;
-      }
-      mtx_lower_thread_.unlock();
-      usleep(csec_per_frame * 10 * 1000);
-    }
-
-    if (remain_msec > 0)
-      usleep(remain_msec * 1000);
-  }
-
-  mtx_lower_thread_.lock();
-  lower_thread_.id = 0; // thread finish
-  lower_killed_thread_info_ = {{}, {}, 1, 0, 0, 1.0f};
-  mtx_lower_thread_.unlock();
+  // check if any collision happened during send trajectory
+  bool collision_status = upper_.get_status();
+  if (!collision_status || collision_abort_mode_ == 0)
+    return false;
 
-  ROS_INFO("finished lower joint trajectory thread %f",
-           aero::time::ms(aero::time::now() - start_time));
+  ROS_ERROR("upper joint trajectory: abort trajectory collision!");
+  if (collision_abort_mode_ == 1)
+    upper_bus_.call(PRIORITY_CONFIG, [this](){ upper_.reset_status(); });
+  return true;
 }
 
 //////////////////////////////////////////////////
@@ -447,17 +304,12 @@ void AeroControllerNode::JointTrajectoryCallback(
 {
   ROS_INFO("----start joint trajectory callback----");
 
-  mtx_upper_.lock();
-  mtx_lower_.lock();
-
   int number_of_angle_joints =
       upper_.get_number_of_angle_joints() +
       lower_.get_number_of_angle_joints();
 
   if (_msg->joint_names.size() > number_of_angle_joints) {
     // invalid number of joints from _msg
-    mtx_upper_.unlock();
-    mtx_lower_.unlock();
     ROS_ERROR("----too many joints, finishing up----");
     return;
   }
@@ -496,8 +348,6 @@ void AeroControllerNode::JointTrajectoryCallback(
     }
 
     if (id_in_msg_to_ordered_id[i] < 0) {
-      mtx_upper_.unlock();
-      mtx_lower_.unlock();
       ROS_ERROR("----found bad joint name, finishing up----");
       return; // invalid name
     }
@@ -510,117 +360,87 @@ void AeroControllerNode::JointTrajectoryCallback(
 
   // initiate trajectories
 
-  std::vector<std::pair<std::vector<int16_t>, uint16_t> > upper_stroke_trajectory;
-  std::vector<std::pair<std::vector<int16_t>, uint16_t> > lower_stroke_trajectory;
+  aero::interpolation::StrokeTimeline upper_stroke_trajectory(AERO_DOF_UPPER);
+  aero::interpolation::StrokeTimeline lower_stroke_trajectory(AERO_DOF_LOWER);
+  // the current position and all points in one allocation
+  upper_stroke_trajectory.reserve(_msg->points.size() + 1);
+  lower_stroke_trajectory.reserve(_msg->points.size() + 1);
 
   // note: only upper will have interpolation
   if (upper_count > 0) {
-    upper_stroke_trajectory.reserve(_msg->points.size() + 1);
     // get current stroke values, use reference for safety
     std::vector<int16_t> ref_strokes = upper_.get_reference_stroke_vector();
     // fill in unused joints to no-send
-    common::UnusedAngle2Stroke(ref_strokes, send_true);
-    upper_stroke_trajectory.push_back({ref_strokes, 0});
+    UnusedAngle2Stroke(ref_strokes, send_true);
+    upper_stroke_trajectory.push_back(ref_strokes, 0);
   }
 
   if (lower_count > 0) {
-    lower_stroke_trajectory.reserve(_msg->points.size() + 1);
     // get current stroke values, use reference for safety
     std::vector<int16_t> ref_strokes = lower_.get_reference_stroke_vector();
-    lower_stroke_trajectory.push_back({ref_strokes, 0});
+    lower_stroke_trajectory.push_back(ref_strokes, 0);
   }
 
   ROS_INFO("----parse msg----");
 
   // from here, get ready to handle the _msg positions
 
-  // this is a tmp variable that is reused
-  std::vector<double> ordered_positions(number_of_angle_joints);
-
-  // for each trajectory points,
-  for (size_t i = 0; i < _msg->points.size(); ++i) {
-    std::fill(ordered_positions.begin(), ordered_positions.end(), 0.0);
-
-    // check for cancelling joints (NaN values)
-    std::vector<bool> send_true_with_cancel;
-    send_true_with_cancel.assign(send_true.begin(), send_true.end());
-
+  // angles of all points, unused joints are 0
+  size_t number_of_points = _msg->points.size();
+  std::vector<double> angles(number_of_points * number_of_angle_joints, 0.0);
+  for (size_t i = 0; i < number_of_points; ++i) {
+    double* ordered_positions = angles.data() + i * number_of_angle_joints;
     for (size_t j = 0; j < _msg->points[i].positions.size(); ++j)
-      if (!std::isnan(_msg->points[i].positions[j]))
-        ordered_positions[id_in_msg_to_ordered_id[j]] =
-          _msg->points[i].positions[j];
-      else
-        send_true_with_cancel[id_in_msg_to_ordered_id[j]] = false;
-
-    std::vector<int16_t> strokes(AERO_DOF);
-    common::Angle2Stroke(strokes, ordered_positions);
+      ordered_positions[id_in_msg_to_ordered_id[j]] =
+        _msg->points[i].positions[j];
+  }
 
-    // fill in unused joints to no-send
-    common::UnusedAngle2Stroke(strokes, send_true_with_cancel);
+  // convert all points at once, cancelling joints (NaN values) and
+  // unused joints are filled in to no-send
+  std::vector<int16_t> upper_strokes;
+  std::vector<int16_t> lower_strokes;
+  common::Angle2StrokeBatch(angles, send_true, upper_strokes, lower_strokes,
+                            tables_.get());
 
-    // split strokes into upper and lower
-    std::vector<int16_t> upper_stroke_vector(
-        strokes.begin(), strokes.begin() + AERO_DOF_UPPER);
-    std::vector<int16_t> lower_stroke_vector(
-        strokes.begin() + AERO_DOF_UPPER, strokes.end());
+  // for each trajectory points,
+  for (size_t i = 0; i < number_of_points; ++i) {
+    const int16_t* upper_stroke_row = upper_strokes.data() + i * AERO_DOF_UPPER;
+    const int16_t* lower_stroke_row = lower_strokes.data() + i * AERO_DOF_LOWER;
 
-    double time_sec = _msg->points[i].time_from_start.toSec();
-    uint16_t time_csec = static_cast<uint16_t>(time_sec * 100.0);
+    int64_t time_usec = _msg->points[i].time_from_start.toNSec() / 1000;
 
-    if (upper_count > 0) {
-      upper_stroke_trajectory.push_back({upper_stroke_vector, time_csec});
-    }
+    if (upper_count > 0)
+      upper_stroke_trajectory.push_back(upper_stroke_row, time_usec);
 
     if (lower_count > 0 && _msg->points.size() > 1) {
-      lower_stroke_trajectory.push_back({lower_stroke_vector, time_csec});
+      lower_stroke_trajectory.push_back(lower_stroke_row, time_usec);
     } else if (lower_count > 0 && i == 0) { // to be removed in future
       bool servo_off = false;
       // if cancel in any of the joints, cancel movement with servo on
-      for (auto l = lower_stroke_vector.begin();
-           l != lower_stroke_vector.end(); ++l) {
+      for (const int16_t* l = lower_stroke_row;
+           l != lower_stroke_row + AERO_DOF_LOWER; ++l) {
         if (*l == 0x7fff) {
           servo_off = true;
           break;
         }
       }
       if (servo_off) {
-        // kill if trajectory is running
-        mtx_lower_thread_.lock();
-        if (lower_thread_.id == 1) // trajectory is running
-          lower_thread_.kill = true;
-        mtx_lower_thread_.unlock();
-        // cancel lower movement
-        lower_.servo_on();
-        mtx_lower_thread_.lock();
-        lower_thread_.id = 0;
-        lower_killed_thread_info_ = {{}, {}, 1, 0, 0, 1.0f};
-        mtx_lower_thread_.unlock();
+        // stop trajectory if running, and cancel lower movement
+        lower_scheduler_.clear();
+        lower_bus_.call(PRIORITY_MOTION, [this](){ lower_.servo_on(); });
       } else {
-        lower_stroke_trajectory.push_back({lower_stroke_vector, time_csec});
+        lower_stroke_trajectory.push_back(lower_stroke_row, time_usec);
       }
     }
   }
 
-  mtx_upper_.unlock();
-  mtx_lower_.unlock();
-
-  if (lower_count > 0 && lower_stroke_trajectory.size() > 0) {
-    // setup thread settings
-    mtx_lower_thread_.lock();
-    if (lower_thread_.id == 1) { // trajectory is already running
-      ROS_ERROR("you cannot overwrite lower trajectory!");
-      mtx_lower_thread_.unlock();
-    } else {
-      lower_thread_.id = 1;
-      lower_thread_.kill = false;
-      mtx_lower_thread_.unlock();
-      // start thread
-      std::thread send_lower([&](
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory) {
-          LowerTrajectoryThread(_stroke_trajectory);
-        }, lower_stroke_trajectory);
-      send_lower.detach();
-    }
+  if (lower_count > 0 && lower_stroke_trajectory.size() > 1) {
+    // joints not in _msg are left to running trajectories
+    for (size_t i = 0; i < AERO_DOF_LOWER; ++i)
+      if (lower_strokes[i] == 0x7fff)
+        lower_stroke_trajectory.stroke(0, i) = 0x7fff;
+    // joints of running trajectories are taken over, blended
+    lower_scheduler_.submit(lower_stroke_trajectory, {});
   }
 
   if (upper_count <= 0) {
@@ -628,156 +448,102 @@ void AeroControllerNode::JointTrajectoryCallback(
     return; // nothing more to do
   }
 
+  // spline mode: splines through all points, sampled every frame
+  // of upper_scheduler_, which sends the samples as linear points
+  bool spline = spline_trajectory_ && upper_stroke_trajectory.size() > 2;
+  if (spline) {
+    aero::interpolation::StrokeSpline stroke_spline(upper_stroke_trajectory);
+    upper_stroke_trajectory = stroke_spline.resample(100000);
+  }
+
   std::vector<aero::interpolation::InterpolationPtr> interpolation;
   interpolation.reserve(upper_stroke_trajectory.size());
   // fill in dummy setup in head
   interpolation.push_back(std::shared_ptr<aero::interpolation::Interpolation>(
         new aero::interpolation::Interpolation(aero::interpolation::i_constant)));
-  // copy interpolation setup
+  // copy interpolation setup, not for spline samples
   mtx_intrpl_.lock();
-  for (auto it = interpolation_.begin(); it != interpolation_.end(); ++it)
+  for (auto it = interpolation_.begin(); it != interpolation_.end() && !spline;
+       ++it)
     interpolation.push_back(*it);
   // fillin rest with linear if not specified
-  for (size_t i = interpolation_.size(); i < upper_stroke_trajectory.size(); ++i)
+  for (size_t i = interpolation.size(); i < upper_stroke_trajectory.size(); ++i)
     interpolation.push_back(std::shared_ptr<aero::interpolation::Interpolation>(
         new aero::interpolation::Interpolation(aero::interpolation::i_linear)));
   mtx_intrpl_.unlock();
 
-  // start new thread if no other thread is running
-  mtx_threads_.lock();
-  if (registered_threads_.size() == 0) {
-    mtx_threads_.unlock();
-    std::thread send_av([&](
-        std::vector<aero::interpolation::InterpolationPtr> _interpolation,
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory)
-    {
-      JointTrajectoryThread(_interpolation, _stroke_trajectory, 1, 1);
-    }, interpolation, upper_stroke_trajectory);
-    send_av.detach();
-    ROS_INFO("----no other thread is running, finishing up----");
-    return;
-  }
-  mtx_threads_.unlock();
+  // joints of running trajectories are taken over at once
+  upper_scheduler_.submit(upper_stroke_trajectory, interpolation);
 
-  ROS_WARN("----another thread is running----");
+  ROS_INFO("----finishing joint trajectory callback----");
+}
 
-  // check if any of current joint is already running in one of the threads
-  std::vector<std::pair<int, uint> > conflict_joints;
-  mtx_threads_.lock();
-  for (size_t i = 0; i < upper_stroke_trajectory[1].first.size(); ++i) {
-    if (upper_stroke_trajectory[1].first.at(i) == 0x7fff &&
-        upper_stroke_trajectory[0].first.at(i) == 0x7fff) // **
-      continue;
-    // ** if [1] == 0x7fff but [0] != 0x7fff : the 0x7fff in [1] means cancel
-    //    this distinguishes unused joints to cancelled joints
-    for (auto th = registered_threads_.begin(); th != registered_threads_.end(); ++th)
-      for (auto j = th->joints.begin(); j != th->joints.end(); ++j)
-        if (i == *j) conflict_joints.push_back({static_cast<int>(i), th->id});
-  }
-  mtx_threads_.unlock();
-
-  // start new thread if there is no conflict
-  if (conflict_joints.size() == 0) {
-    std::thread send_av([&](
-        std::vector<aero::interpolation::InterpolationPtr> _interpolation,
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory)
-    {
-      JointTrajectoryThread(_interpolation, _stroke_trajectory, 1, 1);
-    }, interpolation, upper_stroke_trajectory);
-    send_av.detach();
-    ROS_INFO("----no conflict in threads, finishing up----");
-    return;
-  }
+//////////////////////////////////////////////////
+void AeroControllerNode::JointTrajectoryStreamCallback(
+    const trajectory_msgs::JointTrajectory::ConstPtr& _msg)
+{
+  int number_of_angle_joints =
+      upper_.get_number_of_angle_joints() +
+      lower_.get_number_of_angle_joints();
 
-  ROS_WARN("----confict in threads----");
-
-  // if there is a thread conflict, thread remapping must be conducted
-  // find and count the threads to be killed
-  std::vector<int> kill_thread_id;
-  for (auto it = conflict_joints.begin(); it != conflict_joints.end(); ++it) {
-    auto in_list = std::find(kill_thread_id.begin(), kill_thread_id.end(), it->second);
-    if (in_list == kill_thread_id.end()) { // kill thread if not killed yet
-      mtx_threads_.lock();
-      for (auto th = registered_threads_.begin(); th != registered_threads_.end(); ++th)
-        if (it->second == th->id) {
-          th->kill = true; // register as kill
-          kill_thread_id.push_back(it->second); // save already set to kill thread
-          mtx_threads_.unlock();
-          break;
-        }
-      mtx_threads_.unlock();
-    }
+  if (_msg->points.size() == 0 ||
+      _msg->joint_names.size() > number_of_angle_joints) {
+    ROS_ERROR("command stream: invalid trajectory");
+    return;
   }
 
-  auto time_begin = std::chrono::high_resolution_clock::now();
-
-  // wait till corresponding threads are killed
-  while (1) {
-    mtx_thread_graveyard_.lock();
-    if (thread_graveyard_.size() == kill_thread_id.size() ||
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::high_resolution_clock::now() - time_begin).count()
-        > 500) { // a thread might have finished before kill
-      mtx_thread_graveyard_.unlock();
-      break;
+  // only upper joints are streamed
+  std::vector<int32_t> id_in_msg_to_ordered_id(_msg->joint_names.size());
+  std::vector<bool> send_true(number_of_angle_joints, false);
+  for (size_t i = 0; i < _msg->joint_names.size(); ++i) {
+    id_in_msg_to_ordered_id[i] =
+        upper_.get_ordered_angle_id(_msg->joint_names[i]);
+    if (id_in_msg_to_ordered_id[i] < 0) {
+      ROS_ERROR("command stream: %s is not an upper joint",
+                _msg->joint_names[i].c_str());
+      return;
     }
-    mtx_thread_graveyard_.unlock();
-    usleep(10 * 1000); // sleep 10 ms and wait for update
+    send_true[id_in_msg_to_ordered_id[i]] = true;
   }
 
-  mtx_thread_graveyard_.lock();
-  // remap use joint info
-  for (auto it = conflict_joints.begin(); it != conflict_joints.end(); ++it)
-    for (auto th = thread_graveyard_.begin(); th != thread_graveyard_.end(); ++th)
-      if (it->second == th->thread_id) {
-        for (auto traj = th->trajectories.begin();
-             traj != th->trajectories.end(); ++traj)
-          traj->first.at(it->first) = 0x7fff;
-        break;
-      }
-  // create new threads
-  std::vector<std::thread> new_threads;
-  // add this msg
-  new_threads.push_back(std::thread([&](
-        std::vector<aero::interpolation::InterpolationPtr> _interpolation,
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory)
-    {
-      JointTrajectoryThread(_interpolation, _stroke_trajectory, 1, 1);
-    }, interpolation, upper_stroke_trajectory));
-  // add previously running threads that were remapped
-  for (auto th = thread_graveyard_.begin(); th != thread_graveyard_.end(); ++th) {
-    int unused_joint_num = 0;
-    for (auto j = th->trajectories[0].first.begin();
-         j != th->trajectories[0].first.end(); ++j)
-      if (*j == 0x7fff) ++unused_joint_num;
-    // i_constant at_split_num tracks elapsed time
-    // elapsed time is used for speed overwrite but not for command overwrite
-    if (th->interpolation.at(th->at_trajectory_num)->is(aero::interpolation::i_constant))
-      th->at_split_num = 1; // make sure to reset elapsed time
-    // if remapped trajectory is still valid (= has moving joints)
-    if (unused_joint_num != th->trajectories[0].first.size()) {
-      new_threads.push_back(std::thread([&](
-        std::vector<aero::interpolation::InterpolationPtr> _interpolation,
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory,
-        int _trajectory_start_from,
-        int _split_start_from)
-      {
-        JointTrajectoryThread(_interpolation, _stroke_trajectory,
-                              _trajectory_start_from, _split_start_from);
-      }, th->interpolation, th->trajectories, th->at_trajectory_num, th->at_split_num));
-    } else if (th->interpolation.at(th->at_trajectory_num)->is(aero::interpolation::i_constant)) {
-      // upper_.servo_on(); // cancel movement
-    }
+  aero::interpolation::StrokeTimeline upper_stroke_trajectory(AERO_DOF_UPPER);
+  upper_stroke_trajectory.reserve(_msg->points.size() + 1);
+  // start of a new stream, get current stroke values, use reference for safety
+  std::vector<int16_t> ref_strokes = upper_.get_reference_stroke_vector();
+  UnusedAngle2Stroke(ref_strokes, send_true);
+  upper_stroke_trajectory.push_back(ref_strokes, 0);
+
+  size_t number_of_points = _msg->points.size();
+  std::vector<double> angles(number_of_points * number_of_angle_joints, 0.0);
+  for (size_t i = 0; i < number_of_points; ++i) {
+    double* ordered_positions = angles.data() + i * number_of_angle_joints;
+    for (size_t j = 0; j < _msg->points[i].positions.size() &&
+           j < id_in_msg_to_ordered_id.size(); ++j)
+      ordered_positions[id_in_msg_to_ordered_id[j]] =
+        _msg->points[i].positions[j];
   }
-  // free graveyard
-  thread_graveyard_.clear();
-  mtx_thread_graveyard_.unlock();
-
-  // start threads
-  std::for_each(
-      new_threads.begin(), new_threads.end(), [](std::thread& t){ t.detach(); });
 
-  ROS_INFO("----finishing joint trajectory callback----");
+  std::vector<int16_t> upper_strokes;
+  std::vector<int16_t> lower_strokes;
+  common::Angle2StrokeBatch(angles, send_true, upper_strokes, lower_strokes,
+                            tables_.get());
+
+  for (size_t i = 0; i < number_of_points; ++i)
+    upper_stroke_trajectory.push_back(
+        upper_strokes.data() + i * AERO_DOF_UPPER,
+        _msg->points[i].time_from_start.toNSec() / 1000);
+
+  upper_scheduler_.append(upper_stroke_trajectory,
+                          stream_lookahead_usec_, stream_timeout_usec_);
+
+  StreamStatistics statistics = upper_scheduler_.stream_statistics();
+  if (statistics.underruns > stream_underruns_)
+    ROS_WARN("command stream: underrun (%d in total), increase stream_lookahead",
+             static_cast<int>(statistics.underruns));
+  stream_underruns_ = statistics.underruns;
+  std_msgs::Float32 latency;
+  latency.data = statistics.latency_ms;
+  stream_latency_pub_.publish(latency);
 }
 
 //////////////////////////////////////////////////
@@ -787,19 +553,9 @@ void AeroControllerNode::SpeedOverwriteCallback(
   ROS_WARN("----speed overwrite callback---- factor:%f", _msg->data);
 
   // make sure robot is in action when SpeedOverwrite is called
-  bool upper=true, lower=true;
-  mtx_threads_.lock();
-  if (registered_threads_.size() == 0)
-    upper = false;
-  mtx_threads_.unlock();
-  mtx_lower_thread_.lock();
-  if (lower_thread_.id == 0)
-    lower = false;
-  mtx_lower_thread_.unlock();
-  mtx_thread_postpone_.lock();
-  bool postpone = thread_postpone_;
-  mtx_thread_postpone_.unlock();
-  if (!upper && !lower && !postpone) {
+  // (paused trajectories are in action)
+  bool postpone = upper_scheduler_.paused() || lower_scheduler_.paused();
+  if (!upper_scheduler_.active() && !lower_scheduler_.active()) {
     ROS_ERROR("  cannot overwrite speed when robot is not in action!");
     return;
   }
@@ -815,128 +571,22 @@ void AeroControllerNode::SpeedOverwriteCallback(
     return;
   }
 
-  // on background, kill lower thread if running
-  std::thread lower_process([&](bool _postpone){
-      mtx_lower_thread_.lock();
-      if (lower_thread_.id == 1 && !_postpone) // if running
-        lower_thread_.kill = true;
-      mtx_lower_thread_.unlock();
-
-      auto time_begin = std::chrono::high_resolution_clock::now();
-      while (1) {
-        mtx_lower_thread_.lock();
-        if (!lower_thread_.kill ||
-            std::chrono::duration_cast<std::chrono::milliseconds>(
-              std::chrono::high_resolution_clock::now() - time_begin).count()
-            > 500) { // a thread might have finished before kill
-          mtx_lower_thread_.unlock();
-          break;
-        }
-        mtx_lower_thread_.unlock();
-        usleep(10 * 1000); // sleep 10 ms and wait for update
-      }
-
-      if (_msg->data < abort_threshold) { // avoid overflow, act as 0.0
-        mtx_lower_.lock();
-        lower_.servo_on();
-        mtx_lower_.unlock();
-        return;
-      }
-
-      // rewrite lower thread command time
-      // update elapsed time to new time scale
-      mtx_lower_thread_.lock();
-      lower_killed_thread_info_.at_split_num /=
-        _msg->data / lower_killed_thread_info_.factor;
-      for (auto traj = lower_killed_thread_info_.trajectories.begin();
-           traj != lower_killed_thread_info_.trajectories.end(); ++traj)
-        traj->second = static_cast<uint16_t>(
-            traj->second / (_msg->data / lower_killed_thread_info_.factor));
-      lower_killed_thread_info_.factor = _msg->data;
-      mtx_lower_thread_.unlock();
-    }, postpone);
-
-  if (_msg->data < abort_threshold) {
-    // set postpone flag before thread clear to avoid wait escape
-    // speed 0.0 is technically non-dead
-    mtx_thread_postpone_.lock();
-    thread_postpone_ = true;
-    mtx_thread_postpone_.unlock();
-  }
-
-  // kill all running upper threads
-  std::vector<int> kill_thread_id;
-  mtx_threads_.lock();
-  for (auto th = registered_threads_.begin(); th != registered_threads_.end(); ++th) {
-    th->kill = true;
-    kill_thread_id.push_back(th->id);
-  }
-  mtx_threads_.unlock();
-
-  auto time_begin = std::chrono::high_resolution_clock::now();
-  if (!postpone)
-    while (1) {
-      mtx_thread_graveyard_.lock();
-      if (thread_graveyard_.size() == kill_thread_id.size() ||
-          std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::high_resolution_clock::now() - time_begin).count()
-          > 500) { // a thread might have finished before kill
-        break;
-      }
-      mtx_thread_graveyard_.unlock();
-      usleep(10 * 1000); // sleep 10 ms and wait for update
-    }
-
   if (_msg->data < abort_threshold) { // avoid overflow, act as 0.0
-    mtx_thread_graveyard_.unlock();
-    mtx_upper_.lock();
-    upper_.servo_on();
-    mtx_upper_.unlock();
-    lower_process.join();
+    // pause trajectories, and cancel movement in flight
+    // (set_rate returns once a frame at the old rate is on the bus,
+    // so servo_on is queued after it)
+    upper_scheduler_.set_rate(0.0);
+    lower_scheduler_.set_rate(0.0);
+    CommandCompletion done;
+    upper_bus_.post(PRIORITY_MOTION, [this](){ upper_.servo_on(); }, &done);
+    lower_bus_.post(PRIORITY_MOTION, [this](){ lower_.servo_on(); }, &done);
+    done.wait();
     return;
   }
 
-  // rewrite graveyard command time
-  // create new threads
-  std::vector<std::thread> new_threads;
-  for (auto th = thread_graveyard_.begin(); th != thread_graveyard_.end(); ++th) {
-    // update elapsed time to new time scale
-    th->at_split_num = static_cast<uint16_t>(th->at_split_num / (_msg->data / th->factor));
-
-    for (auto traj = th->trajectories.begin();
-         traj != th->trajectories.end(); ++traj)
-      traj->second = static_cast<uint16_t>(traj->second / (_msg->data / th->factor));
-    new_threads.push_back(std::thread([&](
-        std::vector<aero::interpolation::InterpolationPtr> _interpolation,
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory,
-        int _trajectory_start_from,
-        int _split_start_from, float _factor)
-      {
-        JointTrajectoryThread(_interpolation, _stroke_trajectory,
-                              _trajectory_start_from, _split_start_from, _factor);
-      }, th->interpolation, th->trajectories, th->at_trajectory_num, th->at_split_num, _msg->data));
-  }
-  // free graveyard
-  thread_graveyard_.clear();
-  mtx_thread_graveyard_.unlock();
-
-  // create new lower thread
-  lower_process.join();
-  mtx_thread_postpone_.lock();
-  thread_postpone_ = false;
-  mtx_thread_postpone_.unlock();
-  mtx_lower_thread_.lock();
-  std::thread send_lower([&](
-    std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory) {
-      LowerTrajectoryThread(_stroke_trajectory);
-    }, lower_killed_thread_info_.trajectories);
-  lower_killed_thread_info_.trajectories.clear(); // re-fresh data
-  mtx_lower_thread_.unlock();
-  send_lower.detach();
-
-  // resend commands with rewritten time
-  std::for_each(
-      new_threads.begin(), new_threads.end(), [](std::thread& t){ t.detach(); });
+  // running and paused trajectories continue at the new speed
+  upper_scheduler_.set_rate(_msg->data);
+  lower_scheduler_.set_rate(_msg->data);
 
   ROS_INFO("----finishing speed overwrite callback----");
 }
@@ -950,38 +600,23 @@ void AeroControllerNode::JointStateCallback(const ros::TimerEvent& event)
 //////////////////////////////////////////////////
 void AeroControllerNode::JointStateOnce()
 {
-  mtx_upper_.lock();
-  mtx_lower_.lock();
-
-  // get desired positions
-  std::vector<int16_t> upper_ref_vector =
-      upper_.get_reference_stroke_vector();
-  std::vector<int16_t> lower_ref_vector =
-      lower_.get_reference_stroke_vector();
-
   // update current position when upper body is not being controlled
   // when upper body is controlled, current position is auto-updated
-  mtx_threads_.lock();
-  if (registered_threads_.size() == 0) {
-    // commands take 20ms sleep, threading to save time
-    std::thread t1([&](){
-        upper_.update_position();
-      });
-    std::thread t2([&](){
-        lower_.update_position();
-      });
-    t1.join();
-    t2.join();
+  bool upper_idle = !upper_scheduler_.active() || upper_scheduler_.paused();
+  if (upper_idle) {
+    // commands take 20ms sleep, both buses run in parallel
+    CommandCompletion done;
+    upper_bus_.post(PRIORITY_TELEMETRY,
+                    [this](){ upper_.update_position(); }, &done);
+    lower_bus_.post(PRIORITY_TELEMETRY,
+                    [this](){ lower_.update_position(); }, &done);
+    done.wait();
   }
-  mtx_threads_.unlock();
-
-  // get upper actual positions
-  std::vector<int16_t> upper_stroke_vector =
-    upper_.get_actual_stroke_vector();
 
-  // get lower actual positions
-  std::vector<int16_t> lower_stroke_vector =
-    lower_.get_actual_stroke_vector();
+  // get desired and actual positions from snapshots
+  StrokeState upper_state, lower_state;
+  bool upper_ok = upper_.get_state(upper_state);
+  bool lower_ok = lower_.get_state(lower_state);
 
   // first handle the stroke publisher
   // in this way, we don't have to concatenate new vectors
@@ -991,7 +626,7 @@ void AeroControllerNode::JointStateOnce()
   stroke_state.desired.positions.resize(AERO_DOF);
   stroke_state.actual.positions.resize(AERO_DOF);
 
-  if (upper_ref_vector.size() < AERO_DOF_UPPER || upper_stroke_vector.size() < AERO_DOF_UPPER)
+  if (!upper_ok || upper_state.size < AERO_DOF_UPPER)
     for (size_t i = 0; i < AERO_DOF_UPPER; ++i) {
       stroke_state.joint_names[i] = upper_.get_stroke_joint_name(i);
       stroke_state.desired.positions[i] = 0.0;
@@ -1001,12 +636,12 @@ void AeroControllerNode::JointStateOnce()
     for (size_t i = 0; i < AERO_DOF_UPPER; ++i) {
       stroke_state.joint_names[i] = upper_.get_stroke_joint_name(i);
       stroke_state.desired.positions[i] =
-          static_cast<double>(upper_ref_vector[i]);
+          static_cast<double>(upper_state.reference[i]);
       stroke_state.actual.positions[i] =
-          static_cast<double>(upper_stroke_vector[i]);
+          static_cast<double>(upper_state.actual[i]);
     }
 
-  if (lower_ref_vector.size() < AERO_DOF_LOWER || lower_stroke_vector.size() < AERO_DOF_LOWER)
+  if (!lower_ok || lower_state.size < AERO_DOF_LOWER)
     for (size_t i = 0; i < AERO_DOF_LOWER; ++i) {
       stroke_state.joint_names[i + AERO_DOF_UPPER] =
           lower_.get_stroke_joint_name(i);
@@ -1018,9 +653,9 @@ void AeroControllerNode::JointStateOnce()
       stroke_state.joint_names[i + AERO_DOF_UPPER] =
           lower_.get_stroke_joint_name(i);
       stroke_state.desired.positions[i + AERO_DOF_UPPER] =
-          static_cast<double>(lower_ref_vector[i]);
+          static_cast<double>(lower_state.reference[i]);
       stroke_state.actual.positions[i + AERO_DOF_UPPER] =
-          static_cast<double>(lower_stroke_vector[i]);
+          static_cast<double>(lower_state.actual[i]);
     }
 
   int number_of_angle_joints =
@@ -1036,31 +671,31 @@ void AeroControllerNode::JointStateOnce()
   // convert to desired angle positions
   std::vector<int16_t> desired_strokes(stroke_state.desired.positions.begin(),
                                        stroke_state.desired.positions.end());
-  common::Stroke2Angle(state.desired.positions, desired_strokes);
+  Stroke2Angle(state.desired.positions, desired_strokes);
 
   // convert to actual angle positions
   std::vector<int16_t> actual_strokes(stroke_state.actual.positions.begin(),
                                       stroke_state.actual.positions.end());
-  common::Stroke2Angle(state.actual.positions, actual_strokes);
+  Stroke2Angle(state.actual.positions, actual_strokes);
 
   // get joint names (auto-generated function)
   common::AngleJointNames(state.joint_names);
 
   // get status
   std_msgs::Bool status_flag;
-  status_flag.data = upper_.get_status() || lower_.get_status();
+  status_flag.data = (upper_ok && upper_state.bad_status) ||
+    (lower_ok && lower_state.bad_status);
   status_pub_.publish(status_flag);
 
   state_pub_.publish(state);
   stroke_state_pub_.publish(stroke_state);
-
-  mtx_upper_.unlock();
-  mtx_lower_.unlock();
 }
 
 //////////////////////////////////////////////////
 void AeroControllerNode::PublishInAction(const ros::TimerEvent& event)
 {
+  PublishPreemptionLatency();
+
   std_msgs::Bool msg;
   msg.data = false;
 
@@ -1079,78 +714,54 @@ void AeroControllerNode::PublishInAction(const ros::TimerEvent& event)
     return;
   }
 
-  // count upper trajectory threads number
-  int upper;
-  if (!mtx_threads_.try_lock()) {// when mutex cant be locked, thread should be active.
-    upper = 1;
-  } else {//lock
-    upper = static_cast<int>(registered_threads_.size());
-    mtx_threads_.unlock();
-  }
-  if (upper > 0) {
+  // upper and lower trajectories are running or paused
+  if (upper_scheduler_.active() || lower_scheduler_.active()) {
     msg.data = true;
     in_action_pub_.publish(msg);
     return;
   }
 
-  // lower trajectory thread is active or not
-  int lower;
-  if (!mtx_lower_thread_.try_lock()) {// when mutex cant be locked, thread should be active.
-    lower = 1;
-  } else {
-    lower = lower_thread_.id;
-    mtx_lower_thread_.unlock();
-  }
-  if (lower > 0) {
-    msg.data = true;
-    in_action_pub_.publish(msg);
-    return;
-  }
-
-  bool in_overwrite = false;
-  if (!mtx_thread_postpone_.try_lock()) {// when mutex cant be locked, thread should be active.
-    in_overwrite = true;
-  } else {//lock
-    in_overwrite = thread_postpone_;
-    mtx_thread_postpone_.unlock();
+  in_action_pub_.publish(msg);
+}
+//////////////////////////////////////////////////
+void AeroControllerNode::PublishPreemptionLatency()
+{
+  std_msgs::Float32 msg;
+  PreemptionStatistics upper = upper_scheduler_.preemption_statistics();
+  if (upper.measured != upper_measured_) {
+    upper_measured_ = upper.measured;
+    msg.data = upper.latency_ms;
+    preemption_latency_pub_.publish(msg);
   }
-  if (in_overwrite) {
-    msg.data = true;
-    in_action_pub_.publish(msg);
-    return;
+  PreemptionStatistics lower = lower_scheduler_.preemption_statistics();
+  if (lower.measured != lower_measured_) {
+    lower_measured_ = lower.measured;
+    msg.data = lower.latency_ms;
+    preemption_latency_pub_.publish(msg);
   }
-
-  in_action_pub_.publish(msg);
 }
+
 //////////////////////////////////////////////////
 void AeroControllerNode::WheelServoCallback(
     const std_msgs::Bool::ConstPtr& _msg)
 {
-  mtx_lower_.lock();
-
   if (_msg->data) {
     // wheel_on sets all joints and wheels to servo on
-    lower_.wheel_on();
+    lower_bus_.call(PRIORITY_CONFIG, [this](){ lower_.wheel_on(); });
   } else {
     // servo_on joints only, and servo off wheels
-    lower_.wheel_only_off();
+    lower_bus_.call(PRIORITY_CONFIG, [this](){ lower_.wheel_only_off(); });
   }
-
-  mtx_lower_.unlock();
 }
 
 //////////////////////////////////////////////////
 void AeroControllerNode::StatusResetCallback(
     const std_msgs::Empty::ConstPtr& _msg)
 {
-  mtx_upper_.lock();
-  mtx_lower_.lock();
-
-  upper_.reset_status();
-  lower_.reset_status();
-
-  mtx_upper_.unlock();
-  mtx_lower_.unlock();
+  CommandCompletion done;
+  upper_bus_.post(PRIORITY_CONFIG, [this](){ upper_.reset_status(); }, &done);
+  lower_bus_.post(PRIORITY_CONFIG, [this](){ lower_.reset_status(); }, &done);
+  done.wait();
 }
 
 //////////////////////////////////////////////////
@@ -1170,8 +781,6 @@ void AeroControllerNode::SetCollisionModeCallback(
 void AeroControllerNode::WheelCommandCallback(
     const trajectory_msgs::JointTrajectory::ConstPtr& _msg)
 {
-  mtx_lower_.lock();
-
   // wheel name to indices, if not exist, then return -1
   std::vector<int32_t> joint_to_wheel_indices(AERO_DOF_WHEEL);
   for (size_t i = 0; i < _msg->joint_names.size(); ++i) {
@@ -1180,49 +789,45 @@ void AeroControllerNode::WheelCommandCallback(
         lower_.get_wheel_id(joint_name);
   }
 
-  // set previous velocity
-  std::vector<int16_t> wheel_vector;
-  std::vector<int16_t>& ref_vector =
-      lower_.get_reference_wheel_vector();
-  wheel_vector.assign(ref_vector.begin(), ref_vector.end());
+  // reference wheel vector is updated by set_wheel_velocity,
+  // so read and send on lower bus thread
+  lower_bus_.call(PRIORITY_MOTION, [&](){
+      // set previous velocity
+      std::vector<int16_t> wheel_vector;
+      std::vector<int16_t>& ref_vector =
+          lower_.get_reference_wheel_vector();
+      wheel_vector.assign(ref_vector.begin(), ref_vector.end());
+
+      // for each trajectory points,
+      for (size_t i = 0; i < _msg->points.size(); ++i) {
+        // convert positions to stroke vector
+        for (size_t j = 0; j < _msg->points[i].positions.size(); ++j) {
+          if (joint_to_wheel_indices[j] >= 0) {
+            wheel_vector[
+                static_cast<size_t>(joint_to_wheel_indices[j])] =
+                static_cast<int16_t>(_msg->points[i].positions[j]);
+          }
+        }
 
-  // for each trajectory points,
-  for (size_t i = 0; i < _msg->points.size(); ++i) {
-    // convert positions to stroke vector
-    for (size_t j = 0; j < _msg->points[i].positions.size(); ++j) {
-      if (joint_to_wheel_indices[j] >= 0) {
-        wheel_vector[
-            static_cast<size_t>(joint_to_wheel_indices[j])] =
-            static_cast<int16_t>(_msg->points[i].positions[j]);
+        double time_sec = _msg->points[i].time_from_start.toSec();
+        uint16_t time_csec = static_cast<uint16_t>(time_sec * 100.0);
+        lower_.set_wheel_velocity(wheel_vector, time_csec);
+        // usleep(static_cast<int32_t>(time_sec * 1000.0 * 1000.0));
       }
-    }
-
-    double time_sec = _msg->points[i].time_from_start.toSec();
-    uint16_t time_csec = static_cast<uint16_t>(time_sec * 100.0);
-    lower_.set_wheel_velocity(wheel_vector, time_csec);
-    // usleep(static_cast<int32_t>(time_sec * 1000.0 * 1000.0));
-  }
-
-  mtx_lower_.unlock();
+    });
 }
 
 //////////////////////////////////////////////////
 void AeroControllerNode::UtilServoCallback(
     const std_msgs::Int32::ConstPtr& _msg)
 {
-  mtx_upper_.lock();
-
-  if (_msg->data == 0) {
-    usleep(static_cast<int32_t>(200.0 * 1000.0));
-    upper_.util_servo_off();
-    usleep(static_cast<int32_t>(200.0 * 1000.0));
-  } else {
-    usleep(static_cast<int32_t>(200.0 * 1000.0));
-    upper_.util_servo_on();
-    usleep(static_cast<int32_t>(200.0 * 1000.0));
-  }
-
-  mtx_upper_.unlock();
+  // sleep in this callback, upper bus keeps running other commands
+  usleep(static_cast<int32_t>(200.0 * 1000.0));
+  if (_msg->data == 0)
+    upper_bus_.call(PRIORITY_CONFIG, [this](){ upper_.util_servo_off(); });
+  else
+    upper_bus_.call(PRIORITY_CONFIG, [this](){ upper_.util_servo_on(); });
+  usleep(static_cast<int32_t>(200.0 * 1000.0));
 }
 
 //////////////////////////////////////////////////
@@ -1253,6 +858,8 @@ bool AeroControllerNode::InterpolationCallback(
     }
     ++i;
   }
+  for (auto it = interpolation_.begin(); it != interpolation_.end(); ++it)
+    (*it)->tabulate(interpolation_table_size_);
   mtx_intrpl_.unlock();
 
   return true;
@@ -1272,13 +879,12 @@ bool AeroControllerNode::GraspControlCallback(
     aero_startup::GraspControl::Request& _req,
     aero_startup::GraspControl::Response& _res)
 {
-  mtx_upper_.lock();
-  upper_.set_max_single_current(_req.position, _req.power);
-  mtx_upper_.unlock();
+  upper_bus_.call(PRIORITY_CONFIG, [&](){
+      upper_.set_max_single_current(_req.position, _req.power); });
+  // sleep without holding upper bus
   usleep(200 * 1000);
-  mtx_upper_.lock();
-  upper_.Hand_Script(_req.position, _req.script);
-  mtx_upper_.unlock();
+  upper_bus_.call(PRIORITY_CONFIG, [&](){
+      upper_.Hand_Script(_req.position, _req.script); });
 
   // return if cancel script
   if (_req.script == aero_startup::GraspControlRequest::SCRIPT_CANCEL)
@@ -1290,24 +896,20 @@ bool AeroControllerNode::GraspControlCallback(
     usleep(1000 * 1000);
   }
 
-  mtx_upper_.lock();
-  upper_.update_position();
+  upper_bus_.call(PRIORITY_TELEMETRY, [this](){ upper_.update_position(); });
   std::vector<int16_t> upper_stroke_vector_ret =
     upper_.get_actual_stroke_vector();
-  mtx_upper_.unlock();
 
   // get lower for angle conversion only (update not necessary)
-  mtx_lower_.lock();
   std::vector<int16_t> lower_stroke_vector_ret =
     lower_.get_actual_stroke_vector();
-  mtx_lower_.unlock();
   upper_stroke_vector_ret.insert(upper_stroke_vector_ret.end(),
       lower_stroke_vector_ret.begin(), lower_stroke_vector_ret.end());
 
   // convert strokes to angles
   std::vector<double> upper_angles(upper_.get_number_of_angle_joints()
       + lower_.get_number_of_angle_joints());
-  common::Stroke2Angle(upper_angles, upper_stroke_vector_ret);
+  Stroke2Angle(upper_angles, upper_stroke_vector_ret);
 
   _res.angles.resize(2);
   _res.angles[0] = upper_angles[13];
@@ -1324,8 +926,6 @@ bool AeroControllerNode::SendJointsCallback(
   mtx_send_joints_status_.lock();
   send_joints_status_ = true;
   mtx_send_joints_status_.unlock();
-  mtx_upper_.lock();
-  mtx_lower_.lock();
 
   int number_of_angle_joints =
       upper_.get_number_of_angle_joints() +
@@ -1333,8 +933,6 @@ bool AeroControllerNode::SendJointsCallback(
 
   if (_req.joint_names.size() > number_of_angle_joints) {
     // invalid number of joints from _req
-    mtx_upper_.unlock();
-    mtx_lower_.unlock();
     mtx_send_joints_status_.lock();
     send_joints_status_ = false;
     mtx_send_joints_status_.unlock();
@@ -1371,8 +969,6 @@ bool AeroControllerNode::SendJointsCallback(
     }
 
     if (id_in_req_to_ordered_id[i] < 0) {
-      mtx_upper_.unlock();
-      mtx_lower_.unlock();
       mtx_send_joints_status_.lock();
       send_joints_status_ = false;
       mtx_send_joints_status_.unlock();
@@ -1403,10 +999,10 @@ bool AeroControllerNode::SendJointsCallback(
       send_true_with_cancel[id_in_req_to_ordered_id[j]] = false;
 
   std::vector<int16_t> strokes(AERO_DOF);
-  common::Angle2Stroke(strokes, ordered_positions);
+  Angle2Stroke(strokes, ordered_positions);
 
   // fill in unused joints to no-send
-  common::UnusedAngle2Stroke(strokes, send_true_with_cancel);
+  UnusedAngle2Stroke(strokes, send_true_with_cancel);
 
   // split strokes into upper and lower
   std::vector<int16_t> upper_stroke_vector(
@@ -1417,7 +1013,8 @@ bool AeroControllerNode::SendJointsCallback(
   double time_sec = _req.points.time_from_start.toSec();
   uint16_t time_csec = static_cast<uint16_t>(time_sec * 100.0);
 
-  std::thread t1([&](){
+  CommandCompletion sent;
+  upper_bus_.post(PRIORITY_MOTION, [&](){
       if (_req.reset_status) { // reset status if flag
         usleep(20000); // 20ms sleep before next command
         upper_.reset_status();
@@ -1426,9 +1023,8 @@ bool AeroControllerNode::SendJointsCallback(
       if (upper_count > 0) {
         upper_.set_position(upper_stroke_vector, time_csec);
       }
-    });
-
-  std::thread t2([&](){
+    }, &sent);
+  lower_bus_.post(PRIORITY_MOTION, [&](){
       if (_req.reset_status) { // reset status if flag
         usleep(20000); // 20ms sleep before next command
         lower_.reset_status();
@@ -1437,34 +1033,24 @@ bool AeroControllerNode::SendJointsCallback(
       if (lower_count > 0) {
         lower_.set_position(lower_stroke_vector, time_csec);
       }
-    });
-
-  t1.join();
-  t2.join();
+    }, &sent);
+  sent.wait();
 
   usleep(20000); // prevent service call overlap
 
-  mtx_upper_.unlock();
-  mtx_lower_.unlock();
-
   // wait for action to finish
   usleep(time_csec * 10 * 1000 - 60000); // **
-  // ** 20ms sleep in set_position + 20ms sleep before/after mtx lock
-
-  mtx_upper_.lock();
-  mtx_lower_.lock();
+  // ** 20ms sleep in set_position + 20ms sleep before/after wait
 
   usleep(20000); // prevent update failures
 
-  // commands take 20ms sleep, threading to save time
-  std::thread t3([&](){
-      upper_.update_position();
-    });
-  std::thread t4([&](){
-      lower_.update_position();
-    });
-  t3.join();
-  t4.join();
+  // commands take 20ms sleep, both buses run in parallel
+  CommandCompletion updated;
+  upper_bus_.post(PRIORITY_TELEMETRY,
+                  [this](){ upper_.update_position(); }, &updated);
+  lower_bus_.post(PRIORITY_TELEMETRY,
+                  [this](){ lower_.update_position(); }, &updated);
+  updated.wait();
 
   // get upper actual positions
   std::vector<int16_t> upper_stroke_vector_ret =
@@ -1498,7 +1084,7 @@ bool AeroControllerNode::SendJointsCallback(
   // convert to actual angle positions
   std::vector<int16_t> actual_strokes(actual_stroke_state.begin(),
                                       actual_stroke_state.end());
-  common::Stroke2Angle(_res.points.positions, actual_strokes);
+  Stroke2Angle(_res.points.positions, actual_strokes);
 
   // get joint names (auto-generated function)
   common::AngleJointNames(_res.joint_names);
@@ -1507,8 +1093,6 @@ bool AeroControllerNode::SendJointsCallback(
   std_msgs::Bool status_flag;
   _res.status = upper_.get_status() || lower_.get_status();
 
-  mtx_upper_.unlock();
-  mtx_lower_.unlock();
   mtx_send_joints_status_.lock();
   send_joints_status_ = false;
   mtx_send_joints_status_.unlock();
@@ -1521,41 +1105,32 @@ bool AeroControllerNode::GetJointsCallback(
     aero_startup::AeroSendJoints::Request &_req,
     aero_startup::AeroSendJoints::Response &_res)
 {
-  mtx_upper_.lock();
-  mtx_lower_.lock();
 
   int number_of_angle_joints =
       upper_.get_number_of_angle_joints() +
       lower_.get_number_of_angle_joints();
 
-  std::thread t1([&](){
-      if (_req.reset_status) { // reset status if flag
+  CommandCompletion done;
+  if (_req.reset_status) { // reset status if flag
+    upper_bus_.post(PRIORITY_CONFIG, [this](){
         usleep(20000); // 20ms sleep before next command
         upper_.reset_status();
         usleep(20000); // 20ms sleep before next command
-      }
-    });
-
-  std::thread t2([&](){
-      if (_req.reset_status) { // reset status if flag
+      }, &done);
+    lower_bus_.post(PRIORITY_CONFIG, [this](){
         usleep(20000); // 20ms sleep before next command
         lower_.reset_status();
         usleep(20000); // 20ms sleep before next command
-      }
-    });
+      }, &done);
+    done.wait();
+  }
 
-  t1.join();
-  t2.join();
-
-  // commands take 20ms sleep, threading to save time
-  std::thread t3([&](){
-      upper_.update_position();
-    });
-  std::thread t4([&](){
-      lower_.update_position();
-    });
-  t3.join();
-  t4.join();
+  // commands take 20ms sleep, both buses run in parallel
+  upper_bus_.post(PRIORITY_TELEMETRY,
+                  [this](){ upper_.update_position(); }, &done);
+  lower_bus_.post(PRIORITY_TELEMETRY,
+                  [this](){ lower_.update_position(); }, &done);
+  done.wait();
 
   // print status for debug
   // upper_.update_status();
@@ -1597,7 +1172,7 @@ bool AeroControllerNode::GetJointsCallback(
   // convert to actual angle positions
   std::vector<int16_t> actual_strokes(actual_stroke_state.begin(),
                                       actual_stroke_state.end());
-  common::Stroke2Angle(_res.points.positions, actual_strokes);
+  Stroke2Angle(_res.points.positions, actual_strokes);
 
   // get joint names (auto-generated function)
   common::AngleJointNames(_res.joint_names);
@@ -1606,8 +1181,5 @@ bool AeroControllerNode::GetJointsCallback(
   std_msgs::Bool status_flag;
   _res.status = upper_.get_status() || lower_.get_status();
 
-  mtx_upper_.unlock();
-  mtx_lower_.unlock();
-
   return true;
 }
@@ -20,8 +20,13 @@
 #include "aero_hardware_interface/Stroke2Angle.hh"
 #include "aero_hardware_interface/Angle2Stroke.hh"
 #include "aero_hardware_interface/UnusedAngle2Stroke.hh"
+#include "aero_hardware_interface/Angle2StrokeBatch.hh"
+#include "aero_hardware_interface/ConversionTables.hh"
 
 #include "aero_hardware_interface/Interpolation.hh"
+#include "aero_hardware_interface/StrokeSpline.hh"
+#include "aero_hardware_interface/BusDispatcher.hh"
+#include "aero_hardware_interface/TrajectoryScheduler.hh"
 
 #include <ros/ros.h>
 #include <trajectory_msgs/JointTrajectory.h>
@@ -64,32 +69,6 @@ namespace aero
   namespace controller
   {
 
-    /// @brief Handles kill running joint trajectory threads.
-    struct thread_info
-    {
-      uint id;
-
-      std::vector<int> joints;
-
-      bool kill;
-    };
-
-    /// @brief Handles copy killed joint trajectory threads.
-    struct killed_thread_info
-    {
-      std::vector<std::pair<std::vector<int16_t>, uint16_t> > trajectories;
-
-      std::vector<aero::interpolation::InterpolationPtr> interpolation;
-
-      int at_trajectory_num;
-
-      int at_split_num;
-
-      uint thread_id;
-
-      float factor; // for speed overwrite
-    };
-
     /// @brief Aero controller node,
     /// has AeroUpperController and AeroLowerController
     class AeroControllerNode
@@ -108,26 +87,23 @@ namespace aero
     // private: void GoVelocityCallback(
     //     const geometry_msgs::Twist::ConstPtr& _msg);
 
-      /// @brief joint tracjectory threads created from callback
-      /// @param _interpolaiton information on how to interpolate
-      /// @param _stroke_trajectory information of trajectory
-      /// @param _trajectory_start_from skips trajectory
-      /// @param _split_start_from skips split for first trajectory
-      /// @param _factor current speed factor (for speed overwrite)
-    private: void JointTrajectoryThread(
-        std::vector<aero::interpolation::InterpolationPtr> _interpolation,
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory,
-        int _trajectory_start_from,
-        int _split_start_from, float _factor=1.0f);
-
-    private: void LowerTrajectoryThread(
-        std::vector<std::pair<std::vector<int16_t>, uint16_t> > _stroke_trajectory);
+      /// @brief checked by upper_scheduler_ before each frame,
+      ///   resets status on collision if collision_abort_mode_ is 1
+      /// @return true to abort upper trajectories
+    private: bool CollisionAbort();
 
       /// @brief subscribe joint tracjectory
       /// @param _msg joint trajectory
     private: void JointTrajectoryCallback(
         const trajectory_msgs::JointTrajectory::ConstPtr& _msg);
 
+      /// @brief subscribe streamed upper joint trajectory (teleoperation),
+      ///   appended to the running stream of the same joints
+      ///   stream_lookahead_usec_ after arrival
+      /// @param _msg joint trajectory, time relative to arrival
+    private: void JointTrajectoryStreamCallback(
+        const trajectory_msgs::JointTrajectory::ConstPtr& _msg);
+
       /// @brief publish joint state, called by timer,
       /// main routine is implemented in JointStateOnce().
       /// @param _event timer event
@@ -140,6 +116,11 @@ namespace aero
       /// whether trajectories are in action or not.
     private: void PublishInAction(const ros::TimerEvent& event);
 
+      /// @brief publish to /node_ns/preemption_latency the time [ms]
+      ///   from trajectories submitted since the last call
+      ///   until they were sent to the bus, called by PublishInAction
+    private: void PublishPreemptionLatency();
+
       /// @brief subscribe wheel servo message
       /// @param _msg true: on, false :off
     private: void WheelServoCallback(
@@ -185,12 +166,39 @@ namespace aero
         aero_startup::GraspControl::Request& _req,
         aero_startup::GraspControl::Response& _res);
 
+      /// @brief conversions of tables_ if loaded, generated functions if not
+    private: void Angle2Stroke(std::vector<int16_t>& _strokes,
+                               const std::vector<double>& _angles);
+
+    private: void UnusedAngle2Stroke(std::vector<int16_t>& _strokes,
+                                     const std::vector<bool>& _angles);
+
+    private: void Stroke2Angle(std::vector<double>& _angles,
+                               const std::vector<int16_t>& _strokes);
+
     private: AeroUpperController upper_;
 
     private: AeroLowerController lower_;
 
+      /// @brief I/O thread of upper bus, only this thread accesses upper_
+    private: BusDispatcher upper_bus_;
+
+      /// @brief I/O thread of lower bus, only this thread accesses lower_
+    private: BusDispatcher lower_bus_;
+
+      /// @brief sends upper trajectories through upper_bus_,
+      ///   JointStateOnce does not update current position while active
+    private: TrajectoryScheduler upper_scheduler_;
+
+      /// @brief sends lower trajectories through lower_bus_
+    private: TrajectoryScheduler lower_scheduler_;
+
     private: ros::NodeHandle nh_;
 
+      /// @brief runtime conversion tables (~conversion_tables param),
+      ///   nullptr to use generated functions
+    private: std::shared_ptr<common::ConversionTables> tables_;
+
     // private: ros::Subscriber cmdvel_sub_;
 
     private: ros::Subscriber jointtraj_sub_;
@@ -201,6 +209,22 @@ namespace aero
 
     private: ros::AsyncSpinner jointtraj_spinner_;
 
+    private: ros::Subscriber jointtraj_stream_sub_;
+
+    private: ros::SubscribeOptions jointtraj_stream_ops_;
+
+      /// @brief delay of streamed points to absorb jitter [usec]
+    private: int64_t stream_lookahead_usec_;
+
+      /// @brief time a stream holds its last point [usec]
+    private: int64_t stream_timeout_usec_;
+
+      /// @brief underruns already reported
+    private: size_t stream_underruns_;
+
+      /// @brief time from stream message to reaching its first point [ms]
+    private: ros::Publisher stream_latency_pub_;
+
     private: ros::Subscriber wheel_servo_sub_;
 
     private: ros::SubscribeOptions wheel_ops_;
@@ -221,6 +245,14 @@ namespace aero
 
     private: ros::Publisher in_action_pub_;
 
+    private: ros::Publisher preemption_latency_pub_;
+
+      /// @brief latencies of upper_scheduler_ already published
+    private: size_t upper_measured_;
+
+      /// @brief latencies of lower_scheduler_ already published
+    private: size_t lower_measured_;
+
     private: ros::Subscriber status_reset_sub_;
 
     private: ros::Subscriber collision_mode_set_sub_;
@@ -235,37 +267,18 @@ namespace aero
 
     private: ros::Timer timer_;
 
-    private: std::mutex mtx_upper_;
-
-    private: std::mutex mtx_lower_;
-
       /// @brief saved interpolation settings
     private: std::vector<aero::interpolation::InterpolationPtr> interpolation_;
 
     private: std::mutex mtx_intrpl_;
 
-      /// @brief info of on-going threads moving the upper body
-      ///   used to kill threads when interfered
-      ///   JointStateOnce does not update current position while threads > 0
-    private: std::vector<thread_info> registered_threads_;
-
-      /// @brief thread id count (increments every time new thread is created)
-      ///   used for applying thread id to new thread
-    private: uint global_thread_cnt_;
-
-    private: std::mutex mtx_threads_;
-
-      /// @brief info of killed thread moving the upper body
-      ///   used to copy and re-split threads when interfered
-    private: std::vector<killed_thread_info> thread_graveyard_;
+      /// @brief samples of each interpolation curve table,
+      ///   0 evaluates curves directly
+    private: int interpolation_table_size_;
 
-    private: std::mutex mtx_thread_graveyard_;
-
-    private: std::mutex mtx_lower_thread_;
-
-    private: thread_info lower_thread_;
-
-    private: killed_thread_info lower_killed_thread_info_;
+      /// @brief true to send upper trajectories as splines through
+      ///   all points (see StrokeSpline)
+    private: bool spline_trajectory_;
 
       // @brief wether sendJoints is active or not
     private: bool send_joints_status_;
@@ -287,10 +300,6 @@ namespace aero
 
     private: ros::Subscriber speed_overwrite_sub_;
 
-    private: std::mutex mtx_thread_postpone_;
-
-    private: bool thread_postpone_;
-
     private: void SpeedOverwriteCallback(
 	const std_msgs::Float32::ConstPtr& _msg);
     };
@@ -7,7 +7,8 @@ using namespace controller;
 //////////////////////////////////////////////////
 SEED485Controller::SEED485Controller(
     const std::string& _port, uint8_t _id) :
-  ser_(io_), verbose_(false), id_(_id)
+  ser_(io_), verbose_(false), id_(_id), strand_(io_), read_timer_(io_),
+  read_seq_(0), reading_(false), io_done_(false), io_size_(0)
 {
   if (_port == "") {
     std::cerr << "empty serial port name: entering debug mode...\n";
@@ -56,41 +57,42 @@ SEED485Controller::SEED485Controller(
   } catch (std::exception& e) {
     std::cerr << e.what() << "\n";
   }
+
+  // io thread for this bus, keeps running until destructor
+  work_.reset(new io_service::work(io_));
+  io_thread_ = boost::thread([this]() { io_.run(); });
 }
 
 //////////////////////////////////////////////////
 SEED485Controller::~SEED485Controller()
 {
+  work_.reset();
+  io_.stop();
+  if (io_thread_.joinable()) io_thread_.join();
+
   if (ser_.is_open()) ser_.close();
 }
 
 //////////////////////////////////////////////////
-void SEED485Controller::read(std::vector<uint8_t>& _read_data)
+bool SEED485Controller::read(SeedFrame& _read_data)
 {
-  _read_data.resize(RAW_DATA_LENGTH);
+  bool valid = false;
 
-  int size = 0;
   if (ser_.is_open()) {
     boost::mutex::scoped_lock lock(mtx_);
-    while(size < RAW_DATA_LENGTH) {
-      usleep(100); // sleep 100 us
-      int size_read;
-      std::vector<uint8_t> read_buffer(RAW_DATA_LENGTH);
-      size_read = ser_.read_some(buffer(read_buffer, RAW_DATA_LENGTH));
-      if ((size + size_read) <= RAW_DATA_LENGTH) {
-        std::copy(read_buffer.begin(), read_buffer.begin()+size_read,
-                  _read_data.begin() + size);
-      } else {
-        std::cerr << "Proto: ERROR: data length, size : " << size << ", size_read " << size_read << std::endl;
-        //flush();
-#if ((BOOST_VERSION / 100 % 1000) > 50)
-        ::tcflush(ser_.lowest_layer().native_handle(), TCIOFLUSH);
-#else  // 12.04
-        ::tcflush(ser_.lowest_layer().native(), TCIOFLUSH);
-#endif
-        break;
-      }
-      size += size_read;
+    io_done_ = false;
+    async_read(_read_data,
+               [this](const boost::system::error_code& _err, size_t _size) {
+                 notify_io_(_err, _size);
+               });
+    size_t size;
+    boost::system::error_code err = wait_io_(size);
+    if (err) {
+      // partial bytes are kept in parser_ and dropped on next resync
+      std::cerr << "Proto: ERROR: read failed, "
+                << err.message() << std::endl;
+    } else {
+      valid = true;
     }
   }
 
@@ -104,11 +106,121 @@ void SEED485Controller::read(std::vector<uint8_t>& _read_data)
     }
     std::cout << "\n";
   }
+
+  return valid;
+}
+
+//////////////////////////////////////////////////
+void SEED485Controller::async_read(SeedFrame& _read_data,
+                                   IoHandler _handler)
+{
+  strand_.post(make_seed_alloc_handler(post_memory_,
+                                       [this, &_read_data, _handler]() {
+      uint32_t seq = ++read_seq_;
+      reading_ = true;
+
+      // cancel read if no response arrives in time
+      read_timer_.expires_from_now(
+          boost::posix_time::milliseconds(SEED_READ_TIMEOUT_MS));
+      read_timer_.async_wait(strand_.wrap(make_seed_alloc_handler(
+          timer_memory_,
+          [this, seq](const boost::system::error_code& _err) {
+            if (!_err && reading_ && seq == read_seq_) {
+              boost::system::error_code ignored;
+              ser_.cancel(ignored);
+            }
+          })));
+
+      receive_(&_read_data, _handler);
+    }));
+}
+
+//////////////////////////////////////////////////
+void SEED485Controller::receive_(SeedFrame* _read_data,
+                                 IoHandler _handler)
+{
+  if (parser_.pop(*_read_data)) {
+    reading_ = false;
+    read_timer_.cancel();
+    _handler(boost::system::error_code(), _read_data->size());
+    return;
+  }
+
+  ser_.async_read_some(buffer(rx_buffer_),
+      strand_.wrap(make_seed_alloc_handler(
+          read_memory_,
+          [this, _read_data, _handler](const boost::system::error_code& _err,
+                                       size_t _size) {
+            parser_.push(rx_buffer_.data(), _size);
+            if (capture_ && _size > 0)
+              capture_->record(SEED_CAPTURE_RX, rx_buffer_.data(), _size);
+            if (_err) {
+              reading_ = false;
+              read_timer_.cancel();
+              _handler(_err, 0);
+              return;
+            }
+            receive_(_read_data, _handler);
+          })));
+}
+
+//////////////////////////////////////////////////
+void SEED485Controller::async_send_data(SeedFrame& _send_data,
+                                        IoHandler _handler)
+{
+  strand_.post(make_seed_alloc_handler(post_memory_,
+                                       [this, &_send_data, _handler]() {
+      // bytes left from previous responses cannot answer this request
+      parser_.clear();
+      if (capture_) capture_->record(SEED_CAPTURE_TX, _send_data);
+      boost::asio::async_write(ser_,
+                               buffer(_send_data.data(), _send_data.size()),
+                               strand_.wrap(make_seed_alloc_handler(
+                                   write_memory_, _handler)));
+    }));
+}
+
+//////////////////////////////////////////////////
+bool SEED485Controller::start_capture(const std::string& _file)
+{
+  if (!ser_.is_open()) return false;
+
+  std::shared_ptr<SeedCapture> capture(new SeedCapture());
+  if (!capture->open(_file)) return false;
+  strand_.post([this, capture]() { capture_ = capture; });
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SEED485Controller::stop_capture()
+{
+  if (!ser_.is_open()) return;
+  strand_.post([this]() { capture_.reset(); });
+}
+
+//////////////////////////////////////////////////
+boost::system::error_code SEED485Controller::wait_io_(size_t& _size)
+{
+  boost::mutex::scoped_lock lock(io_mtx_);
+  while (!io_done_) io_cond_.wait(lock);
+  _size = io_size_;
+  return io_err_;
+}
+
+//////////////////////////////////////////////////
+void SEED485Controller::notify_io_(const boost::system::error_code& _err,
+                                   size_t _size)
+{
+  boost::mutex::scoped_lock lock(io_mtx_);
+  io_err_ = _err;
+  io_size_ = _size;
+  io_done_ = true;
+  io_cond_.notify_one();
 }
 
 //////////////////////////////////////////////////
 void SEED485Controller::send_command(
-    uint8_t _cmd, uint16_t _time, std::vector<uint8_t>& _send_data)
+    uint8_t _cmd, uint16_t _time, SeedFrame& _send_data)
 {
   send_command(_cmd, 0x00, _time, _send_data);
 }
@@ -117,51 +229,29 @@ void SEED485Controller::send_command(
 void SEED485Controller::send_command(
     uint8_t _cmd, uint8_t _num, uint16_t _data)
 {
-  std::vector<uint8_t> data(8);
-  data[0] = 0xFD;
-  data[1] = 0xDF;
-  data[2] = 0x04;
-  data[3] = _cmd;
-  data[4] = _num;
+  SeedFrame data(SHORT_DATA_LENGTH);
+  data.set_header(_cmd, _num);
   data[5] = static_cast<uint8_t>(0xff & (_data >> 8));
   data[6] = static_cast<uint8_t>(0xff & _data);
 
   // check sum
-  int32_t b_check_sum = 0;
-
-  for (size_t i = 2; i < data.size() - 1; ++i) {
-    b_check_sum += data[i];
-  }
-
-  data[data.size() - 1] =
-    ~(reinterpret_cast<uint8_t*>(&b_check_sum)[0]);
+  data.set_checksum();
 
   send_data(data);
 }
 
 //////////////////////////////////////////////////
 void SEED485Controller::send_command(
-    uint8_t _cmd, uint8_t _sub, uint16_t _time, std::vector<uint8_t>& _send_data)
+    uint8_t _cmd, uint8_t _sub, uint16_t _time, SeedFrame& _send_data)
 {
-  _send_data[0] = 0xFD;
-  _send_data[1] = 0xDF;
-  _send_data[2] = 0x40;
-  _send_data[3] = _cmd;
-  _send_data[4] = _sub;
+  _send_data.resize(RAW_DATA_LENGTH);
+  _send_data.set_header(_cmd, _sub);
 
   //  time (2 bytes)
-  _send_data[65] = static_cast<uint8_t>(0xff & (_time >> 8));
-  _send_data[66] = static_cast<uint8_t>(0xff & _time);
+  _send_data.set_time(_time);
 
   // check sum
-  int32_t b_check_sum = 0;
-
-  for (size_t i = 2; i < RAW_DATA_LENGTH - 1; ++i) {
-    b_check_sum += _send_data[i];
-  }
-
-  _send_data[RAW_DATA_LENGTH - 1] =
-    ~(reinterpret_cast<uint8_t*>(&b_check_sum)[0]);
+  _send_data.set_checksum();
 
   send_data(_send_data);
 }
@@ -176,7 +266,7 @@ void SEED485Controller::AERO_Snd_Script(uint16_t sendnum,uint8_t scriptnum)
               <<"] / hand script: " << sendnum
               << ", " << (int)scriptnum << std::endl;
   }
-  std::vector<uint8_t> dat(8);
+  SeedFrame dat(SHORT_DATA_LENGTH);
   dat[0] = 0xfd;  // header
   dat[1] = 0xdf;  // header
   dat[2] = 0x04;  // data length
@@ -198,15 +288,27 @@ void SEED485Controller::flush()
 #else  // 12.04
     ::tcflush(ser_.lowest_layer().native(), TCIOFLUSH);
 #endif
+    strand_.post([this]() { parser_.clear(); });
   }
 }
 
 //////////////////////////////////////////////////
-void SEED485Controller::send_data(std::vector<uint8_t>& _send_data)
+void SEED485Controller::send_data(SeedFrame& _send_data)
 {
   if (ser_.is_open()) {
     boost::mutex::scoped_lock lock(mtx_);
-    ser_.write_some(buffer(_send_data));
+    io_done_ = false;
+    async_send_data(
+        _send_data,
+        [this](const boost::system::error_code& _err, size_t _size) {
+          notify_io_(_err, _size);
+        });
+    size_t size;
+    boost::system::error_code err = wait_io_(size);
+    if (err) {
+      std::cerr << "Proto: ERROR: write failed, size : " << size
+                << ", " << err.message() << std::endl;
+    }
   }
 
   if (verbose_) {
@@ -250,11 +352,12 @@ void AeroControllerProto::servo_command(int16_t _d0)
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
 
-  std::vector<int16_t> stroke_vector(stroke_joint_indices_.size(), _d0);
-
-  std::vector<uint8_t> dat(RAW_DATA_LENGTH);
+  SeedFrame dat;
 
-  stroke_to_raw_(stroke_vector, dat);
+  for (size_t i = 0; i < stroke_joint_indices_.size(); ++i) {
+    AJointIndex& aji = stroke_joint_indices_[i];
+    encode_short_(_d0, &dat[RAW_HEADER_OFFSET + aji.raw_index * 2]);
+  }
 
   seed_.send_command(CMD_MOTOR_SRV, 0, dat);
 }
@@ -262,13 +365,25 @@ void AeroControllerProto::servo_command(int16_t _d0)
 //////////////////////////////////////////////////
 std::vector<int16_t> AeroControllerProto::get_reference_stroke_vector()
 {
-  return stroke_ref_vector_;
+  StrokeState state;
+  if (!get_state(state)) return std::vector<int16_t>();
+  return std::vector<int16_t>(state.reference.begin(),
+                              state.reference.begin() + state.size);
 }
 
 //////////////////////////////////////////////////
 std::vector<int16_t> AeroControllerProto::get_actual_stroke_vector()
 {
-  return stroke_cur_vector_;
+  StrokeState state;
+  if (!get_state(state)) return std::vector<int16_t>();
+  return std::vector<int16_t>(state.actual.begin(),
+                              state.actual.begin() + state.size);
+}
+
+//////////////////////////////////////////////////
+bool AeroControllerProto::get_state(StrokeState& _state) const
+{
+  return snapshot_.read(_state);
 }
 
 //////////////////////////////////////////////////
@@ -314,13 +429,18 @@ bool AeroControllerProto::get_joint_name(int32_t _joint_id, std::string &_name)
 //////////////////////////////////////////////////
 bool AeroControllerProto::get_status()
 {
-  return bad_status_;
+  StrokeState state;
+  if (!get_state(state)) return false;
+  return state.bad_status;
 }
 
 //////////////////////////////////////////////////
 std::vector<int16_t> AeroControllerProto::get_status_vec()
 {
-  return status_vector_;
+  StrokeState state;
+  if (!get_state(state)) return std::vector<int16_t>();
+  return std::vector<int16_t>(state.status.begin(),
+                              state.status.begin() + state.size);
 }
 
 //////////////////////////////////////////////////
@@ -334,9 +454,11 @@ bool AeroControllerProto::get_status(std::vector<bool>& _status_vector)
 void AeroControllerProto::update_position()
 {
   if (seed_.is_debug_mode()) {
+    boost::mutex::scoped_lock lock(ctrl_mtx_);
     // just return ref_vector in debug mode
     stroke_cur_vector_.assign(stroke_ref_vector_.begin(),
                               stroke_ref_vector_.end());
+    publish_state_();
   } else {
     //seed_.flush();
     get_command(CMD_GET_POS, stroke_cur_vector_);
@@ -371,26 +493,33 @@ void AeroControllerProto::get_temperature(
 }
 
 //////////////////////////////////////////////////
-void AeroControllerProto::get_data(std::vector<int16_t>& _stroke_vector)
+bool AeroControllerProto::get_data(std::vector<int16_t>& _stroke_vector)
 {
-  std::vector<uint8_t> dat;
-  dat.resize(RAW_DATA_LENGTH);
+  SeedFrame dat;
+
+  // header and checksum are already checked by the parser
+  if (!seed_.read(dat)) return false;
 
-  seed_.read(dat);
+  return decode_frame(dat, _stroke_vector);
+}
 
-  uint16_t header = decode_short_(&dat[0]);
+//////////////////////////////////////////////////
+bool AeroControllerProto::decode_frame(const SeedFrame& _dat,
+                                       std::vector<int16_t>& _stroke_vector)
+{
   int16_t cmd;
   uint8_t* bvalue = reinterpret_cast<uint8_t*>(&cmd);
-  bvalue[0] = dat[3];
+  bvalue[0] = _dat[3];
   bvalue[1] = 0x00;
 
-  if (header != 0xdffd) {
-    seed_.flush();
-    std::cerr << "Proto: ERROR: invalid header" << std::endl;
-    return;
+  if (_dat.size() != RAW_DATA_LENGTH) {
+    std::cerr << "Proto: ERROR: unexpected short frame" << std::endl;
+    return false;
   }
 
+  bool has_strokes = false;
   if (cmd == CMD_MOVE_ABS_POS ||
+      cmd == CMD_MOVE_ABS_POS_RET ||
       cmd == CMD_GET_POS ||
       cmd == CMD_GET_CUR ||
       cmd == CMD_GET_TMP ||
@@ -403,7 +532,7 @@ void AeroControllerProto::get_data(std::vector<int16_t>& _stroke_vector)
       AJointIndex& aji = stroke_joint_indices_[i];
       // uint8_t -> uint16_t
       _stroke_vector[aji.stroke_index] =
-        decode_short_(&dat[RAW_HEADER_OFFSET + aji.raw_index * 2]);
+        decode_short_(&_dat[RAW_HEADER_OFFSET + aji.raw_index * 2]);
 
       // check value
       if (_stroke_vector[aji.stroke_index] > 0x7fff) {
@@ -412,12 +541,13 @@ void AeroControllerProto::get_data(std::vector<int16_t>& _stroke_vector)
         _stroke_vector[aji.stroke_index] = 0;
       }
     }
+    has_strokes = true;
   }
 
   // if (cmd == CMD_MOVE_ABS || cmd == CMD_WATCH_MISSTEP || cmd == CMD_GET_POS) {
   if (cmd == CMD_WATCH_MISSTEP) {
-    uint8_t status0 = dat[RAW_HEADER_OFFSET + 60];
-    uint8_t status1 = dat[RAW_HEADER_OFFSET + 61];
+    uint8_t status0 = _dat[RAW_HEADER_OFFSET + 60];
+    uint8_t status1 = _dat[RAW_HEADER_OFFSET + 61];
     if ((status0 >> 5) == 1 || (status1 >> 5) == 1) {
       bad_status_ = true;
     } else {
@@ -425,6 +555,7 @@ void AeroControllerProto::get_data(std::vector<int16_t>& _stroke_vector)
     }
   }
 
+  return has_strokes;
 }
 
 //////////////////////////////////////////////////
@@ -440,14 +571,15 @@ void AeroControllerProto::get_command(uint8_t _cmd, uint8_t _sub,
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
 
-  std::vector<uint8_t> dat(RAW_DATA_LENGTH);
+  SeedFrame dat;
   seed_.send_command(_cmd, _sub, 0, dat);
   //usleep(1000 * 20);  // wait
   get_data(_stroke_vector);
+  publish_state_();
 }
 
 //////////////////////////////////////////////////
-void AeroControllerProto::set_position(
+bool AeroControllerProto::set_position(
     std::vector<int16_t>& _stroke_vector, uint16_t _time)
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
@@ -460,7 +592,7 @@ void AeroControllerProto::set_position(
   }
 
   // for seed
-  std::vector<uint8_t> dat(RAW_DATA_LENGTH);
+  SeedFrame dat;
   stroke_to_raw_(_stroke_vector, dat);
   //seed_.flush();
   seed_.send_command(CMD_MOVE_ABS_POS_RET, _time, dat);
@@ -472,9 +604,13 @@ void AeroControllerProto::set_position(
     // and controller must copy ref_vector into cur_vector
     stroke_cur_vector_.assign(stroke_ref_vector_.begin(),
                               stroke_ref_vector_.end());
-  } else {
-    get_data(stroke_cur_vector_);
+    publish_state_();
+    return true;
   }
+
+  bool replied = get_data(stroke_cur_vector_);
+  publish_state_();
+  return replied;
 }
 
 //////////////////////////////////////////////////
@@ -491,7 +627,7 @@ void AeroControllerProto::set_position_no_wait(
   }
 
   // for seed
-  std::vector<uint8_t> dat(RAW_DATA_LENGTH);
+  SeedFrame dat;
   stroke_to_raw_(_stroke_vector, dat);
   //seed_.flush();
   seed_.send_command(CMD_MOVE_ABS_POS, _time, dat);
@@ -506,6 +642,7 @@ void AeroControllerProto::set_position_no_wait(
     // no return
     //get_data(stroke_cur_vector_);
   }
+  publish_state_();
 }
 
 //////////////////////////////////////////////////
@@ -549,14 +686,21 @@ void AeroControllerProto::set_command(uint8_t _cmd,
 {
   boost::mutex::scoped_lock lock(ctrl_mtx_);
 
-  std::vector<uint8_t> dat(RAW_DATA_LENGTH);
+  SeedFrame dat;
   stroke_to_raw_(_stroke_vector, dat);
   seed_.send_command(_cmd, 0, dat);
 }
 
+//////////////////////////////////////////////////
+void AeroControllerProto::publish_state_()
+{
+  snapshot_.publish(stroke_ref_vector_, stroke_cur_vector_,
+                    status_vector_, bad_status_);
+}
+
 //////////////////////////////////////////////////
 void AeroControllerProto::stroke_to_raw_(std::vector<int16_t>& _stroke,
-                                         std::vector<uint8_t>& _raw)
+                                         SeedFrame& _raw)
 {
   for (size_t i = 0; i < stroke_joint_indices_.size(); ++i) {
     AJointIndex& aji = stroke_joint_indices_[i];
@@ -567,7 +711,7 @@ void AeroControllerProto::stroke_to_raw_(std::vector<int16_t>& _stroke,
 }
 
 //////////////////////////////////////////////////
-int16_t aero::controller::decode_short_(uint8_t* _raw)
+int16_t aero::controller::decode_short_(const uint8_t* _raw)
 {
   int16_t value;
   uint8_t* bvalue = reinterpret_cast<uint8_t*>(&value);
@@ -10,14 +10,23 @@
 #include <unistd.h>
 #include <unordered_map>
 #include <cmath>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <type_traits>
 
 #include <boost/asio.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 #include "aero_hardware_interface/CommandList.hh"
 #include "aero_hardware_interface/Constants.hh"
 #include "aero_hardware_interface/AJointIndex.hh"
+#include "aero_hardware_interface/SeedFrame.hh"
+#include "aero_hardware_interface/SeedFrameParser.hh"
+#include "aero_hardware_interface/StrokeSnapshot.hh"
+#include "aero_hardware_interface/SeedCapture.hh"
 
 using namespace boost::asio;
 
@@ -25,9 +34,83 @@ namespace aero
 {
   namespace controller
   {
+    /// @brief timeout for a response from SEED controller [ms]
+    const static int SEED_READ_TIMEOUT_MS = 50;
+
+    /// @brief storage for one asio handler,
+    ///   falls back to heap if it is in use or too small
+    class SeedHandlerMemory
+    {
+     public: SeedHandlerMemory() : in_use_(false) {}
+
+     public: void* allocate(size_t _size)
+      {
+        if (_size <= sizeof(storage_) && !in_use_.exchange(true))
+          return &storage_;
+        return ::operator new(_size);
+      }
+
+     public: void deallocate(void* _ptr)
+      {
+        if (_ptr == &storage_) in_use_ = false;
+        else ::operator delete(_ptr);
+      }
+
+     private: std::aligned_storage<256>::type storage_;
+
+     private: std::atomic<bool> in_use_;
+    };
+
+    /// @brief handler wrapper making asio allocate from SeedHandlerMemory
+    template <typename Handler> class SeedAllocHandler
+    {
+     public: SeedAllocHandler(SeedHandlerMemory& _memory, Handler _handler) :
+        memory_(_memory), handler_(_handler)
+      {
+      }
+
+     public: template <typename... Args> void operator()(Args&&... _args)
+      {
+        handler_(std::forward<Args>(_args)...);
+      }
+
+     public: friend void* asio_handler_allocate(size_t _size,
+                                                SeedAllocHandler* _this)
+      {
+        return _this->memory_.allocate(_size);
+      }
+
+     public: friend void asio_handler_deallocate(void* _ptr, size_t,
+                                                 SeedAllocHandler* _this)
+      {
+        _this->memory_.deallocate(_ptr);
+      }
+
+     private: SeedHandlerMemory& memory_;
+
+     private: Handler handler_;
+    };
+
+    template <typename Handler>
+    SeedAllocHandler<Handler> make_seed_alloc_handler(
+        SeedHandlerMemory& _memory, Handler _handler)
+    {
+      return SeedAllocHandler<Handler>(_memory, _handler);
+    }
+
     /// @brief SEED controller via USB/RS485
+    ///
+    /// Serial I/O runs on a per-bus io_service thread.
+    /// Reads and writes are posted to a strand and completed
+    /// by asio handlers instead of polling the port.
+    /// Received bytes go through SeedFrameParser, so a partial or
+    /// misaligned response is skipped without flushing the port.
     class SEED485Controller
     {
+      /// @brief handler called on io thread when a transfer completes
+     public: typedef std::function<void(const boost::system::error_code&,
+                                        size_t)> IoHandler;
+
       /// @brief constructor
       /// @param _port USB port file name
       /// @param _id CAN bus ID
@@ -36,15 +119,25 @@ namespace aero
       /// @brief destructor
      public: ~SEED485Controller();
 
-      /// @brief read from SEED controller
-     public: void read(std::vector<uint8_t>& _read_data);
+      /// @brief read from SEED controller,
+      ///   blocks until one response arrives or SEED_READ_TIMEOUT_MS passes
+      /// @return false if no valid frame arrived
+     public: bool read(SeedFrame& _read_data);
+
+      /// @brief start reading one response from SEED controller
+      /// @param _read_data buffer, must be valid until _handler is called,
+      ///   resized to the received frame length
+      /// @param _handler called on io thread when read completes,
+      ///   operation_aborted is passed on timeout
+     public: void async_read(SeedFrame& _read_data,
+                             IoHandler _handler);
 
       /// @brief send command to SEED controller
       /// @param _cmd Command ID
       /// @param _time Destination time
       /// @param _send_data data buffer
      public: void send_command(uint8_t _cmd, uint16_t _time,
-                               std::vector<uint8_t>& _send_data);
+                               SeedFrame& _send_data);
 
       /// @brief send single command to SEED controller
       /// @param _cmd Command ID
@@ -53,7 +146,7 @@ namespace aero
      public: void send_command(uint8_t _cmd, uint8_t _num, uint16_t _data);
 
      public: void send_command(uint8_t _cmd, uint8_t _sub, uint16_t _time,
-                               std::vector<uint8_t>& _send_data);
+                               SeedFrame& _send_data);
 
       /// @brief send_executing script command
      public: void AERO_Snd_Script(uint16_t sendnum, uint8_t scriptnum);
@@ -63,7 +156,13 @@ namespace aero
 
       /// @brief send raw data to SEED controller
       /// @param _send_data raw data buffer
-     public: void send_data(std::vector<uint8_t>& _send_data);
+     public: void send_data(SeedFrame& _send_data);
+
+      /// @brief start writing raw data to SEED controller
+      /// @param _send_data raw data buffer, must be valid until _handler is called
+      /// @param _handler called on io thread when write completes
+     public: void async_send_data(SeedFrame& _send_data,
+                                  IoHandler _handler);
 
       /// @brief set / unset verbose mode
       /// @param val verbose mode
@@ -76,6 +175,25 @@ namespace aero
       /// @return true if in debug mode
      public: bool is_debug_mode() {return !ser_.is_open();}
 
+      /// @brief record sent commands and received bytes to a file
+      /// @param _file capture file name
+      /// @return false in debug mode or if file could not be created
+     public: bool start_capture(const std::string& _file);
+
+      /// @brief stop recording, flushes on io thread
+     public: void stop_capture();
+
+      /// @brief pop a frame from parser_ or keep reading, called on strand_
+     private: void receive_(SeedFrame* _read_data,
+                            IoHandler _handler);
+
+      /// @brief wait for completion of a transfer posted to io thread
+     private: boost::system::error_code wait_io_(size_t& _size);
+
+      /// @brief io handler used by blocking read / send_data
+     private: void notify_io_(const boost::system::error_code& _err,
+                              size_t _size);
+
      private: io_service io_;
 
      private: serial_port ser_;
@@ -85,6 +203,49 @@ namespace aero
      private: bool verbose_;
 
      private: boost::mutex mtx_;
+
+      /// @brief serializes all operations on ser_
+     private: io_service::strand strand_;
+
+     private: deadline_timer read_timer_;
+
+      /// @brief incremented for every read, used to ignore stale timeouts
+     private: uint32_t read_seq_;
+
+     private: bool reading_;
+
+      /// @brief accessed only on strand_
+     private: SeedFrameParser parser_;
+
+     private: std::array<uint8_t, RAW_DATA_LENGTH> rx_buffer_;
+
+      /// @brief handler storage, one for each kind of pending operation
+      ///   so the read and write cycle does not allocate
+     private: SeedHandlerMemory post_memory_;
+
+     private: SeedHandlerMemory read_memory_;
+
+     private: SeedHandlerMemory write_memory_;
+
+     private: SeedHandlerMemory timer_memory_;
+
+      /// @brief bus traffic recorder, accessed only on strand_
+     private: std::shared_ptr<SeedCapture> capture_;
+
+     private: std::unique_ptr<io_service::work> work_;
+
+     private: boost::thread io_thread_;
+
+      /// @brief completion state of blocking read / send_data
+     private: boost::mutex io_mtx_;
+
+     private: boost::condition_variable io_cond_;
+
+     private: bool io_done_;
+
+     private: boost::system::error_code io_err_;
+
+     private: size_t io_size_;
     };  // SEED485Controller
 
     /// @brief super class of body controller,
@@ -115,6 +276,12 @@ namespace aero
 
      public: std::vector<int16_t> get_status_vec();
 
+      /// @brief copy latest reference, actual strokes and status,
+      ///   does not take ctrl_mtx_ and does not allocate
+      /// @param _state output state
+      /// @return false if no consistent state could be read
+     public: bool get_state(StrokeState& _state) const;
+
      public: std::string get_stroke_joint_name(size_t _idx);
 
      public: int get_number_of_angle_joints();
@@ -146,10 +313,27 @@ namespace aero
       /// @param _stroke_vector stroke vector
      public: void get_temperature(std::vector<int16_t>& _stroke_vector);
 
+      /// @brief record bus traffic to a file, see SeedCapture
+     public: bool start_capture(const std::string& _file)
+      {
+        return seed_.start_capture(_file);
+      }
+
+     public: void stop_capture() {seed_.stop_capture();}
+
+      /// @brief decode a response into strokes and status,
+      ///   used by get_data and to replay captured traffic
+      /// @param _dat frame with valid header and checksum
+      /// @param _stroke_vector stroke vector
+      /// @return true if a response with strokes was written to _stroke_vector
+     public: bool decode_frame(const SeedFrame& _dat,
+                               std::vector<int16_t>& _stroke_vector);
+
       /// @brief get data from buffer,
       ///   this does not call command, but only read from buffer
       /// @param _stroke_vector stroke vector
-     protected: void get_data(std::vector<int16_t>& _stroke_vector);
+      /// @return true if a response with strokes was written to _stroke_vector
+     protected: bool get_data(std::vector<int16_t>& _stroke_vector);
 
       /// @brief abstract of get commands
       /// @param _cmd command id
@@ -163,7 +347,9 @@ namespace aero
       /// @brief set position command (waiting return of current position)
       /// @param _stroke_vector stroke vector, MUST be DOF bytes
       /// @param _time time[ms]
-     public: void set_position(std::vector<int16_t>& _stroke_vector,
+      /// @return true if the returned current position was stored,
+      ///   then the actual stroke vector is as new as after update_position
+     public: bool set_position(std::vector<int16_t>& _stroke_vector,
                                uint16_t _time);
 
       /// @brief set position command (no wait)
@@ -195,9 +381,13 @@ namespace aero
      protected: void set_command(uint8_t _cmd,
                                  std::vector<int16_t>& _stroke_vector);
 
+      /// @brief publish stroke vectors and status to snapshot_,
+      ///   must be called with ctrl_mtx_ locked
+     protected: void publish_state_();
+
       /// @brief stoke_vector to raw command bytes
      protected: void stroke_to_raw_(std::vector<int16_t>& _stroke,
-                                    std::vector<uint8_t>& _raw);
+                                    SeedFrame& _raw);
 
      protected: bool verbose_;
 
@@ -217,6 +407,9 @@ namespace aero
 
      protected: bool bad_status_;
 
+      /// @brief state for readers outside of bus thread
+     protected: StrokeSnapshot snapshot_;
+
      protected:
       std::unordered_map<std::string, int32_t> angle_joint_indices_;
     };  // AeroControllerProto
@@ -226,7 +419,7 @@ namespace aero
   /////////////////////
 
   /// @brief decode short(int16_t) from byte(uint8_t)
-  int16_t decode_short_(uint8_t* _raw);
+  int16_t decode_short_(const uint8_t* _raw);
 
   /// @brief ecnode short(int16_t) to byte(uint8_t)
   void encode_short_(int16_t _value, uint8_t* _raw);
@@ -0,0 +1,75 @@
+#include <cmath>
+#include <algorithm>
+
+#include "aero_hardware_interface/Angle2StrokeBatch.hh"
+#include "aero_hardware_interface/Constants.hh"
+#include "aero_hardware_interface/Angle2Stroke.hh"
+#include "aero_hardware_interface/UnusedAngle2Stroke.hh"
+#include "aero_hardware_interface/ConversionTables.hh"
+
+using namespace aero;
+using namespace controller;
+
+//////////////////////////////////////////////////
+void common::Angle2StrokeBatch
+(const std::vector<double>& _angles, const std::vector<bool>& _send,
+ std::vector<int16_t>& _upper, std::vector<int16_t>& _lower,
+ const ConversionTables* _tables)
+{
+  const size_t joints = _send.size();
+  const size_t points = (joints > 0 ? _angles.size() / joints : 0);
+  _upper.resize(points * AERO_DOF_UPPER);
+  _lower.resize(points * AERO_DOF_LOWER);
+
+  // no-send strokes of unused joints, same for all points
+  std::vector<int16_t> unused(AERO_DOF, 0);
+  if (_tables)
+    _tables->UnusedAngle2Stroke(unused, _send);
+  else
+    common::UnusedAngle2Stroke(unused, _send);
+
+  // only for points with cancelled joints
+  std::vector<double> cancel_angles(joints);
+  std::vector<bool> cancel_send;
+  std::vector<int16_t> cancel(AERO_DOF);
+
+  int16_t strokes[AERO_DOF];
+
+  for (size_t n = 0; n < points; ++n) {
+    const double* angles = _angles.data() + n * joints;
+    const int16_t* no_send = unused.data();
+
+    size_t nan = 0;
+    while (nan < joints && !std::isnan(angles[nan])) ++nan;
+    if (nan < joints) {
+      cancel_send = _send;
+      for (size_t j = 0; j < joints; ++j) {
+        if (std::isnan(angles[j])) {
+          cancel_angles[j] = 0.0;
+          cancel_send[j] = false;
+        } else {
+          cancel_angles[j] = angles[j];
+        }
+      }
+      std::fill(cancel.begin(), cancel.end(), 0);
+      if (_tables)
+        _tables->UnusedAngle2Stroke(cancel, cancel_send);
+      else
+        common::UnusedAngle2Stroke(cancel, cancel_send);
+      angles = cancel_angles.data();
+      no_send = cancel.data();
+    }
+
+    if (_tables)
+      _tables->Angle2Stroke(strokes, angles);
+    else
+      common::Angle2Stroke(strokes, angles);
+    for (size_t i = 0; i < AERO_DOF; ++i)
+      if (no_send[i] != 0) strokes[i] = 0x7fff;
+
+    std::copy(strokes, strokes + AERO_DOF_UPPER,
+              _upper.begin() + n * AERO_DOF_UPPER);
+    std::copy(strokes + AERO_DOF_UPPER, strokes + AERO_DOF,
+              _lower.begin() + n * AERO_DOF_LOWER);
+  }
+}
@@ -0,0 +1,28 @@
+#ifndef AERO_COMMON_ANGLE_TO_STROKE_BATCH_H_
+#define AERO_COMMON_ANGLE_TO_STROKE_BATCH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace aero
+{
+  namespace common
+  {
+    class ConversionTables;
+
+    /// @brief converts all points of a trajectory to upper and lower strokes
+    /// @param _angles points x angle joints, one point after another,
+    ///   joints in AngleJointNames order, NaN cancels the joint at the point
+    /// @param _send angle joints, false for joints not in the trajectory
+    /// @param _upper points x AERO_DOF_UPPER strokes, resized
+    /// @param _lower points x AERO_DOF_LOWER strokes, resized
+    /// @param _tables runtime tables, generated functions if nullptr
+    void Angle2StrokeBatch
+    (const std::vector<double>& _angles, const std::vector<bool>& _send,
+     std::vector<int16_t>& _upper, std::vector<int16_t>& _lower,
+     const ConversionTables* _tables = nullptr);
+  }
+}
+
+#endif
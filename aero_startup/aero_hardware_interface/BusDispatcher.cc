@@ -0,0 +1,117 @@
+#include "aero_hardware_interface/BusDispatcher.hh"
+
+#include <iostream>
+
+using namespace aero;
+using namespace controller;
+
+//////////////////////////////////////////////////
+void CommandCompletion::wait()
+{
+  std::unique_lock<std::mutex> lock(mtx_);
+  cond_.wait(lock, [this]() { return pending_ == 0; });
+}
+
+//////////////////////////////////////////////////
+void CommandCompletion::add()
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  ++pending_;
+}
+
+//////////////////////////////////////////////////
+void CommandCompletion::done()
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (--pending_ == 0) cond_.notify_all();
+}
+
+//////////////////////////////////////////////////
+BusDispatcher::BusDispatcher() :
+  dropped_(0), sleeping_(false), stop_(false)
+{
+  thread_ = std::thread([this]() { loop_(); });
+}
+
+//////////////////////////////////////////////////
+BusDispatcher::~BusDispatcher()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+//////////////////////////////////////////////////
+bool BusDispatcher::post(CommandPriority _priority,
+                         std::function<void()> _job,
+                         CommandCompletion* _done)
+{
+  if (_done) _done->add();
+
+  if (!queues_[_priority].push({std::move(_job), _done})) {
+    ++dropped_;
+    std::cerr << "BusDispatcher: ERROR: queue " << _priority
+              << " is full, command dropped" << std::endl;
+    if (_done) _done->done();
+    return false;
+  }
+
+  // pairs with the fence in loop_, either the bus thread sees
+  // the command before sleeping or we see it sleeping
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (sleeping_.load()) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    cond_.notify_one();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool BusDispatcher::call(CommandPriority _priority,
+                         std::function<void()> _job)
+{
+  CommandCompletion done;
+  if (!post(_priority, std::move(_job), &done)) return false;
+  done.wait();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool BusDispatcher::pop_(Command& _command)
+{
+  for (size_t i = 0; i < NUM_PRIORITIES; ++i)
+    if (queues_[i].pop(_command)) return true;
+  return false;
+}
+
+//////////////////////////////////////////////////
+void BusDispatcher::loop_()
+{
+  Command command;
+  while (true) {
+    if (pop_(command)) {
+      command.job();
+      if (command.done) command.done->done();
+      command.job = nullptr;
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mtx_);
+    sleeping_.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (pop_(command)) {  // command arrived while going to sleep
+      sleeping_.store(false);
+      lock.unlock();
+      command.job();
+      if (command.done) command.done->done();
+      command.job = nullptr;
+      continue;
+    }
+    if (stop_) break;  // stop requested and no command left
+    cond_.wait(lock);
+    sleeping_.store(false);
+  }
+}
@@ -0,0 +1,114 @@
+#ifndef AERO_CONTROLLER_BUS_DISPATCHER_H_
+#define AERO_CONTROLLER_BUS_DISPATCHER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "aero_hardware_interface/CommandQueue.hh"
+
+namespace aero
+{
+  namespace controller
+  {
+    // number of commands each priority queue can hold
+    const static size_t BUS_COMMAND_QUEUE_LENGTH = 64;
+
+    /// @brief priority class of bus commands, smaller runs first
+    enum CommandPriority
+    {
+      PRIORITY_MOTION = 0,     // set_position, wheel velocity, cancel
+      PRIORITY_TELEMETRY = 1,  // update_position, status, current
+      PRIORITY_CONFIG = 2,     // servo, reset, current limit, hand script
+      NUM_PRIORITIES = 3
+    };
+
+    /// @brief counts commands in flight, wait() until all finish
+    class CommandCompletion
+    {
+      /// @brief constructor
+     public: CommandCompletion() : pending_(0) {}
+
+      /// @brief block until all added commands finish
+     public: void wait();
+
+      /// @brief register a command to wait for
+     public: void add();
+
+      /// @brief notify a command has finished
+     public: void done();
+
+     private: std::mutex mtx_;
+
+     private: std::condition_variable cond_;
+
+     private: int pending_;
+    };
+
+    /// @brief dedicated I/O thread of one SEED bus
+    ///
+    /// Other threads never touch the bus controller directly,
+    /// they enqueue commands into the lock-free queue of each priority.
+    /// The bus thread drains motion commands first,
+    /// then telemetry and then config, one command at a time,
+    /// and sleeps while all queues are empty.
+    class BusDispatcher
+    {
+      /// @brief constructor, starts bus thread
+     public: BusDispatcher();
+
+      /// @brief destructor, runs queued commands and joins bus thread
+     public: ~BusDispatcher();
+
+      /// @brief enqueue a command, does not wait
+      /// @param _priority priority class
+      /// @param _job command, run on bus thread
+      /// @param _done notified after _job ran, nullptr to ignore
+      /// @return false if queue is full and _job was dropped
+     public: bool post(CommandPriority _priority, std::function<void()> _job,
+                       CommandCompletion* _done=nullptr);
+
+      /// @brief enqueue a command and wait until it ran
+      /// @param _priority priority class
+      /// @param _job command, run on bus thread
+      /// @return false if queue is full and _job was dropped
+     public: bool call(CommandPriority _priority, std::function<void()> _job);
+
+      /// @brief number of commands dropped for full queue
+     public: size_t dropped() const {return dropped_.load();}
+
+     private: struct Command
+      {
+        std::function<void()> job;
+        CommandCompletion* done;
+      };
+
+      /// @brief pop highest priority command
+     private: bool pop_(Command& _command);
+
+     private: void loop_();
+
+     private: CommandQueue<Command, BUS_COMMAND_QUEUE_LENGTH>
+      queues_[NUM_PRIORITIES];
+
+     private: std::atomic<size_t> dropped_;
+
+      // only used to sleep and wake the bus thread, never held over I/O
+     private: std::mutex mtx_;
+
+     private: std::condition_variable cond_;
+
+     private: std::atomic<bool> sleeping_;
+
+     private: bool stop_;
+
+     private: std::thread thread_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_BUS_DISPATCHER_H_
@@ -0,0 +1,78 @@
+#include "aero_hardware_interface/BusWorkerPool.hh"
+
+using namespace aero;
+using namespace controller;
+
+//////////////////////////////////////////////////
+BusWorkerPool::BusWorkerPool(size_t _num_buses)
+{
+  workers_.reserve(_num_buses);
+  for (size_t i = 0; i < _num_buses; ++i) {
+    workers_.emplace_back(new Worker);
+    Worker& w = *workers_.back();
+    w.busy = false;
+    w.stop = false;
+    w.thread = std::thread([this, &w]() { loop_(w); });
+  }
+}
+
+//////////////////////////////////////////////////
+BusWorkerPool::~BusWorkerPool()
+{
+  for (auto& w : workers_) {
+    std::lock_guard<std::mutex> lock(w->mtx);
+    w->stop = true;
+    w->cond.notify_all();
+  }
+  for (auto& w : workers_) {
+    if (w->thread.joinable()) w->thread.join();
+  }
+}
+
+//////////////////////////////////////////////////
+void BusWorkerPool::post(size_t _bus, std::function<void()> _job)
+{
+  Worker& w = *workers_.at(_bus);
+  std::unique_lock<std::mutex> lock(w.mtx);
+  w.cond.wait(lock, [&w]() { return !w.busy; });
+  w.job.swap(_job);
+  w.busy = true;
+  w.cond.notify_all();
+}
+
+//////////////////////////////////////////////////
+void BusWorkerPool::wait()
+{
+  for (auto& w : workers_) {
+    std::unique_lock<std::mutex> lock(w->mtx);
+    w->cond.wait(lock, [&w]() { return !w->busy; });
+  }
+}
+
+//////////////////////////////////////////////////
+void BusWorkerPool::run(std::function<void()> _upper,
+                        std::function<void()> _lower)
+{
+  post(BUS_UPPER, std::move(_upper));
+  post(BUS_LOWER, std::move(_lower));
+  wait();
+}
+
+//////////////////////////////////////////////////
+void BusWorkerPool::loop_(Worker& _worker)
+{
+  std::unique_lock<std::mutex> lock(_worker.mtx);
+  while (true) {
+    _worker.cond.wait(lock, [&_worker]() {
+        return _worker.busy || _worker.stop; });
+    if (!_worker.busy) break;  // stop requested and no job left
+
+    lock.unlock();
+    _worker.job();
+    lock.lock();
+
+    _worker.job = nullptr;
+    _worker.busy = false;
+    _worker.cond.notify_all();
+  }
+}
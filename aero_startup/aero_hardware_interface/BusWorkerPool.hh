@@ -0,0 +1,64 @@
+#ifndef AERO_CONTROLLER_BUS_WORKER_POOL_H_
+#define AERO_CONTROLLER_BUS_WORKER_POOL_H_
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace aero
+{
+  namespace controller
+  {
+    // worker index of each SEED bus
+    const static size_t BUS_UPPER = 0;
+    const static size_t BUS_LOWER = 1;
+    const static size_t NUM_BUSES = 2;
+
+    /// @brief one long-lived thread per SEED bus
+    ///
+    /// Replaces creating and joining std::thread every control cycle.
+    /// A job is handed to the bus thread through its condition variable,
+    /// and wait() blocks until all posted jobs have finished.
+    class BusWorkerPool
+    {
+      /// @brief constructor, starts threads
+      /// @param _num_buses number of buses (= threads)
+     public: explicit BusWorkerPool(size_t _num_buses=NUM_BUSES);
+
+      /// @brief destructor, finishes posted jobs and joins threads
+     public: ~BusWorkerPool();
+
+      /// @brief run job on bus thread,
+      ///   blocks while previous job of the bus is running
+      /// @param _bus bus index
+      /// @param _job job, referenced objects must be valid until wait()
+     public: void post(size_t _bus, std::function<void()> _job);
+
+      /// @brief wait until all posted jobs finish
+     public: void wait();
+
+      /// @brief run one job on each of upper and lower bus and wait
+     public: void run(std::function<void()> _upper,
+                      std::function<void()> _lower);
+
+     private: struct Worker
+      {
+        std::thread thread;
+        std::mutex mtx;
+        std::condition_variable cond;
+        std::function<void()> job;
+        bool busy;
+        bool stop;
+      };
+
+     private: void loop_(Worker& _worker);
+
+     private: std::vector<std::unique_ptr<Worker> > workers_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_BUS_WORKER_POOL_H_
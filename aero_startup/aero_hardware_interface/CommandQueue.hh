@@ -0,0 +1,108 @@
+#ifndef AERO_CONTROLLER_COMMAND_QUEUE_H_
+#define AERO_CONTROLLER_COMMAND_QUEUE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <utility>
+
+namespace aero
+{
+  namespace controller
+  {
+    /// @brief bounded lock-free queue of commands
+    ///
+    /// Ring of _Length cells, each cell has a sequence number telling
+    /// whether it is free for the next push or filled for the next pop,
+    /// so push and pop only use atomic operations and never block.
+    /// Any number of threads may push and pop concurrently.
+    /// @tparam T element type, must be default constructible and movable
+    /// @tparam _Length number of cells, must be power of 2
+    template <typename T, size_t _Length>
+    class CommandQueue
+    {
+      static_assert(_Length >= 2 && (_Length & (_Length - 1)) == 0,
+                    "CommandQueue length must be power of 2");
+
+      /// @brief constructor
+     public: CommandQueue() : head_(0), tail_(0)
+      {
+        for (size_t i = 0; i < _Length; ++i)
+          cells_[i].seq.store(i, std::memory_order_relaxed);
+      }
+
+      /// @brief append an element
+      /// @param _item element, moved into queue
+      /// @return false if queue is full
+     public: bool push(T&& _item)
+      {
+        Cell* cell;
+        size_t pos = tail_.load(std::memory_order_relaxed);
+        while (true) {
+          cell = &cells_[pos & (_Length - 1)];
+          size_t seq = cell->seq.load(std::memory_order_acquire);
+          intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+          if (dif == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed))
+              break;
+          } else if (dif < 0) {
+            return false;  // full
+          } else {
+            pos = tail_.load(std::memory_order_relaxed);
+          }
+        }
+        cell->data = std::move(_item);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+
+      /// @brief take the oldest element
+      /// @param _item output element
+      /// @return false if queue is empty
+     public: bool pop(T& _item)
+      {
+        Cell* cell;
+        size_t pos = head_.load(std::memory_order_relaxed);
+        while (true) {
+          cell = &cells_[pos & (_Length - 1)];
+          size_t seq = cell->seq.load(std::memory_order_acquire);
+          intptr_t dif =
+            static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+          if (dif == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1,
+                                            std::memory_order_relaxed))
+              break;
+          } else if (dif < 0) {
+            return false;  // empty
+          } else {
+            pos = head_.load(std::memory_order_relaxed);
+          }
+        }
+        _item = std::move(cell->data);
+        cell->data = T();  // release resources held by the element
+        cell->seq.store(pos + _Length, std::memory_order_release);
+        return true;
+      }
+
+      /// @brief number of cells
+     public: static constexpr size_t capacity() {return _Length;}
+
+     private: struct Cell
+      {
+        std::atomic<size_t> seq;
+        T data;
+      };
+
+     private: Cell cells_[_Length];
+
+      // head and tail on separate cache lines,
+      // producers and the consumer do not invalidate each other
+     private: alignas(64) std::atomic<size_t> head_;
+
+     private: alignas(64) std::atomic<size_t> tail_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_COMMAND_QUEUE_H_
@@ -0,0 +1,661 @@
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "aero_hardware_interface/ConversionTables.hh"
+#include "aero_hardware_interface/ConversionTablesBuilder.hh"
+
+using namespace aero;
+using namespace common;
+
+//////////////////////////////////////////////////
+ConversionTables::ConversionTables() :
+  header_(nullptr), map_(nullptr), map_size_(0), from_cache_(false),
+  tables_(nullptr), a2s_entries_(nullptr), s2a_entries_(nullptr),
+  s2a_buckets_(nullptr), ops_(nullptr), constants_(nullptr),
+  programs_(nullptr), depends_(nullptr), depend_ids_(nullptr)
+{
+}
+
+//////////////////////////////////////////////////
+ConversionTables::~ConversionTables()
+{
+  close();
+}
+
+//////////////////////////////////////////////////
+bool ConversionTables::load(const std::string& _robot_dir,
+                            const std::string& _cache_file)
+{
+  close();
+
+  ConversionTablesBuilder builder;
+  if (!builder.read(_robot_dir))
+    return false;
+
+  // inputs not changed since cache was written
+  if (!_cache_file.empty() && map(_cache_file, builder.hash())) {
+    from_cache_ = true;
+    return true;
+  }
+
+  std::vector<uint8_t> image;
+  if (!builder.build(image))
+    return false;
+
+  if (!_cache_file.empty()) {
+    std::string tmp = _cache_file + ".tmp" + std::to_string(::getpid());
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    bool written = false;
+    if (fp) {
+      written = (fwrite(image.data(), 1, image.size(), fp) == image.size());
+      written = (fclose(fp) == 0) && written;
+    }
+    if (written && ::rename(tmp.c_str(), _cache_file.c_str()) == 0 &&
+        map(_cache_file, builder.hash()))
+      return true;
+    ::unlink(tmp.c_str());
+    std::cerr << "Tables: ERROR: could not write " << _cache_file
+              << ", tables are kept in memory" << std::endl;
+  }
+
+  image_.swap(image);
+  return attach(image_.data(), image_.size());
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::close()
+{
+  if (map_)
+    ::munmap(map_, map_size_);
+  map_ = nullptr;
+  map_size_ = 0;
+  image_.clear();
+  header_ = nullptr;
+  from_cache_ = false;
+}
+
+//////////////////////////////////////////////////
+bool ConversionTables::map(const std::string& _file, uint64_t _hash)
+{
+  int fd = ::open(_file.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(ConversionCacheHeader)) {
+    ::close(fd);
+    return false;
+  }
+
+  void* map = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+    return false;
+
+  const ConversionCacheHeader* header =
+    static_cast<const ConversionCacheHeader*>(map);
+  if (header->hash != _hash || !attach(map, st.st_size)) {
+    ::munmap(map, st.st_size);
+    header_ = nullptr;
+    return false;
+  }
+
+  map_ = map;
+  map_size_ = st.st_size;
+  return true;
+}
+
+//////////////////////////////////////////////////
+template<class T>
+const T* ConversionTables::section(ConversionSectionId _id) const
+{
+  return reinterpret_cast<const T*>(
+      reinterpret_cast<const uint8_t*>(header_)
+      + header_->sections[_id].offset);
+}
+
+//////////////////////////////////////////////////
+bool ConversionTables::attach(const void* _image, size_t _size)
+{
+  static const size_t element_sizes[CONVERSION_SECTIONS] = {
+    sizeof(ConversionTable), sizeof(ConversionA2SEntry),
+    sizeof(ConversionS2AEntry), sizeof(ConversionS2ABucket),
+    sizeof(ConversionOp), sizeof(double), sizeof(ConversionProgram),
+    sizeof(ConversionDepends), sizeof(int32_t), sizeof(ConversionName),
+    sizeof(char)
+  };
+
+  const ConversionCacheHeader* header =
+    static_cast<const ConversionCacheHeader*>(_image);
+  if (_size < sizeof(ConversionCacheHeader) ||
+      strncmp(header->magic, "AEROTBL", 8) != 0 ||
+      header->version != CONVERSION_TABLES_VERSION ||
+      header->size != _size)
+    return false;
+
+  for (int i = 0; i < CONVERSION_SECTIONS; ++i) {
+    const ConversionSection& s = header->sections[i];
+    if (s.offset % 8 != 0 || s.offset < sizeof(ConversionCacheHeader) ||
+        s.offset > _size ||
+        (_size - s.offset) / element_sizes[i] < s.size)
+      return false;
+  }
+  header_ = header;
+
+  tables_ = section<ConversionTable>(CONVERSION_TABLES);
+  a2s_entries_ = section<ConversionA2SEntry>(CONVERSION_A2S_ENTRIES);
+  s2a_entries_ = section<ConversionS2AEntry>(CONVERSION_S2A_ENTRIES);
+  s2a_buckets_ = section<ConversionS2ABucket>(CONVERSION_S2A_BUCKETS);
+  ops_ = section<ConversionOp>(CONVERSION_OPS);
+  constants_ = section<double>(CONVERSION_CONSTANTS);
+  programs_ = section<ConversionProgram>(CONVERSION_PROGRAMS);
+  depends_ = section<ConversionDepends>(CONVERSION_DEPENDS);
+  depend_ids_ = section<int32_t>(CONVERSION_DEPEND_IDS);
+
+  // everything referenced stays inside the image
+  const ConversionSection* s = header_->sections;
+  auto inside = [](int32_t _first, int32_t _size, uint32_t _limit) {
+    return _first >= 0 && _size >= 0 &&
+      static_cast<int64_t>(_first) + _size <= _limit;
+  };
+
+  if (s[CONVERSION_PROGRAMS].size != 2) {
+    header_ = nullptr;
+    return false;
+  }
+
+  for (uint32_t i = 0; i < s[CONVERSION_S2A_BUCKETS].size; ++i) {
+    const ConversionS2ABucket& b = s2a_buckets_[i];
+    if (!inside(b.candidates, b.candidates_size,
+                s[CONVERSION_S2A_ENTRIES].size) ||
+        !inside(b.appendix, b.appendix_size,
+                s[CONVERSION_S2A_ENTRIES].size) || b.candidates_size < 1) {
+      header_ = nullptr;
+      return false;
+    }
+  }
+
+  for (int p = 0; p < 2; ++p) {
+    const ConversionProgram& program = programs_[p];
+    if (!inside(program.first, program.size, s[CONVERSION_OPS].size) ||
+        program.inputs < 0 || program.outputs < 0) {
+      header_ = nullptr;
+      return false;
+    }
+    int depth = 0;
+    for (int32_t k = program.first; k < program.first + program.size; ++k) {
+      const ConversionOp& op = ops_[k];
+      bool valid = true;
+      switch (op.code) {
+      case CONVERSION_OP_CONST:
+        valid = inside(op.arg, 1, s[CONVERSION_CONSTANTS].size);
+        ++depth;
+        break;
+      case CONVERSION_OP_INPUT:
+        valid = inside(op.arg, 1, program.inputs);
+        ++depth;
+        break;
+      case CONVERSION_OP_LOAD:
+        valid = inside(op.arg, 1, CONVERSION_MAX_LOCALS);
+        ++depth;
+        break;
+      case CONVERSION_OP_STORE:
+        valid = inside(op.arg, 1, CONVERSION_MAX_LOCALS) && depth >= 1;
+        --depth;
+        break;
+      case CONVERSION_OP_OUTPUT:
+        valid = inside(op.arg, 1, program.outputs) && depth >= 1;
+        --depth;
+        break;
+      case CONVERSION_OP_CAST:
+      case CONVERSION_OP_NEG:
+        valid = (depth >= 1);
+        break;
+      case CONVERSION_OP_ADD:
+      case CONVERSION_OP_SUB:
+      case CONVERSION_OP_MUL:
+      case CONVERSION_OP_DIV:
+        valid = (depth >= 2);
+        --depth;
+        break;
+      case CONVERSION_OP_A2S:
+      case CONVERSION_OP_A2S_DUAL:
+      case CONVERSION_OP_S2A:
+        valid = inside(op.arg, 1, s[CONVERSION_TABLES].size) && depth >= 1;
+        if (valid) {
+          const ConversionTable& t = tables_[op.arg];
+          if (op.code == CONVERSION_OP_S2A)
+            valid = inside(t.first, t.size, s[CONVERSION_S2A_BUCKETS].size);
+          else
+            valid = inside(t.first, t.size, s[CONVERSION_A2S_ENTRIES].size);
+          valid = valid && t.size > 0;
+        }
+        if (valid && op.code == CONVERSION_OP_A2S_DUAL) {
+          const ConversionTable& t = tables_[op.arg];
+          valid = inside(t.first2, t.size2, s[CONVERSION_A2S_ENTRIES].size)
+            && t.size2 > 0 && depth >= 2;
+        }
+        break;
+      default:
+        valid = false;
+      }
+      if (op.type > CONVERSION_DOUBLE || depth > CONVERSION_MAX_STACK)
+        valid = false;
+      if (!valid) {
+        std::cerr << "Tables: ERROR: broken program in cache" << std::endl;
+        header_ = nullptr;
+        return false;
+      }
+    }
+  }
+
+  if (s[CONVERSION_DEPENDS].size != static_cast<uint32_t>(programs_[0].outputs)) {
+    header_ = nullptr;
+    return false;
+  }
+  for (uint32_t i = 0; i < s[CONVERSION_DEPENDS].size; ++i) {
+    if (!inside(depends_[i].first, depends_[i].size,
+                s[CONVERSION_DEPEND_IDS].size)) {
+      header_ = nullptr;
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < s[CONVERSION_DEPEND_IDS].size; ++i) {
+    if (!inside(depend_ids_[i], 1, programs_[0].inputs)) {
+      header_ = nullptr;
+      return false;
+    }
+  }
+
+  const ConversionName* names = section<ConversionName>(CONVERSION_NAMES);
+  for (uint32_t i = 0; i < s[CONVERSION_NAMES].size; ++i) {
+    if (!inside(names[i].first, names[i].size, s[CONVERSION_CHARS].size)) {
+      header_ = nullptr;
+      return false;
+    }
+  }
+  if (s[CONVERSION_NAMES].size < static_cast<uint32_t>(programs_[0].inputs)) {
+    header_ = nullptr;
+    return false;
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+uint64_t ConversionTables::hash() const
+{
+  return header_ ? header_->hash : 0;
+}
+
+//////////////////////////////////////////////////
+size_t ConversionTables::number_of_angle_joints() const
+{
+  return header_ ? programs_[0].inputs : 0;
+}
+
+//////////////////////////////////////////////////
+size_t ConversionTables::number_of_strokes() const
+{
+  return header_ ? programs_[0].outputs : 0;
+}
+
+//////////////////////////////////////////////////
+std::vector<std::string> ConversionTables::angle_joint_names() const
+{
+  std::vector<std::string> names;
+  if (!header_)
+    return names;
+
+  const ConversionName* name = section<ConversionName>(CONVERSION_NAMES);
+  const char* chars = section<char>(CONVERSION_CHARS);
+  for (int32_t i = 0; i < programs_[0].inputs; ++i)
+    names.push_back(std::string(chars + name[i].first, name[i].size));
+  return names;
+}
+
+//////////////////////////////////////////////////
+namespace
+{
+  inline double cast(uint8_t _type, double _value)
+  {
+    if (_type == CONVERSION_FLOAT)
+      return static_cast<float>(_value);
+    else if (_type == CONVERSION_INT)
+      return static_cast<int>(_value);
+    return _value;
+  }
+
+  inline double apply(uint8_t _code, uint8_t _type, double _a, double _b)
+  {
+    if (_type == CONVERSION_FLOAT) {
+      float fa = static_cast<float>(_a), fb = static_cast<float>(_b);
+      if (_code == CONVERSION_OP_ADD) return fa + fb;
+      else if (_code == CONVERSION_OP_SUB) return fa - fb;
+      else if (_code == CONVERSION_OP_MUL) return fa * fb;
+      return fa / fb;
+    } else if (_type == CONVERSION_INT) {
+      int ia = static_cast<int>(_a), ib = static_cast<int>(_b);
+      if (_code == CONVERSION_OP_ADD) return ia + ib;
+      else if (_code == CONVERSION_OP_SUB) return ia - ib;
+      else if (_code == CONVERSION_OP_MUL) return ia * ib;
+      return (ib != 0 ? ia / ib : 0);
+    }
+    if (_code == CONVERSION_OP_ADD) return _a + _b;
+    else if (_code == CONVERSION_OP_SUB) return _a - _b;
+    else if (_code == CONVERSION_OP_MUL) return _a * _b;
+    return _a / _b;
+  }
+
+  inline void store(int16_t& _to, double _value)
+  {
+    _to = static_cast<int16_t>(static_cast<int>(_value));
+  }
+
+  inline void store(double& _to, double _value)
+  {
+    _to = _value;
+  }
+}
+
+//////////////////////////////////////////////////
+template<class I, class O>
+void ConversionTables::run(const ConversionProgram& _program,
+                           const I* _inputs, O* _outputs) const
+{
+  double stack[CONVERSION_MAX_STACK];
+  double locals[CONVERSION_MAX_LOCALS];
+  int sp = 0;
+
+  const ConversionOp* end = ops_ + _program.first + _program.size;
+  for (const ConversionOp* op = ops_ + _program.first; op != end; ++op) {
+    switch (op->code) {
+    case CONVERSION_OP_CONST:
+      stack[sp++] = constants_[op->arg];
+      break;
+    case CONVERSION_OP_INPUT:
+      stack[sp++] = _inputs[op->arg];
+      break;
+    case CONVERSION_OP_LOAD:
+      stack[sp++] = locals[op->arg];
+      break;
+    case CONVERSION_OP_STORE:
+      locals[op->arg] = stack[--sp];
+      break;
+    case CONVERSION_OP_OUTPUT:
+      store(_outputs[op->arg], stack[--sp]);
+      break;
+    case CONVERSION_OP_CAST:
+      stack[sp - 1] = cast(op->type, stack[sp - 1]);
+      break;
+    case CONVERSION_OP_NEG:
+      stack[sp - 1] = -stack[sp - 1];
+      break;
+    case CONVERSION_OP_ADD:
+    case CONVERSION_OP_SUB:
+    case CONVERSION_OP_MUL:
+    case CONVERSION_OP_DIV: {
+      double b = stack[--sp];
+      stack[sp - 1] = apply(op->code, op->type, stack[sp - 1], b);
+      break;
+    }
+    case CONVERSION_OP_A2S:
+      stack[sp - 1] =
+        a2s(tables_[op->arg], static_cast<float>(stack[sp - 1]));
+      break;
+    case CONVERSION_OP_A2S_DUAL: {
+      const ConversionTable& t = tables_[op->arg];
+      float stroke2 = a2s(a2s_entries_ + t.first2, t.size2, t.offset2,
+                          static_cast<float>(stack[--sp]));
+      float stroke1 = a2s(a2s_entries_ + t.first, t.size, t.offset,
+                          static_cast<float>(stack[sp - 1]));
+      stack[sp - 1] = static_cast<float>(stroke2 + stroke1);
+      stack[sp++] = static_cast<float>(stroke2 - stroke1);
+      break;
+    }
+    case CONVERSION_OP_S2A:
+      stack[sp - 1] =
+        s2a(tables_[op->arg], static_cast<float>(stack[sp - 1]));
+      break;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+template<class I>
+void ConversionTables::derive(const ConversionProgram& _program,
+                              const I* _inputs, const double* _derivatives,
+                              double* _outputs) const
+{
+  // values are evaluated as run, derivatives along with them
+  double stack[CONVERSION_MAX_STACK], dstack[CONVERSION_MAX_STACK];
+  double locals[CONVERSION_MAX_LOCALS], dlocals[CONVERSION_MAX_LOCALS];
+  int sp = 0;
+
+  const ConversionOp* end = ops_ + _program.first + _program.size;
+  for (const ConversionOp* op = ops_ + _program.first; op != end; ++op) {
+    switch (op->code) {
+    case CONVERSION_OP_CONST:
+      dstack[sp] = 0.0;
+      stack[sp++] = constants_[op->arg];
+      break;
+    case CONVERSION_OP_INPUT:
+      dstack[sp] = _derivatives[op->arg];
+      stack[sp++] = _inputs[op->arg];
+      break;
+    case CONVERSION_OP_LOAD:
+      dstack[sp] = dlocals[op->arg];
+      stack[sp++] = locals[op->arg];
+      break;
+    case CONVERSION_OP_STORE:
+      --sp;
+      locals[op->arg] = stack[sp];
+      dlocals[op->arg] = dstack[sp];
+      break;
+    case CONVERSION_OP_OUTPUT:
+      _outputs[op->arg] = dstack[--sp];
+      break;
+    case CONVERSION_OP_CAST:
+      // rounding is ignored, casts only drop fractions of a stroke
+      stack[sp - 1] = cast(op->type, stack[sp - 1]);
+      break;
+    case CONVERSION_OP_NEG:
+      stack[sp - 1] = -stack[sp - 1];
+      dstack[sp - 1] = -dstack[sp - 1];
+      break;
+    case CONVERSION_OP_ADD:
+    case CONVERSION_OP_SUB:
+    case CONVERSION_OP_MUL:
+    case CONVERSION_OP_DIV: {
+      double b = stack[--sp], db = dstack[sp];
+      double a = stack[sp - 1], da = dstack[sp - 1];
+      if (op->code == CONVERSION_OP_ADD)
+        dstack[sp - 1] = da + db;
+      else if (op->code == CONVERSION_OP_SUB)
+        dstack[sp - 1] = da - db;
+      else if (op->code == CONVERSION_OP_MUL)
+        dstack[sp - 1] = da * b + a * db;
+      else
+        dstack[sp - 1] = (b != 0 ? (da * b - a * db) / (b * b) : 0.0);
+      stack[sp - 1] = apply(op->code, op->type, a, b);
+      break;
+    }
+    case CONVERSION_OP_A2S: {
+      float slope;
+      stack[sp - 1] =
+        a2s(tables_[op->arg], static_cast<float>(stack[sp - 1]), &slope);
+      dstack[sp - 1] *= slope;
+      break;
+    }
+    case CONVERSION_OP_A2S_DUAL: {
+      const ConversionTable& t = tables_[op->arg];
+      float slope2, slope1;
+      float stroke2 = a2s(a2s_entries_ + t.first2, t.size2, t.offset2,
+                          static_cast<float>(stack[--sp]), &slope2);
+      float stroke1 = a2s(a2s_entries_ + t.first, t.size, t.offset,
+                          static_cast<float>(stack[sp - 1]), &slope1);
+      double d2 = dstack[sp] * slope2;
+      double d1 = dstack[sp - 1] * slope1;
+      stack[sp - 1] = static_cast<float>(stroke2 + stroke1);
+      dstack[sp - 1] = d2 + d1;
+      stack[sp] = static_cast<float>(stroke2 - stroke1);
+      dstack[sp++] = d2 - d1;
+      break;
+    }
+    case CONVERSION_OP_S2A: {
+      float slope;
+      stack[sp - 1] =
+        s2a(tables_[op->arg], static_cast<float>(stack[sp - 1]), &slope);
+      dstack[sp - 1] *= slope;
+      break;
+    }
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+float ConversionTables::a2s(const ConversionTable& _table, float _angle,
+                            float* _slope) const
+{
+  return a2s(a2s_entries_ + _table.first, _table.size, _table.offset, _angle,
+             _slope);
+}
+
+//////////////////////////////////////////////////
+float ConversionTables::a2s(const ConversionA2SEntry* _entries, int32_t _size,
+                            int32_t _offset, float _angle,
+                            float* _slope) const
+{
+  // same as TableTemplate of Angle2Stroke.hh,
+  // saturated out of table (no slope)
+  float lowest = static_cast<float>(_offset);
+  float highest = static_cast<float>(_offset + _size - 1);
+  bool saturated = (_angle < lowest || _angle > highest);
+  _angle = std::min(std::max(_angle, lowest), highest);
+  int roundedAngle = static_cast<int>(_angle);
+  roundedAngle += (_angle > roundedAngle + 0.001);
+  int roundedAngleIndex = roundedAngle - _offset;
+  if(_size - 1 < roundedAngleIndex) roundedAngleIndex = _size - 1;
+  if(roundedAngleIndex < 0) roundedAngleIndex = 0;
+  roundedAngle = roundedAngleIndex + _offset;
+  const ConversionA2SEntry& ref = _entries[roundedAngleIndex];
+
+  if (_slope) *_slope = (saturated ? 0.0f : ref.interval);
+  return ref.stroke - (roundedAngle - _angle) * ref.interval;
+}
+
+//////////////////////////////////////////////////
+float ConversionTables::s2a(const ConversionTable& _table, float _stroke,
+                            float* _slope) const
+{
+  // same as TableTemplate of Stroke2Angle.hh
+  int roundedStroke = static_cast<int>(_stroke);
+  int roundedStrokeIndex = roundedStroke - _table.offset;
+  if(_table.size - 1 < roundedStrokeIndex) roundedStrokeIndex = _table.size - 1;
+  if(roundedStrokeIndex < 0) roundedStrokeIndex = 0;
+  const ConversionS2ABucket& ref = s2a_buckets_[_table.first + roundedStrokeIndex];
+  const ConversionS2AEntry* candidates = s2a_entries_ + ref.candidates;
+  const ConversionS2AEntry* appendix = s2a_entries_ + ref.appendix;
+  int size = ref.candidates_size;
+  int appendixSize = ref.appendix_size;
+
+  bool negative = (_stroke < 0);
+  bool reversed = (size >= 2) &&
+    (negative ? (candidates[0].stroke < candidates[1].stroke)
+     : (candidates[0].stroke > candidates[1].stroke));
+
+  for (int k = 0; k < size; ++k) {
+    const ConversionS2AEntry& c = candidates[reversed ? size - 1 - k : k];
+    if (negative ? (_stroke >= c.stroke) : (_stroke <= c.stroke)) {
+      if (_slope) *_slope = (c.range == 0 ? 0.0f : 1.0f / c.range);
+      if (c.range == 0)
+        return c.angle;
+      else
+        return c.angle - (c.stroke - _stroke) / c.range;
+    }
+  }
+
+  if (appendixSize == 0) {
+    if (_slope) *_slope = 0.0f;
+    return candidates[reversed ? 0 : size - 1].angle;
+  }
+
+  bool appendixReversed = (appendixSize >= 2) &&
+    (negative ? (appendix[0].stroke < appendix[1].stroke)
+     : (appendix[0].stroke > appendix[1].stroke));
+  const ConversionS2AEntry& a = appendix[appendixReversed ? appendixSize - 1 : 0];
+  if (_slope) *_slope = (a.range == 0 ? 0.0f : 1.0f / a.range);
+  if (a.range == 0)
+    return a.angle;
+  else
+    return a.angle - (a.stroke - _stroke) / a.range;
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::Angle2Stroke(int16_t* _strokes,
+                                    const double* _angles) const
+{
+  run(programs_[0], _angles, _strokes);
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::Angle2Stroke(std::vector<int16_t>& _strokes,
+                                    const std::vector<double>& _angles) const
+{
+  Angle2Stroke(_strokes.data(), _angles.data());
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::UnusedAngle2Stroke(std::vector<int16_t>& _strokes,
+                                          const std::vector<bool>& _angles) const
+{
+  // no-send if none of the angles the stroke depends on is sent
+  for (int32_t i = 0; i < programs_[0].outputs; ++i) {
+    const ConversionDepends& d = depends_[i];
+    if (d.size == 0)
+      continue;
+    bool send = false;
+    for (int32_t k = d.first; k < d.first + d.size; ++k)
+      send = send || _angles[depend_ids_[k]];
+    if (!send)
+      _strokes[i] = 0x7fff;
+  }
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::Stroke2Angle(double* _angles,
+                                    const int16_t* _strokes) const
+{
+  run(programs_[1], _strokes, _angles);
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::Stroke2Angle(std::vector<double>& _angles,
+                                    const std::vector<int16_t>& _strokes) const
+{
+  Stroke2Angle(_angles.data(), _strokes.data());
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::Stroke2AngleVelocity(
+    double* _velocities, const int16_t* _strokes,
+    const double* _stroke_velocities) const
+{
+  derive(programs_[1], _strokes, _stroke_velocities, _velocities);
+}
+
+//////////////////////////////////////////////////
+void ConversionTables::Stroke2AngleVelocity(
+    std::vector<double>& _velocities, const std::vector<int16_t>& _strokes,
+    const std::vector<double>& _stroke_velocities) const
+{
+  Stroke2AngleVelocity(_velocities.data(), _strokes.data(),
+                       _stroke_velocities.data());
+}
@@ -0,0 +1,298 @@
+#ifndef AERO_COMMON_CONVERSION_TABLES_H_
+#define AERO_COMMON_CONVERSION_TABLES_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+namespace aero
+{
+  namespace common
+  {
+    // version of cache file format
+    const static uint32_t CONVERSION_TABLES_VERSION = 1;
+
+    // values on the stack of a program while evaluating one statement
+    const static int CONVERSION_MAX_STACK = 32;
+
+    // local variables (float, dualJoint) of a program
+    const static int CONVERSION_MAX_LOCALS = 64;
+
+    /// @brief one degree of an angle to stroke table (A2SData)
+    struct ConversionA2SEntry
+    {
+      float stroke;
+      float interval;
+    };
+
+    /// @brief one row of a stroke to angle table (S2AData)
+    struct ConversionS2AEntry
+    {
+      int32_t angle;
+      float stroke;
+      float range;
+    };
+
+    /// @brief entries of one integer stroke (S2ABucket)
+    struct ConversionS2ABucket
+    {
+      int32_t candidates;
+      int32_t candidates_size;
+      int32_t appendix;
+      int32_t appendix_size;
+    };
+
+    /// @brief a table function of Angle2Stroke.cfg or Stroke2Angle.cfg
+    struct ConversionTable
+    {
+      /// @brief first entry, number of entries and Array*Offset,
+      ///   of A2S entries, or of S2A buckets
+      int32_t first;
+      int32_t size;
+      int32_t offset;
+
+      /// @brief second table of an A2S dual joint table (*Map2), size 0 if not
+      int32_t first2;
+      int32_t size2;
+      int32_t offset2;
+    };
+
+    enum ConversionType
+    {
+      CONVERSION_INT = 0,
+      CONVERSION_FLOAT = 1,
+      CONVERSION_DOUBLE = 2
+    };
+
+    enum ConversionOpCode
+    {
+      CONVERSION_OP_CONST = 0,   // push constants[arg]
+      CONVERSION_OP_INPUT = 1,   // push input[arg]
+      CONVERSION_OP_LOAD = 2,    // push local[arg]
+      CONVERSION_OP_STORE = 3,   // pop to local[arg]
+      CONVERSION_OP_OUTPUT = 4,  // pop to output[arg]
+      CONVERSION_OP_CAST = 5,    // convert top to type
+      CONVERSION_OP_NEG = 6,
+      CONVERSION_OP_ADD = 7,
+      CONVERSION_OP_SUB = 8,
+      CONVERSION_OP_MUL = 9,
+      CONVERSION_OP_DIV = 10,
+      CONVERSION_OP_A2S = 11,       // float table(float) of tables[arg]
+      CONVERSION_OP_A2S_DUAL = 12,  // push one, two of table(float, float)
+      CONVERSION_OP_S2A = 13        // float table(float) of tables[arg]
+    };
+
+    /// @brief one instruction, operations are done in type
+    ///   as the compiled expression would do
+    struct ConversionOp
+    {
+      uint8_t code;
+      uint8_t type;
+      uint16_t reserved;
+      int32_t arg;
+    };
+
+    /// @brief a compiled Angle2Stroke or Stroke2Angle function
+    struct ConversionProgram
+    {
+      int32_t first;
+      int32_t size;
+      int32_t inputs;
+      int32_t outputs;
+    };
+
+    /// @brief angles a stroke depends on, for UnusedAngle2Stroke
+    struct ConversionDepends
+    {
+      int32_t first;
+      int32_t size;
+    };
+
+    /// @brief string in the name pool
+    struct ConversionName
+    {
+      int32_t first;
+      int32_t size;
+    };
+
+    enum ConversionSectionId
+    {
+      CONVERSION_TABLES = 0,       // ConversionTable
+      CONVERSION_A2S_ENTRIES = 1,  // ConversionA2SEntry
+      CONVERSION_S2A_ENTRIES = 2,  // ConversionS2AEntry
+      CONVERSION_S2A_BUCKETS = 3,  // ConversionS2ABucket
+      CONVERSION_OPS = 4,          // ConversionOp
+      CONVERSION_CONSTANTS = 5,    // double
+      CONVERSION_PROGRAMS = 6,     // ConversionProgram, A2S then S2A
+      CONVERSION_DEPENDS = 7,      // ConversionDepends, per stroke
+      CONVERSION_DEPEND_IDS = 8,   // int32_t, angle ids
+      CONVERSION_NAMES = 9,        // ConversionName, angles then strokes
+      CONVERSION_CHARS = 10,       // char
+      CONVERSION_SECTIONS = 11
+    };
+
+    struct ConversionSection
+    {
+      /// @brief bytes from head of file, 8 byte aligned
+      uint32_t offset;
+
+      /// @brief number of elements
+      uint32_t size;
+    };
+
+    /// @brief head of cache file, sections follow
+    struct ConversionCacheHeader
+    {
+      /// @brief "AEROTBL" and zero
+      char magic[8];
+
+      uint32_t version;
+
+      /// @brief whole file size
+      uint32_t size;
+
+      /// @brief hash of all input files
+      uint64_t hash;
+
+      ConversionSection sections[CONVERSION_SECTIONS];
+    };
+
+    static_assert(sizeof(ConversionOp) == 8, "cache file layout changed");
+    static_assert(sizeof(ConversionCacheHeader) == 112,
+                  "cache file layout changed");
+
+    /// @brief angle and stroke conversion loaded at runtime
+    ///
+    /// Reads robot.cfg, the csv tables of each parts and
+    /// the equations of headers/{Angle2Stroke,Stroke2Angle}.hh
+    /// of a robot directory, instead of generated code.
+    /// The result is a flat binary image saved to a cache file,
+    /// which is mapped as is while the inputs have the same hash.
+    /// Conversions give the same values as the generated functions.
+    class ConversionTables
+    {
+    public: ConversionTables();
+
+    public: ~ConversionTables();
+
+    /// @brief load tables of a robot
+    /// @param _robot_dir e.g. aero_description/typeF
+    /// @param _cache_file rebuilt if missing or outdated, empty for no cache
+    /// @return false if inputs are missing or can not be parsed
+    public: bool load(const std::string& _robot_dir,
+                      const std::string& _cache_file);
+
+    public: void close();
+
+    public: bool loaded() const { return header_ != nullptr; }
+
+    /// @brief true if last load mapped a valid cache without parsing
+    public: bool from_cache() const { return from_cache_; }
+
+    /// @brief hash of input files
+    public: uint64_t hash() const;
+
+    /// @brief angle joints, ros order (upper then lower)
+    public: size_t number_of_angle_joints() const;
+
+    /// @brief strokes written by Angle2Stroke
+    public: size_t number_of_strokes() const;
+
+    public: std::vector<std::string> angle_joint_names() const;
+
+    /// @brief same as common::Angle2Stroke
+    /// @param _strokes number_of_strokes()
+    /// @param _angles number_of_angle_joints()
+    public: void Angle2Stroke(int16_t* _strokes, const double* _angles) const;
+
+    public: void Angle2Stroke(std::vector<int16_t>& _strokes,
+                              const std::vector<double>& _angles) const;
+
+    /// @brief same as common::UnusedAngle2Stroke
+    public: void UnusedAngle2Stroke(std::vector<int16_t>& _strokes,
+                                    const std::vector<bool>& _angles) const;
+
+    /// @brief same as common::Stroke2Angle
+    /// @param _angles number_of_angle_joints()
+    /// @param _strokes controller strokes in CAN order
+    public: void Stroke2Angle(double* _angles, const int16_t* _strokes) const;
+
+    public: void Stroke2Angle(std::vector<double>& _angles,
+                              const std::vector<int16_t>& _strokes) const;
+
+    /// @brief joint velocities of stroke velocities at _strokes,
+    ///   Jacobian of Stroke2Angle (slopes of the tables) times velocities
+    /// @param _velocities number_of_angle_joints() [rad/s]
+    /// @param _strokes controller strokes in CAN order
+    /// @param _stroke_velocities same order as _strokes [stroke/s]
+    public: void Stroke2AngleVelocity(double* _velocities,
+                                      const int16_t* _strokes,
+                                      const double* _stroke_velocities) const;
+
+    public: void Stroke2AngleVelocity(
+        std::vector<double>& _velocities, const std::vector<int16_t>& _strokes,
+        const std::vector<double>& _stroke_velocities) const;
+
+    /// @brief check and use an image in memory or mapped file
+    private: bool attach(const void* _image, size_t _size);
+
+    private: bool map(const std::string& _file, uint64_t _hash);
+
+    private: template<class T> const T* section(ConversionSectionId _id) const;
+
+    /// @brief evaluate a program, inputs and outputs are angles or strokes
+    private: template<class I, class O>
+    void run(const ConversionProgram& _program,
+             const I* _inputs, O* _outputs) const;
+
+    /// @brief evaluate a program as run, and derivatives of outputs
+    ///   from derivatives of inputs (forward mode)
+    private: template<class I>
+    void derive(const ConversionProgram& _program, const I* _inputs,
+                const double* _derivatives, double* _outputs) const;
+
+    /// @param _slope d stroke / d angle if not nullptr
+    private: float a2s(const ConversionTable& _table, float _angle,
+                       float* _slope = nullptr) const;
+
+    private: float a2s(const ConversionA2SEntry* _entries, int32_t _size,
+                       int32_t _offset, float _angle,
+                       float* _slope = nullptr) const;
+
+    /// @param _slope d angle / d stroke if not nullptr
+    private: float s2a(const ConversionTable& _table, float _stroke,
+                       float* _slope = nullptr) const;
+
+    private: const ConversionCacheHeader* header_;
+
+    private: std::vector<uint8_t> image_;
+
+    private: void* map_;
+
+    private: size_t map_size_;
+
+    private: bool from_cache_;
+
+    private: const ConversionTable* tables_;
+
+    private: const ConversionA2SEntry* a2s_entries_;
+
+    private: const ConversionS2AEntry* s2a_entries_;
+
+    private: const ConversionS2ABucket* s2a_buckets_;
+
+    private: const ConversionOp* ops_;
+
+    private: const double* constants_;
+
+    private: const ConversionProgram* programs_;
+
+    private: const ConversionDepends* depends_;
+
+    private: const int32_t* depend_ids_;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,1091 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cmath>
+#include <set>
+#include <dirent.h>
+
+#include <ros/package.h>
+
+#include "aero_hardware_interface/ConversionTablesBuilder.hh"
+
+using namespace aero;
+using namespace common;
+
+namespace
+{
+  /// @brief lines as "while read line" gives them,
+  ///   trimmed, and a last line without newline is not read
+  std::vector<std::string> read_lines(const std::string& _content)
+  {
+    std::vector<std::string> lines;
+    size_t begin = 0;
+    size_t end;
+    while ((end = _content.find('\n', begin)) != std::string::npos) {
+      std::string line = _content.substr(begin, end - begin);
+      size_t first = line.find_first_not_of(" \t\r");
+      size_t last = line.find_last_not_of(" \t\r");
+      lines.push_back(first == std::string::npos ?
+                      "" : line.substr(first, last - first + 1));
+      begin = end + 1;
+    }
+    return lines;
+  }
+
+  /// @brief fields as awk splits them
+  std::vector<std::string> fields(const std::string& _line)
+  {
+    std::vector<std::string> result;
+    std::istringstream stream(_line);
+    std::string field;
+    while (stream >> field)
+      result.push_back(field);
+    return result;
+  }
+
+  /// @brief n-th (from 1) field as "cut -d ',' -f n" gives it
+  std::string cut(const std::string& _line, int _n)
+  {
+    if (_line.find(',') == std::string::npos)
+      return _line;
+    size_t begin = 0;
+    for (int i = 1; i < _n; ++i) {
+      begin = _line.find(',', begin);
+      if (begin == std::string::npos)
+        return "";
+      ++begin;
+    }
+    return _line.substr(begin, _line.find(',', begin) - begin);
+  }
+
+  /// @brief "a + b" as bc prints it, scale is the larger of a and b
+  bool bc_add(const std::string& _a, const std::string& _b, std::string& _sum)
+  {
+    // decimal as integer of 10^-scale
+    auto parse = [](const std::string& _s, long long& _value, int& _scale) {
+      size_t i = 0;
+      bool negative = false;
+      if (i < _s.size() && (_s[i] == '-' || _s[i] == '+'))
+        negative = (_s[i++] == '-');
+      _value = 0;
+      _scale = -1;
+      bool digits = false;
+      for (; i < _s.size(); ++i) {
+        if (_s[i] == '.' && _scale < 0) {
+          _scale = 0;
+        } else if (isdigit(_s[i]) && _scale < 15) {
+          _value = _value * 10 + (_s[i] - '0');
+          if (_scale >= 0) ++_scale;
+          digits = true;
+        } else {
+          return false;
+        }
+      }
+      if (_scale < 0) _scale = 0;
+      if (negative) _value = -_value;
+      return digits;
+    };
+
+    long long a, b;
+    int scale_a, scale_b;
+    if (!parse(_a, a, scale_a) || !parse(_b, b, scale_b))
+      return false;
+    int scale = std::max(scale_a, scale_b);
+    for (int i = scale_a; i < scale; ++i) a *= 10;
+    for (int i = scale_b; i < scale; ++i) b *= 10;
+    long long sum = a + b;
+
+    if (sum == 0) {
+      _sum = "0";
+      return true;
+    }
+    std::string digits = std::to_string(sum < 0 ? -sum : sum);
+    if (static_cast<int>(digits.size()) <= scale)
+      digits.insert(0, scale - digits.size() + 1, '0');
+    std::string integer = digits.substr(0, digits.size() - scale);
+    if (integer == "0" && scale > 0)
+      integer = "";
+    _sum = (sum < 0 ? "-" : "") + integer;
+    if (scale > 0)
+      _sum += "." + digits.substr(digits.size() - scale);
+    return true;
+  }
+
+  /// @brief integer part of a bc value as make_stroke_to_angle_header.sh
+  ///   takes it, values without "." are taken as 0
+  int head_of(const std::string& _value)
+  {
+    size_t dot = _value.find('.');
+    if (dot == std::string::npos)
+      return 0;
+    return static_cast<int>(strtol(_value.substr(0, dot).c_str(), nullptr, 10));
+  }
+
+  void fnv1a(uint64_t& _hash, const std::string& _data)
+  {
+    for (size_t i = 0; i < _data.size(); ++i) {
+      _hash ^= static_cast<uint8_t>(_data[i]);
+      _hash *= 1099511628211ull;
+    }
+    _hash ^= 0;
+    _hash *= 1099511628211ull;
+  }
+
+  std::vector<std::string> list_dir(const std::string& _dir)
+  {
+    std::vector<std::string> names;
+    DIR* dir = opendir(_dir.c_str());
+    if (!dir)
+      return names;
+    while (struct dirent* entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name != "." && name != "..")
+        names.push_back(name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return names;
+  }
+
+  /// @brief remove comments from source
+  std::string strip_comments(const std::string& _source)
+  {
+    std::string result;
+    for (size_t i = 0; i < _source.size(); ++i) {
+      if (_source.compare(i, 2, "//") == 0) {
+        i = _source.find('\n', i);
+        if (i == std::string::npos) break;
+        result += '\n';
+      } else if (_source.compare(i, 2, "/*") == 0) {
+        i = _source.find("*/", i + 2);
+        if (i == std::string::npos) break;
+        ++i;
+        result += ' ';
+      } else {
+        result += _source[i];
+      }
+    }
+    return result;
+  }
+
+  std::vector<std::string> tokenize(const std::string& _source)
+  {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < _source.size()) {
+      char c = _source[i];
+      size_t begin = i;
+      if (isspace(c)) {
+        ++i;
+        continue;
+      } else if (isalpha(c) || c == '_') {
+        while (i < _source.size() && (isalnum(_source[i]) || _source[i] == '_'))
+          ++i;
+      } else if (isdigit(c) ||
+                 (c == '.' && i + 1 < _source.size() && isdigit(_source[i + 1]))) {
+        while (i < _source.size() && (isdigit(_source[i]) || _source[i] == '.'))
+          ++i;
+        if (i < _source.size() && (_source[i] == 'e' || _source[i] == 'E')) {
+          ++i;
+          if (i < _source.size() && (_source[i] == '+' || _source[i] == '-'))
+            ++i;
+          while (i < _source.size() && isdigit(_source[i]))
+            ++i;
+        }
+        if (i < _source.size() && strchr("fFlL", _source[i]))
+          ++i;
+      } else {
+        ++i;
+      }
+      tokens.push_back(_source.substr(begin, i - begin));
+    }
+    return tokens;
+  }
+
+  enum NodeKind
+  {
+    NODE_CONST,
+    NODE_INPUT,
+    NODE_LOCAL,
+    NODE_NEG,
+    NODE_BINARY,
+    NODE_CALL,
+    NODE_DUAL
+  };
+
+  // type of a dualJoint call, only valid as initializer
+  const static int TYPE_DUAL = 3;
+
+  struct Node
+  {
+    int kind;
+    int type;
+    int arg;
+    int a;
+    int b;
+  };
+
+  struct Local
+  {
+    int slot;
+    int type;
+    bool dual;
+    std::set<int32_t> depends;
+  };
+
+  /// @brief compiles statements of Angle2Stroke or Stroke2Angle
+  ///   into ConversionOp
+  class Compiler
+  {
+  public: Compiler(const std::vector<std::string>& _tokens,
+                   const std::vector<std::string>& _inputs, int _input_type,
+                   const std::map<std::string, int>& _tables,
+                   const std::vector<ConversionTable>& _table_data,
+                   bool _a2s,
+                   std::vector<ConversionOp>& _ops,
+                   std::vector<double>& _constants) :
+    tokens_(_tokens), inputs_(_inputs), input_type_(_input_type),
+    tables_(_tables), table_data_(_table_data), a2s_(_a2s),
+    ops_(_ops), constants_(_constants), pos_(0), slots_(0),
+    depth_(0), max_input_(-1), outputs_(0)
+    {
+    }
+
+  public: bool compile()
+    {
+      while (pos_ < tokens_.size()) {
+        if (accept(";"))
+          continue;
+        accept("const");
+        std::string word = peek();
+        if (word == "float" || word == "double" || word == "int" ||
+            word == "dualJoint") {
+          ++pos_;
+          if (!declare(word))
+            return false;
+        } else if (word == "meta") {
+          ++pos_;
+          if (!expect("="))
+            return false;
+          deps_.clear();
+          int node = expression();
+          if (node < 0 || !expect(";"))
+            return false;
+          if (nodes_[node].type == TYPE_DUAL)
+            return error("dualJoint is not a value");
+          generate(node);
+          emit(CONVERSION_OP_OUTPUT, nodes_[node].type, outputs_++, -1);
+          depends.push_back(deps_);
+        } else {
+          return error("unexpected \"" + word + "\"");
+        }
+      }
+      return true;
+    }
+
+  public: int inputs() const { return max_input_ + 1; }
+
+  public: int outputs() const { return outputs_; }
+
+  /// @brief inputs each output depends on
+  public: std::vector<std::set<int32_t> > depends;
+
+  public: std::string message;
+
+  private: bool declare(const std::string& _type)
+    {
+      std::string name = peek();
+      if (name.empty() || !(isalpha(name[0]) || name[0] == '_'))
+        return error("bad declaration");
+      ++pos_;
+      if (!expect("="))
+        return false;
+      deps_.clear();
+      int node = expression();
+      if (node < 0 || !expect(";"))
+        return false;
+
+      Local local;
+      local.slot = slots_;
+      local.dual = (_type == "dualJoint");
+      local.type = (_type == "int" ? CONVERSION_INT :
+                    _type == "double" ? CONVERSION_DOUBLE : CONVERSION_FLOAT);
+      slots_ += (local.dual ? 2 : 1);
+      if (slots_ > CONVERSION_MAX_LOCALS)
+        return error("too many variables");
+
+      if (local.dual) {
+        if (nodes_[node].kind != NODE_DUAL)
+          return error("dualJoint " + name + " must be a table");
+        generate(nodes_[node].a, CONVERSION_FLOAT);
+        generate(nodes_[node].b, CONVERSION_FLOAT);
+        emit(CONVERSION_OP_A2S_DUAL, CONVERSION_FLOAT, nodes_[node].arg, 1);
+        emit(CONVERSION_OP_STORE, CONVERSION_FLOAT, local.slot + 1, -1);
+        emit(CONVERSION_OP_STORE, CONVERSION_FLOAT, local.slot, -1);
+      } else {
+        if (nodes_[node].type == TYPE_DUAL)
+          return error("dualJoint is not a value");
+        generate(node, local.type);
+        emit(CONVERSION_OP_STORE, local.type, local.slot, -1);
+      }
+      local.depends = deps_;
+      locals_[name] = local;
+      return true;
+    }
+
+  private: int expression()
+    {
+      int node = term();
+      while (node >= 0 && (peek() == "+" || peek() == "-")) {
+        int code = (tokens_[pos_++] == "+" ?
+                    CONVERSION_OP_ADD : CONVERSION_OP_SUB);
+        int right = term();
+        node = binary(code, node, right);
+      }
+      return node;
+    }
+
+  private: int term()
+    {
+      int node = unary();
+      while (node >= 0 && (peek() == "*" || peek() == "/")) {
+        int code = (tokens_[pos_++] == "*" ?
+                    CONVERSION_OP_MUL : CONVERSION_OP_DIV);
+        int right = unary();
+        node = binary(code, node, right);
+      }
+      return node;
+    }
+
+  private: int unary()
+    {
+      if (accept("+"))
+        return unary();
+      if (accept("-")) {
+        int node = unary();
+        if (node < 0)
+          return -1;
+        if (nodes_[node].type == TYPE_DUAL)
+          return fail("dualJoint is not a value");
+        return add(NODE_NEG, nodes_[node].type, 0, node, -1);
+      }
+      return primary();
+    }
+
+  private: int primary()
+    {
+      std::string token = peek();
+      if (token.empty())
+        return fail("unexpected end");
+      ++pos_;
+
+      if (token == "(") {
+        int node = expression();
+        if (node < 0 || !expect(")"))
+          return -1;
+        return node;
+      }
+
+      if (isdigit(token[0]) || token[0] == '.')
+        return number(token);
+
+      if (!(isalpha(token[0]) || token[0] == '_'))
+        return fail("unexpected \"" + token + "\"");
+
+      // table function
+      if (accept("(")) {
+        auto table = tables_.find(token);
+        if (table == tables_.end())
+          return fail("unknown table " + token);
+        int a = expression();
+        if (a < 0)
+          return -1;
+        int b = -1;
+        if (accept(",")) {
+          b = expression();
+          if (b < 0)
+            return -1;
+        }
+        if (!expect(")"))
+          return -1;
+        bool dual = a2s_ && table_data_[table->second].size2 > 0;
+        if (dual != (b >= 0))
+          return fail("wrong number of arguments to " + token);
+        if (nodes_[a].type == TYPE_DUAL || (b >= 0 && nodes_[b].type == TYPE_DUAL))
+          return fail("dualJoint is not a value");
+        if (dual)
+          return add(NODE_DUAL, TYPE_DUAL, table->second, a, b);
+        return add(NODE_CALL, CONVERSION_FLOAT, table->second, a, -1);
+      }
+
+      auto local = locals_.find(token);
+      if (local != locals_.end()) {
+        deps_.insert(local->second.depends.begin(), local->second.depends.end());
+        if (!local->second.dual)
+          return add(NODE_LOCAL, local->second.type, local->second.slot, -1, -1);
+        if (!expect("."))
+          return -1;
+        std::string member = peek();
+        ++pos_;
+        if (member != "one" && member != "two")
+          return fail("dualJoint has no member " + member);
+        return add(NODE_LOCAL, CONVERSION_FLOAT,
+                   local->second.slot + (member == "two" ? 1 : 0), -1, -1);
+      }
+
+      auto input = std::find(inputs_.begin(), inputs_.end(), token);
+      if (input != inputs_.end()) {
+        int id = static_cast<int>(input - inputs_.begin());
+        max_input_ = std::max(max_input_, id);
+        deps_.insert(id);
+        return add(NODE_INPUT, input_type_, id, -1, -1);
+      }
+
+      if (token == "M_PI")
+        return constant(M_PI, CONVERSION_DOUBLE);
+
+      return fail("unknown name " + token);
+    }
+
+  /// @brief literal with its C++ type
+  private: int number(const std::string& _token)
+    {
+      char last = _token[_token.size() - 1];
+      if (last == 'f' || last == 'F')
+        return constant(static_cast<float>(strtod(_token.c_str(), nullptr)),
+                        CONVERSION_FLOAT);
+      if (_token.find_first_of(".eE") != std::string::npos)
+        return constant(strtod(_token.c_str(), nullptr), CONVERSION_DOUBLE);
+      return constant(strtol(_token.c_str(), nullptr, 10), CONVERSION_INT);
+    }
+
+  private: int constant(double _value, int _type)
+    {
+      constants_.push_back(_value);
+      return add(NODE_CONST, _type, static_cast<int>(constants_.size()) - 1,
+                 -1, -1);
+    }
+
+  /// @brief usual arithmetic conversions of int, float and double
+  private: int binary(int _code, int _a, int _b)
+    {
+      if (_b < 0)
+        return -1;
+      if (nodes_[_a].type == TYPE_DUAL || nodes_[_b].type == TYPE_DUAL)
+        return fail("dualJoint is not a value");
+      int type = std::max(nodes_[_a].type, nodes_[_b].type);
+      return add(NODE_BINARY, type, _code, _a, _b);
+    }
+
+  private: int add(int _kind, int _type, int _arg, int _a, int _b)
+    {
+      Node node = {_kind, _type, _arg, _a, _b};
+      nodes_.push_back(node);
+      return static_cast<int>(nodes_.size()) - 1;
+    }
+
+  /// @brief emit node, and convert to _type if given
+  private: void generate(int _node, int _type = -1)
+    {
+      const Node node = nodes_[_node];
+      switch (node.kind) {
+      case NODE_CONST:
+        emit(CONVERSION_OP_CONST, node.type, node.arg, 1);
+        break;
+      case NODE_INPUT:
+        emit(CONVERSION_OP_INPUT, node.type, node.arg, 1);
+        break;
+      case NODE_LOCAL:
+        emit(CONVERSION_OP_LOAD, node.type, node.arg, 1);
+        break;
+      case NODE_NEG:
+        generate(node.a);
+        emit(CONVERSION_OP_NEG, node.type, 0, 0);
+        break;
+      case NODE_BINARY:
+        generate(node.a, node.type);
+        generate(node.b, node.type);
+        emit(node.arg, node.type, 0, -1);
+        break;
+      case NODE_CALL:
+        generate(node.a, CONVERSION_FLOAT);
+        emit(a2s_ ? CONVERSION_OP_A2S : CONVERSION_OP_S2A,
+             CONVERSION_FLOAT, node.arg, 0);
+        break;
+      }
+      if (_type >= 0 && _type != node.type)
+        emit(CONVERSION_OP_CAST, _type, 0, 0);
+    }
+
+  private: void emit(int _code, int _type, int _arg, int _depth)
+    {
+      ConversionOp op;
+      op.code = static_cast<uint8_t>(_code);
+      op.type = static_cast<uint8_t>(_type);
+      op.reserved = 0;
+      op.arg = _arg;
+      ops_.push_back(op);
+      depth_ += _depth;
+      max_depth_ = std::max(max_depth_, depth_);
+    }
+
+  public: int max_depth() const { return max_depth_; }
+
+  private: std::string peek() const
+    {
+      return pos_ < tokens_.size() ? tokens_[pos_] : "";
+    }
+
+  private: bool accept(const std::string& _token)
+    {
+      if (peek() != _token)
+        return false;
+      ++pos_;
+      return true;
+    }
+
+  private: bool expect(const std::string& _token)
+    {
+      if (accept(_token))
+        return true;
+      return error("expected \"" + _token + "\" before \"" + peek() + "\"");
+    }
+
+  private: bool error(const std::string& _message)
+    {
+      if (message.empty())
+        message = _message;
+      return false;
+    }
+
+  private: int fail(const std::string& _message)
+    {
+      error(_message);
+      return -1;
+    }
+
+  private: const std::vector<std::string>& tokens_;
+
+  private: const std::vector<std::string>& inputs_;
+
+  private: int input_type_;
+
+  private: const std::map<std::string, int>& tables_;
+
+  private: const std::vector<ConversionTable>& table_data_;
+
+  private: bool a2s_;
+
+  private: std::vector<ConversionOp>& ops_;
+
+  private: std::vector<double>& constants_;
+
+  private: std::vector<Node> nodes_;
+
+  private: std::map<std::string, Local> locals_;
+
+  private: std::set<int32_t> deps_;
+
+  private: size_t pos_;
+
+  private: int slots_;
+
+  private: int depth_;
+
+  private: int max_depth_ = 0;
+
+  private: int max_input_;
+
+  private: int outputs_;
+  };
+}
+
+//////////////////////////////////////////////////
+ConversionTablesBuilder::ConversionTablesBuilder() : hash_(0)
+{
+}
+
+//////////////////////////////////////////////////
+bool ConversionTablesBuilder::read_file(const std::string& _path,
+                                        std::string& _content)
+{
+  std::ifstream file(_path.c_str(), std::ios::binary);
+  if (!file) {
+    std::cerr << "Tables: ERROR: could not read " << _path << std::endl;
+    return false;
+  }
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  _content = stream.str();
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ConversionTablesBuilder::read(const std::string& _robot_dir)
+{
+  std::string dir = _robot_dir;
+  while (dir.size() > 1 && dir[dir.size() - 1] == '/')
+    dir.erase(dir.size() - 1);
+  std::string description = dir + "/..";
+
+  angle_names_.clear();
+  stroke_names_.clear();
+  parts_.clear();
+
+  hash_ = 14695981039346656037ull;
+  fnv1a(hash_, std::to_string(CONVERSION_TABLES_VERSION));
+
+  std::string robot, constants;
+  if (!read_file(dir + "/robot.cfg", robot) ||
+      !read_file(dir + "/headers/Angle2Stroke.hh", a2s_header_) ||
+      !read_file(dir + "/headers/Stroke2Angle.hh", s2a_header_) ||
+      !read_file(dir + "/headers/Constants.hh", constants))
+    return false;
+  fnv1a(hash_, robot);
+  fnv1a(hash_, a2s_header_);
+  fnv1a(hash_, s2a_header_);
+  fnv1a(hash_, constants);
+
+  // joint order, *upper*.txt then the other .txt as setup.sh
+  std::string upper_file, lower_file;
+  std::vector<std::string> files = list_dir(dir);
+  for (auto it = files.begin(); it != files.end(); ++it)
+    if (upper_file.empty() && it->find("upper") != std::string::npos &&
+        it->find("txt", 1) != std::string::npos)
+      upper_file = *it;
+  for (auto it = files.begin(); it != files.end(); ++it)
+    if (lower_file.empty() && !upper_file.empty() &&
+        it->find("txt", 1) != std::string::npos &&
+        it->find(upper_file) == std::string::npos)
+      lower_file = *it;
+  if (upper_file.empty()) {
+    std::cerr << "Tables: ERROR: no *upper*.txt in " << dir << std::endl;
+    return false;
+  }
+  const std::string order_files[2] = {upper_file, lower_file};
+  for (int i = 0; i < 2; ++i) {
+    if (order_files[i].empty())
+      continue;
+    std::string order;
+    if (!read_file(dir + "/" + order_files[i], order))
+      return false;
+    fnv1a(hash_, order_files[i]);
+    fnv1a(hash_, order);
+    std::vector<std::string> names = read_lines(order);
+    angle_names_.insert(angle_names_.end(), names.begin(), names.end());
+  }
+
+  // CAN order, as make_controller.sh greps Constants.hh
+  std::istringstream constants_stream(constants);
+  std::string line;
+  while (std::getline(constants_stream, line)) {
+    if (line.find("CAN") == std::string::npos)
+      continue;
+    std::vector<std::string> f = fields(line);
+    std::string name = (f.size() > 3 ? f[3] : "");
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    stroke_names_.push_back(name);
+  }
+
+  // parts with csv tables
+  std::vector<std::string> lines = read_lines(robot);
+  for (auto it = lines.begin(); it != lines.end(); ++it) {
+    std::vector<std::string> f = fields(*it);
+    if (f.empty() || f[0] == "#" || f[0] == ":")
+      continue;
+
+    std::string shop = f[0].substr(0, f[0].find('/'));
+    std::string parts = f[0];
+    size_t slash = f[0].find('/');
+    if (slash != std::string::npos)
+      parts = f[0].substr(slash + 1, f[0].find('/', slash + 1) - slash - 1);
+
+    std::string parts_dir;
+    if (shop == "aero_shop")
+      parts_dir = description + "/../aero_shop/" + parts;
+    else
+      parts_dir = ros::package::getPath(shop) + "/" + parts;
+
+    bool has_csv = false;
+    files = list_dir(parts_dir);
+    for (auto file = files.begin(); file != files.end(); ++file)
+      if (file->size() >= 3 && file->compare(file->size() - 3, 3, "csv") == 0)
+        has_csv = true;
+    if (!has_csv)
+      continue;
+
+    Parts p;
+    p.name = shop + "/" + parts;
+    if (!read_parts(parts_dir, p))
+      return false;
+    parts_.push_back(p);
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ConversionTablesBuilder::read_parts(const std::string& _dir,
+                                         Parts& _parts)
+{
+  std::string csv_dir = _dir + "/csv/";
+  if (!read_file(csv_dir + "Angle2Stroke.cfg", _parts.a2s_cfg) ||
+      !read_file(csv_dir + "Stroke2Angle.cfg", _parts.s2a_cfg))
+    return false;
+  fnv1a(hash_, _parts.name);
+  fnv1a(hash_, _parts.a2s_cfg);
+  fnv1a(hash_, _parts.s2a_cfg);
+
+  // csv files used by cfg, in order of appearance
+  std::vector<std::string> names;
+  std::vector<std::string> lines = read_lines(_parts.a2s_cfg);
+  for (auto it = lines.begin(); it != lines.end(); ++it) {
+    std::vector<std::string> f = fields(*it);
+    if (f.size() > 2) names.push_back(f[2]);
+    if (f.size() > 5) names.push_back(f[3]);
+  }
+  lines = read_lines(_parts.s2a_cfg);
+  for (auto it = lines.begin(); it != lines.end(); ++it) {
+    std::vector<std::string> f = fields(*it);
+    if (f.size() > 2) names.push_back(f[2]);
+  }
+
+  for (auto it = names.begin(); it != names.end(); ++it) {
+    if (_parts.csv.count(*it) > 0)
+      continue;
+    std::string content;
+    if (!read_file(csv_dir + *it + ".csv", content))
+      return false;
+    fnv1a(hash_, *it);
+    fnv1a(hash_, content);
+    _parts.csv[*it] = content;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ConversionTablesBuilder::build(std::vector<uint8_t>& _image)
+{
+  tables_.clear();
+  a2s_entries_.clear();
+  s2a_entries_.clear();
+  s2a_buckets_.clear();
+  ops_.clear();
+  constants_.clear();
+  programs_.clear();
+  depends_.clear();
+  depend_ids_.clear();
+  a2s_ids_.clear();
+  s2a_ids_.clear();
+
+  if (!build_a2s_tables() || !build_s2a_tables() ||
+      !compile(a2s_header_, "Angle2Stroke", true) ||
+      !compile(s2a_header_, "Stroke2Angle", false))
+    return false;
+
+  write(_image);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ConversionTablesBuilder::build_a2s_tables()
+{
+  // same as create_table_func_from_csv of make_angle_to_stroke_header.sh,
+  // returns first entry and Array*Offset
+  auto load = [this](const std::string& _csv, const std::string& _offset,
+                     int32_t& _first, int32_t& _size, int32_t& _array_offset) {
+    _first = static_cast<int32_t>(a2s_entries_.size());
+    std::vector<std::string> lines = read_lines(_csv);
+    for (auto it = lines.begin(); it != lines.end(); ++it) {
+      std::string value;
+      if (!bc_add(_offset, cut(*it, 4), value))
+        return false;
+      ConversionA2SEntry entry;
+      entry.stroke = static_cast<float>(strtod(value.c_str(), nullptr));
+      entry.interval =
+        static_cast<float>(strtod(cut(*it, 3).c_str(), nullptr));
+      a2s_entries_.push_back(entry);
+    }
+    _size = static_cast<int32_t>(a2s_entries_.size()) - _first;
+    _array_offset = static_cast<int32_t>(
+        strtol(cut(_csv.substr(0, _csv.find('\n')), 1).c_str(), nullptr, 10));
+    return _size > 0;
+  };
+
+  for (auto parts = parts_.begin(); parts != parts_.end(); ++parts) {
+    std::vector<std::string> lines = read_lines(parts->a2s_cfg);
+    for (auto it = lines.begin(); it != lines.end(); ++it) {
+      std::vector<std::string> f = fields(*it);
+      if (f.empty())
+        continue;
+      if (f.size() < 5 || a2s_ids_.count(f[0]) > 0) {
+        std::cerr << "Tables: ERROR: bad table " << f[0] << " in "
+                  << parts->name << "/csv/Angle2Stroke.cfg" << std::endl;
+        return false;
+      }
+
+      ConversionTable table = {0, 0, 0, 0, 0, 0};
+      bool valid;
+      if (f.size() < 6) {
+        valid = load(parts->csv[f[2]], f[4],
+                     table.first, table.size, table.offset);
+      } else {
+        // *Map1 is the first csv with offset_r, *Map2 the second with offset_p
+        valid = (f.size() > 7) &&
+          load(parts->csv[f[2]], f[7], table.first, table.size, table.offset) &&
+          load(parts->csv[f[3]], f[5], table.first2, table.size2, table.offset2);
+      }
+      if (!valid) {
+        std::cerr << "Tables: ERROR: could not load table " << f[0]
+                  << " of " << parts->name << std::endl;
+        return false;
+      }
+      a2s_ids_[f[0]] = static_cast<int>(tables_.size());
+      tables_.push_back(table);
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ConversionTablesBuilder::build_s2a_tables()
+{
+  typedef std::vector<ConversionS2AEntry> Entries;
+
+  for (auto parts = parts_.begin(); parts != parts_.end(); ++parts) {
+    std::vector<std::string> lines = read_lines(parts->s2a_cfg);
+    for (auto it = lines.begin(); it != lines.end(); ++it) {
+      std::vector<std::string> f = fields(*it);
+      if (f.empty())
+        continue;
+      if (f.size() < 5 || s2a_ids_.count(f[0]) > 0) {
+        std::cerr << "Tables: ERROR: bad table " << f[0] << " in "
+                  << parts->name << "/csv/Stroke2Angle.cfg" << std::endl;
+        return false;
+      }
+
+      // same as create_table_func_from_csv of make_stroke_to_angle_header.sh,
+      // table and ntable are sparse arrays of bash (std::map here),
+      // their sizes are the numbers of set elements
+      std::map<int, Entries> table;
+      std::map<int, Entries> ntable;
+      ntable[0] = Entries();
+      bool has_before = false;
+      int before = 0;
+
+      std::vector<std::string> rows = read_lines(parts->csv[f[2]]);
+      for (auto row = rows.begin(); row != rows.end(); ++row) {
+        std::string value;
+        if (!bc_add(f[4], cut(*row, 4), value)) {
+          std::cerr << "Tables: ERROR: bad row \"" << *row << "\" of "
+                    << f[0] << std::endl;
+          return false;
+        }
+        ConversionS2AEntry entry;
+        entry.angle = static_cast<int32_t>(
+            strtol(cut(*row, 1).c_str(), nullptr, 10));
+        entry.stroke = static_cast<float>(strtod(value.c_str(), nullptr));
+        entry.range = static_cast<float>(strtod(cut(*row, 3).c_str(), nullptr));
+
+        int head = head_of(value);
+        std::map<int, Entries>& target = (head < 0 ? ntable : table);
+        if (head < 0)
+          head = -head;
+        if (has_before && head - before > 1)
+          target[head - 1] = Entries();
+        has_before = true;
+        before = head;
+        target[head].push_back(entry);
+      }
+
+      auto at = [](const std::map<int, Entries>& _table, int _index) {
+        auto found = _table.find(_index);
+        return found == _table.end() ? Entries() : found->second;
+      };
+
+      ConversionTable s2a = {0, 0, 0, 0, 0, 0};
+      s2a.first = static_cast<int32_t>(s2a_buckets_.size());
+      auto append = [this](const Entries& _candidates, const Entries& _appendix) {
+        ConversionS2ABucket bucket;
+        bucket.candidates = static_cast<int32_t>(s2a_entries_.size());
+        bucket.candidates_size = static_cast<int32_t>(_candidates.size());
+        bucket.appendix = bucket.candidates + bucket.candidates_size;
+        bucket.appendix_size = static_cast<int32_t>(_appendix.size());
+        s2a_entries_.insert(s2a_entries_.end(),
+                            _candidates.begin(), _candidates.end());
+        s2a_entries_.insert(s2a_entries_.end(),
+                            _appendix.begin(), _appendix.end());
+        s2a_buckets_.push_back(bucket);
+      };
+      const Entries empty(1, ConversionS2AEntry{0, 0.0f, 0.0f});
+
+      // negative stroke value case
+      int count = static_cast<int>(ntable.size());
+      int idx = count - 1;
+      Entries e = at(ntable, idx);
+      if (!e.empty()) {
+        append(e, Entries());
+        s2a.offset = -idx;
+      } else if (count > 1) {
+        s2a.offset = -(idx - 1);
+      }
+      for (idx = count - 2; idx >= 0; --idx) {
+        e = at(ntable, idx);
+        if (!e.empty()) {
+          int j = (at(ntable, idx + 1).empty() ? 2 : 1);
+          append(e, at(ntable, idx + j));
+        } else if (idx != 0) {
+          append(empty, Entries());
+        }
+      }
+
+      // positive stroke value case
+      count = static_cast<int>(table.size());
+      idx = 0;
+      for (auto it = table.begin(); it != table.end(); ++it, ++idx) {
+        if (!it->second.empty())
+          append(it->second,
+                 idx < count - 1 ? at(table, idx + 1) : Entries());
+        else
+          append(empty, Entries());
+      }
+
+      s2a.size = static_cast<int32_t>(s2a_buckets_.size()) - s2a.first;
+      if (s2a.size == 0) {
+        std::cerr << "Tables: ERROR: empty table " << f[0] << std::endl;
+        return false;
+      }
+      s2a_ids_[f[0]] = static_cast<int>(tables_.size());
+      tables_.push_back(s2a);
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ConversionTablesBuilder::compile(const std::string& _header,
+                                      const std::string& _name, bool _a2s)
+{
+  std::vector<std::string> tokens = tokenize(strip_comments(_header));
+
+  // body of the last "void _name(...) {...}" with "meta =" lines
+  std::vector<std::string> body;
+  for (size_t i = 0; i + 2 < tokens.size(); ++i) {
+    if (tokens[i] != "void" || tokens[i + 1] != _name || tokens[i + 2] != "(")
+      continue;
+    size_t k = i + 3;
+    int level = 1;
+    for (; k < tokens.size() && level > 0; ++k)
+      level += (tokens[k] == "(") - (tokens[k] == ")");
+    if (k >= tokens.size() || tokens[k] != "{")
+      continue;
+    size_t begin = ++k;
+    level = 1;
+    for (; k < tokens.size() && level > 0; ++k)
+      level += (tokens[k] == "{") - (tokens[k] == "}");
+    if (level > 0)
+      break;
+    std::vector<std::string> candidate(tokens.begin() + begin,
+                                       tokens.begin() + k - 1);
+    if (std::find(candidate.begin(), candidate.end(), "meta") !=
+        candidate.end())
+      body = candidate;
+  }
+  if (body.empty()) {
+    std::cerr << "Tables: ERROR: no " << _name << " with \"meta =\""
+              << std::endl;
+    return false;
+  }
+
+  ConversionProgram program;
+  program.first = static_cast<int32_t>(ops_.size());
+  Compiler compiler(body, _a2s ? angle_names_ : stroke_names_,
+                    _a2s ? CONVERSION_DOUBLE : CONVERSION_INT,
+                    _a2s ? a2s_ids_ : s2a_ids_, tables_, _a2s,
+                    ops_, constants_);
+  if (!compiler.compile()) {
+    std::cerr << "Tables: ERROR: " << _name << ": " << compiler.message
+              << std::endl;
+    return false;
+  }
+  if (compiler.max_depth() > CONVERSION_MAX_STACK) {
+    std::cerr << "Tables: ERROR: " << _name << ": too deep" << std::endl;
+    return false;
+  }
+  program.size = static_cast<int32_t>(ops_.size()) - program.first;
+  program.inputs = (_a2s ? static_cast<int32_t>(angle_names_.size())
+                    : compiler.inputs());
+  program.outputs = compiler.outputs();
+  programs_.push_back(program);
+
+  if (_a2s) {
+    for (auto it = compiler.depends.begin(); it != compiler.depends.end(); ++it) {
+      ConversionDepends d;
+      d.first = static_cast<int32_t>(depend_ids_.size());
+      d.size = static_cast<int32_t>(it->size());
+      depend_ids_.insert(depend_ids_.end(), it->begin(), it->end());
+      depends_.push_back(d);
+    }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+void ConversionTablesBuilder::write(std::vector<uint8_t>& _image) const
+{
+  ConversionCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  strncpy(header.magic, "AEROTBL", sizeof(header.magic));
+  header.version = CONVERSION_TABLES_VERSION;
+  header.hash = hash_;
+
+  std::vector<ConversionName> names;
+  std::string chars;
+  for (int i = 0; i < 2; ++i) {
+    const std::vector<std::string>& list = (i == 0 ? angle_names_ : stroke_names_);
+    for (auto it = list.begin(); it != list.end(); ++it) {
+      ConversionName name;
+      name.first = static_cast<int32_t>(chars.size());
+      name.size = static_cast<int32_t>(it->size());
+      chars += *it;
+      names.push_back(name);
+    }
+  }
+
+  _image.assign(sizeof(header), 0);
+  auto append = [&_image, &header](ConversionSectionId _id, const void* _data,
+                                   size_t _size, size_t _count) {
+    _image.resize((_image.size() + 7) / 8 * 8, 0);
+    header.sections[_id].offset = static_cast<uint32_t>(_image.size());
+    header.sections[_id].size = static_cast<uint32_t>(_count);
+    const uint8_t* data = static_cast<const uint8_t*>(_data);
+    _image.insert(_image.end(), data, data + _size * _count);
+  };
+  append(CONVERSION_TABLES, tables_.data(),
+         sizeof(ConversionTable), tables_.size());
+  append(CONVERSION_A2S_ENTRIES, a2s_entries_.data(),
+         sizeof(ConversionA2SEntry), a2s_entries_.size());
+  append(CONVERSION_S2A_ENTRIES, s2a_entries_.data(),
+         sizeof(ConversionS2AEntry), s2a_entries_.size());
+  append(CONVERSION_S2A_BUCKETS, s2a_buckets_.data(),
+         sizeof(ConversionS2ABucket), s2a_buckets_.size());
+  append(CONVERSION_OPS, ops_.data(), sizeof(ConversionOp), ops_.size());
+  append(CONVERSION_CONSTANTS, constants_.data(),
+         sizeof(double), constants_.size());
+  append(CONVERSION_PROGRAMS, programs_.data(),
+         sizeof(ConversionProgram), programs_.size());
+  append(CONVERSION_DEPENDS, depends_.data(),
+         sizeof(ConversionDepends), depends_.size());
+  append(CONVERSION_DEPEND_IDS, depend_ids_.data(),
+         sizeof(int32_t), depend_ids_.size());
+  append(CONVERSION_NAMES, names.data(), sizeof(ConversionName), names.size());
+  append(CONVERSION_CHARS, chars.data(), 1, chars.size());
+  _image.resize((_image.size() + 7) / 8 * 8, 0);
+
+  header.size = static_cast<uint32_t>(_image.size());
+  memcpy(_image.data(), &header, sizeof(header));
+}
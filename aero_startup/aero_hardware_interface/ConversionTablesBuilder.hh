@@ -0,0 +1,105 @@
+#ifndef AERO_COMMON_CONVERSION_TABLES_BUILDER_H_
+#define AERO_COMMON_CONVERSION_TABLES_BUILDER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "aero_hardware_interface/ConversionTables.hh"
+
+namespace aero
+{
+  namespace common
+  {
+    /// @brief parses the inputs of the code generators
+    ///   (aero_description/scripts/make_*_header.sh) into
+    ///   a ConversionTables image
+    ///
+    /// Tables are built as the scripts do, including bc arithmetic
+    /// of csv offsets, so that values are the same as generated code.
+    class ConversionTablesBuilder
+    {
+    public: ConversionTablesBuilder();
+
+    /// @brief read all input files of a robot
+    /// @param _robot_dir e.g. aero_description/typeF
+    public: bool read(const std::string& _robot_dir);
+
+    /// @brief hash of what read() found, for cache validation
+    public: uint64_t hash() const { return hash_; }
+
+    /// @brief parse inputs and write the image
+    public: bool build(std::vector<uint8_t>& _image);
+
+    /// @brief csv tables of one parts directory
+    private: struct Parts
+    {
+      /// @brief path in robot.cfg, for messages and hash
+      std::string name;
+
+      /// @brief Angle2Stroke.cfg and Stroke2Angle.cfg
+      std::string a2s_cfg;
+      std::string s2a_cfg;
+
+      /// @brief csv contents by file name without ".csv"
+      std::map<std::string, std::string> csv;
+    };
+
+    /// @brief returns false with message if file is missing
+    private: bool read_file(const std::string& _path, std::string& _content);
+
+    private: bool read_parts(const std::string& _dir, Parts& _parts);
+
+    private: bool build_a2s_tables();
+
+    private: bool build_s2a_tables();
+
+    /// @brief compile function _name of a header
+    /// @param _a2s true for Angle2Stroke
+    private: bool compile(const std::string& _header, const std::string& _name,
+                          bool _a2s);
+
+    private: void write(std::vector<uint8_t>& _image) const;
+
+    private: uint64_t hash_;
+
+    private: std::string a2s_header_;
+
+    private: std::string s2a_header_;
+
+    /// @brief angle joints, ros order (upper then lower)
+    private: std::vector<std::string> angle_names_;
+
+    /// @brief stroke names (can_*), CAN order
+    private: std::vector<std::string> stroke_names_;
+
+    private: std::vector<Parts> parts_;
+
+    /// @brief table id of a table function name
+    private: std::map<std::string, int> a2s_ids_;
+
+    private: std::map<std::string, int> s2a_ids_;
+
+    private: std::vector<ConversionTable> tables_;
+
+    private: std::vector<ConversionA2SEntry> a2s_entries_;
+
+    private: std::vector<ConversionS2AEntry> s2a_entries_;
+
+    private: std::vector<ConversionS2ABucket> s2a_buckets_;
+
+    private: std::vector<ConversionOp> ops_;
+
+    private: std::vector<double> constants_;
+
+    private: std::vector<ConversionProgram> programs_;
+
+    private: std::vector<ConversionDepends> depends_;
+
+    private: std::vector<int32_t> depend_ids_;
+    };
+  }
+}
+
+#endif
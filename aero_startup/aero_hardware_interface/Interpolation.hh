@@ -3,7 +3,7 @@
 
 #include <vector>
 #include <map>
-#include <functional>
+#include <array>
 #include <memory>
 
 namespace aero
@@ -25,51 +25,155 @@ namespace aero
 
     static const int i_cbezier = 6;
 
+    /// @brief control points of a curve, sigmoid has the most
+    typedef std::array<std::pair<float, float>, 6> Points;
+
+    /// @brief curve of type ID at t in [0, 1], inlined per type
+    template<int ID> struct Curve;
+
+    template<> struct Curve<i_constant>
+    {
+      static inline float at(const Points& /*p*/, float /*t*/)
+      {
+        return 0.0;
+      }
+    };
+
+    template<> struct Curve<i_linear>
+    {
+      static inline float at(const Points& /*p*/, float t)
+      {
+        return t;
+      }
+    };
+
+    template<> struct Curve<i_bezier>
+    {
+      static inline float at(const Points& p, float t)
+      {
+        return 2*t*(1-t)*p[1].second + t*t;
+      }
+    };
+
+    template<> struct Curve<i_slowout>
+    {
+      static inline float at(const Points& p, float t)
+      {
+        float tA = t / p[1].first;
+        float tB = (t - p[1].first) / (1 - p[1].first);
+        float sB = 1 - tB;
+        return t <= p[1].first ?
+          tA*p[1].second :
+          sB*sB*p[1].second + 2*sB*tB*p[2].second + tB*tB;
+      }
+    };
+
+    template<> struct Curve<i_slowin>
+    {
+      static inline float at(const Points& p, float t)
+      {
+        float tA = t / p[2].first;
+        float tB = (t - p[2].first) / (1 - p[2].first);
+        return t <= p[2].first ?
+          2*tA*(1-tA)*p[1].second + tA*tA*p[2].second :
+          (1 - tB)*p[2].second + tB;
+      }
+    };
+
+    template<> struct Curve<i_sigmoid>
+    {
+      static inline float at(const Points& p, float t)
+      {
+        float tA = t / p[2].first;
+        float tB = (t - p[2].first) / (p[3].first - p[2].first);
+        float tC = (t - p[3].first) / (1 - p[3].first);
+        float sC = 1 - tC;
+        return t <= p[2].first ?
+          2*tA*(1-tA)*p[1].second + tA*tA*p[2].second :
+          (t <= p[3].first ?
+           (1 - tB)*p[2].second + tB*p[3].second :
+           sC*sC*p[3].second + 2*sC*tC*p[4].second + tC*tC);
+      }
+    };
+
+    template<> struct Curve<i_cbezier>
+    {
+      static inline float at(const Points& p, float t)
+      {
+        float s = 1 - t;
+        return 3*s*s*t*p[1].second + 3*t*t*s*p[2].second + t*t*t;
+      }
+    };
+
     class Interpolation
     {
     public: Interpolation(int id);
 
     public: ~Interpolation();
 
-    public: bool is(const int id);
+    public: bool is(const int id) const;
+
+    /// @brief curve value at t in [0, 1],
+    ///   from the sample table if tabulated
+    public: inline float interpolate(float t) const
+    {
+      return table_ ? sample(t) : evaluate(t);
+    }
+
+    /// @brief set control point at (for curves with settable points)
+    public: void set_points(std::pair<float, float> p, int at);
 
-    public: std::function<float(float)> interpolate;
+    /// @brief evaluate from a table of samples + 1 values, shared by
+    ///   curves of same type and points, 0 evaluates the curve directly
+    public: void tabulate(int samples);
 
-    public: std::function<void(std::pair<float, float>, int)> set_points;
+    private: inline float evaluate(float t) const
+    {
+      switch (id_) {
+      case i_constant: return Curve<i_constant>::at(points_, t);
+      case i_linear: return Curve<i_linear>::at(points_, t);
+      case i_bezier: return Curve<i_bezier>::at(points_, t);
+      case i_slowin: return Curve<i_slowin>::at(points_, t);
+      case i_slowout: return Curve<i_slowout>::at(points_, t);
+      case i_sigmoid: return Curve<i_sigmoid>::at(points_, t);
+      case i_cbezier: return Curve<i_cbezier>::at(points_, t);
+      }
+      return 0.0;
+    }
+
+    private: inline float sample(float t) const
+    {
+      const std::vector<float>& table = *table_;
+      int samples = static_cast<int>(table.size()) - 1;
+      float x = t * samples;
+      if (!(x > 0)) return table[0];
+      if (x >= samples) return table[samples];
+      int i = static_cast<int>(x);
+      return table[i] + (x - i) * (table[i + 1] - table[i]);
+    }
 
     private: void init(const int n);
 
     private: void initConstant();
-    private: float Constant(float t);
-    private: void set_constant_p(std::pair<float, float> p, int at) {};
-
     private: void initLinear();
-    private: float Linear(float t);
-    private: void set_linear_p(std::pair<float, float> p, int at) {};
-
     private: void initBezier();
-    private: float Bezier(float t);
-    private: void set_bezier_p(std::pair<float, float> p, int at=0);
-
     private: void initSlowIn();
-    private: float SlowIn(float t);
-    private: void set_slowin_p(std::pair<float, float> p, int at=0);
-
     private: void initSlowOut();
-    private: float SlowOut(float t);
-    private: void set_slowout_p(std::pair<float, float> p, int at=0);
-
     private: void initSigmoid();
-    private: float Sigmoid(float t);
-    private: void set_sigmoid_p(std::pair<float, float> p, int at);
-
     private: void initCubicBezier();
-    private: float CubicBezier(float t);
+
+    private: void set_bezier_p(std::pair<float, float> p, int at=0);
+    private: void set_slowin_p(std::pair<float, float> p, int at=0);
+    private: void set_slowout_p(std::pair<float, float> p, int at=0);
+    private: void set_sigmoid_p(std::pair<float, float> p, int at);
     private: void set_cubicbezier_p(std::pair<float, float> p, int at);
 
     private: int id_;
 
-    private: std::vector<std::pair<float, float> > points_;
+    private: Points points_;
+
+    /// @brief samples of the curve, null if not tabulated
+    private: std::shared_ptr<const std::vector<float> > table_;
     };
 
     typedef std::shared_ptr<Interpolation> InterpolationPtr;
@@ -0,0 +1,217 @@
+#include "aero_hardware_interface/SeedCapture.hh"
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace aero;
+using namespace controller;
+
+static const char SEED_CAPTURE_MAGIC[8] = "SEEDCAP";
+
+//////////////////////////////////////////////////
+static bool write_all(int _fd, const void* _data, size_t _size)
+{
+  const uint8_t* p = static_cast<const uint8_t*>(_data);
+  while (_size > 0) {
+    ssize_t n = ::write(_fd, p, _size);
+    if (n < 0) return false;
+    p += n;
+    _size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+SeedCapture::SeedCapture(size_t _capacity) :
+  ring_(_capacity), fd_(-1), head_(0), tail_(0), dropped_(0),
+  running_(false)
+{
+}
+
+//////////////////////////////////////////////////
+SeedCapture::~SeedCapture()
+{
+  close();
+}
+
+//////////////////////////////////////////////////
+bool SeedCapture::open(const std::string& _file)
+{
+  close();
+
+  fd_ = ::open(_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0) {
+    std::cerr << "Capture: ERROR: could not open " << _file << std::endl;
+    return false;
+  }
+
+  start_ = clock::now();
+  SeedCaptureHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, SEED_CAPTURE_MAGIC, sizeof(header.magic));
+  header.version = SEED_CAPTURE_VERSION;
+  header.record_size = sizeof(SeedCaptureRecord);
+  header.start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::system_clock::now().time_since_epoch()).count();
+  if (!write_all(fd_, &header, sizeof(header))) {
+    std::cerr << "Capture: ERROR: could not write " << _file << std::endl;
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  head_ = 0;
+  tail_ = 0;
+  dropped_ = 0;
+  running_ = true;
+  flusher_ = std::thread(&SeedCapture::flush_loop_, this);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SeedCapture::close()
+{
+  if (flusher_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mtx_);
+      running_ = false;
+    }
+    cond_.notify_one();
+    flusher_.join();
+  }
+  if (fd_ >= 0) {
+    flush_();
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+//////////////////////////////////////////////////
+void SeedCapture::record(SeedCaptureDirection _direction,
+                         const uint8_t* _data, size_t _size)
+{
+  if (fd_ < 0) return;
+
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  if (head - tail_.load(std::memory_order_acquire) >= ring_.size()) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  SeedCaptureRecord& r = ring_[head % ring_.size()];
+  r.stamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now() - start_).count();
+  r.direction = static_cast<uint8_t>(_direction);
+  r.length = static_cast<uint8_t>(std::min(_size, RAW_DATA_LENGTH));
+  r.reserved = 0;
+  std::memcpy(r.data, _data, r.length);
+  std::memset(r.data + r.length, 0, RAW_DATA_LENGTH - r.length);
+
+  head_.store(head + 1, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+void SeedCapture::flush_loop_()
+{
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (running_) {
+    cond_.wait_for(lock, std::chrono::milliseconds(SEED_CAPTURE_FLUSH_MS));
+    lock.unlock();
+    flush_();
+    lock.lock();
+  }
+}
+
+//////////////////////////////////////////////////
+void SeedCapture::flush_()
+{
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  uint64_t head = head_.load(std::memory_order_acquire);
+
+  while (tail < head) {
+    // contiguous part of ring
+    size_t idx = tail % ring_.size();
+    size_t n = std::min<uint64_t>(head - tail, ring_.size() - idx);
+    if (!write_all(fd_, &ring_[idx], n * sizeof(SeedCaptureRecord))) {
+      std::cerr << "Capture: ERROR: write failed" << std::endl;
+      dropped_.fetch_add(head - tail, std::memory_order_relaxed);
+      tail = head;
+      break;
+    }
+    tail += n;
+  }
+
+  tail_.store(tail, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+SeedCaptureReader::SeedCaptureReader() :
+  map_(MAP_FAILED), map_size_(0), header_(nullptr), records_(nullptr),
+  size_(0)
+{
+}
+
+//////////////////////////////////////////////////
+SeedCaptureReader::~SeedCaptureReader()
+{
+  close();
+}
+
+//////////////////////////////////////////////////
+bool SeedCaptureReader::open(const std::string& _file)
+{
+  close();
+
+  int fd = ::open(_file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Capture: ERROR: could not open " << _file << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(SeedCaptureHeader)) {
+    std::cerr << "Capture: ERROR: " << _file << " is too short" << std::endl;
+    ::close(fd);
+    return false;
+  }
+
+  map_size_ = static_cast<size_t>(st.st_size);
+  map_ = ::mmap(nullptr, map_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (map_ == MAP_FAILED) {
+    std::cerr << "Capture: ERROR: could not map " << _file << std::endl;
+    return false;
+  }
+
+  header_ = static_cast<const SeedCaptureHeader*>(map_);
+  if (std::memcmp(header_->magic, SEED_CAPTURE_MAGIC,
+                  sizeof(header_->magic)) != 0 ||
+      header_->version != SEED_CAPTURE_VERSION ||
+      header_->record_size != sizeof(SeedCaptureRecord)) {
+    std::cerr << "Capture: ERROR: " << _file
+              << " is not a capture of version " << SEED_CAPTURE_VERSION
+              << std::endl;
+    close();
+    return false;
+  }
+
+  records_ = reinterpret_cast<const SeedCaptureRecord*>(header_ + 1);
+  size_ = (map_size_ - sizeof(SeedCaptureHeader)) / sizeof(SeedCaptureRecord);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SeedCaptureReader::close()
+{
+  if (map_ != MAP_FAILED) ::munmap(map_, map_size_);
+  map_ = MAP_FAILED;
+  map_size_ = 0;
+  header_ = nullptr;
+  records_ = nullptr;
+  size_ = 0;
+}
@@ -0,0 +1,188 @@
+#ifndef AERO_CONTROLLER_SEED_CAPTURE_H_
+#define AERO_CONTROLLER_SEED_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "aero_hardware_interface/SeedFrame.hh"
+
+namespace aero
+{
+  namespace controller
+  {
+    // number of records kept in memory before flushed to file
+    const static size_t SEED_CAPTURE_DEFAULT_CAPACITY = 4096;
+
+    // interval of flushing records to file [ms]
+    const static int SEED_CAPTURE_FLUSH_MS = 100;
+
+    // version of capture file format
+    const static uint32_t SEED_CAPTURE_VERSION = 1;
+
+    enum SeedCaptureDirection
+    {
+      SEED_CAPTURE_TX = 0,  // command sent to SEED controller
+      SEED_CAPTURE_RX = 1   // bytes received from SEED controller
+    };
+
+    /// @brief head of capture file
+    struct SeedCaptureHeader
+    {
+      /// @brief "SEEDCAP" and zero
+      char magic[8];
+
+      uint32_t version;
+
+      /// @brief sizeof(SeedCaptureRecord)
+      uint32_t record_size;
+
+      /// @brief wall clock of stamp_ns == 0 [ns since epoch]
+      uint64_t start_ns;
+
+      uint64_t reserved;
+    };
+
+    /// @brief one transfer on the bus,
+    ///   records follow the header back to back with fixed size
+    struct SeedCaptureRecord
+    {
+      /// @brief steady clock since capture started [ns]
+      uint64_t stamp_ns;
+
+      /// @brief SeedCaptureDirection
+      uint8_t direction;
+
+      /// @brief valid bytes in data
+      uint8_t length;
+
+      uint16_t reserved;
+
+      /// @brief a whole command (TX), or bytes as read from the port (RX),
+      ///   RX bytes are not aligned to frames
+      uint8_t data[RAW_DATA_LENGTH];
+    };
+
+    static_assert(sizeof(SeedCaptureHeader) == 32,
+                  "capture file layout changed");
+    static_assert(sizeof(SeedCaptureRecord) == 80,
+                  "capture file layout changed");
+
+    /// @brief low overhead recorder of bus traffic
+    ///
+    /// record() copies into a preallocated ring and never allocates,
+    /// locks or calls the kernel, so it can stay on in the control loop.
+    /// A flusher thread appends the ring to a binary file
+    /// every SEED_CAPTURE_FLUSH_MS, which SeedCaptureReader maps back.
+    /// Records are dropped (and counted) if the flusher falls behind.
+    class SeedCapture
+    {
+      /// @brief constructor
+      /// @param _capacity number of records in ring
+     public: explicit SeedCapture(
+         size_t _capacity=SEED_CAPTURE_DEFAULT_CAPACITY);
+
+      /// @brief destructor, flushes and closes file
+     public: ~SeedCapture();
+
+      /// @brief create file and start flusher thread
+      /// @param _file capture file name, truncated if exists
+      /// @return false if file could not be created
+     public: bool open(const std::string& _file);
+
+      /// @brief flush remaining records and close file
+     public: void close();
+
+      /// @brief append one transfer, single producer only
+      /// @param _direction SEED_CAPTURE_TX or SEED_CAPTURE_RX
+      /// @param _data bytes, at most RAW_DATA_LENGTH are kept
+      /// @param _size number of bytes
+     public: void record(SeedCaptureDirection _direction,
+                         const uint8_t* _data, size_t _size);
+
+     public: void record(SeedCaptureDirection _direction,
+                         const SeedFrame& _frame)
+      {
+        record(_direction, _frame.data(), _frame.size());
+      }
+
+      /// @brief number of records written to file
+     public: size_t flushed() const {return tail_;}
+
+      /// @brief number of records lost because ring was full
+     public: size_t dropped() const {return dropped_;}
+
+     private: void flush_loop_();
+
+      /// @brief write records in ring to file
+     private: void flush_();
+
+     private: typedef std::chrono::steady_clock clock;
+
+     private: std::vector<SeedCaptureRecord> ring_;
+
+     private: int fd_;
+
+     private: clock::time_point start_;
+
+      /// @brief next record to write, only producer writes
+     private: std::atomic<uint64_t> head_;
+
+      /// @brief next record to flush, only flusher writes
+     private: std::atomic<uint64_t> tail_;
+
+     private: std::atomic<uint64_t> dropped_;
+
+     private: bool running_;
+
+     private: std::mutex mtx_;
+
+     private: std::condition_variable cond_;
+
+     private: std::thread flusher_;
+    };
+
+    /// @brief read only view of a capture file on mmap
+    class SeedCaptureReader
+    {
+     public: SeedCaptureReader();
+
+     public: ~SeedCaptureReader();
+
+      /// @brief map capture file
+      /// @return false if file is not a capture of this version
+     public: bool open(const std::string& _file);
+
+     public: void close();
+
+      /// @brief number of complete records,
+      ///   a record cut by crash is ignored
+     public: size_t size() const {return size_;}
+
+     public: const SeedCaptureRecord& operator[](size_t _idx) const
+      {
+        return records_[_idx];
+      }
+
+     public: uint64_t start_ns() const {return header_->start_ns;}
+
+     private: void* map_;
+
+     private: size_t map_size_;
+
+     private: const SeedCaptureHeader* header_;
+
+     private: const SeedCaptureRecord* records_;
+
+     private: size_t size_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_SEED_CAPTURE_H_
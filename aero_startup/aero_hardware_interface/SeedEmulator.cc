@@ -0,0 +1,294 @@
+#include "aero_hardware_interface/SeedEmulator.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace aero;
+using namespace controller;
+
+// misstep flag in status bytes of CMD_WATCH_MISSTEP response
+static const uint8_t SEED_STATUS_MISSTEP = 0x20;
+
+// shortest time constant of actuator model [sec]
+static const double SEED_MIN_TIME_CONSTANT = 0.001;
+
+// ambient temperature of actuators [deg]
+static const double SEED_AMBIENT_TEMPERATURE = 30.0;
+
+//////////////////////////////////////////////////
+static int16_t read_short(const SeedFrame& _frame, size_t _slot)
+{
+  const uint8_t* raw = &_frame[RAW_HEADER_OFFSET + _slot * 2];
+  return static_cast<int16_t>((raw[0] << 8) | raw[1]);
+}
+
+//////////////////////////////////////////////////
+static void write_short(SeedFrame& _frame, size_t _slot, int16_t _value)
+{
+  uint8_t* raw = &_frame[RAW_HEADER_OFFSET + _slot * 2];
+  raw[0] = static_cast<uint8_t>(0xff & (_value >> 8));
+  raw[1] = static_cast<uint8_t>(0xff & _value);
+}
+
+//////////////////////////////////////////////////
+SeedEmulator::SeedEmulator(const SeedEmulatorConfig& _config) :
+  config_(_config), master_(-1), slave_(-1), rng_(_config.seed),
+  uniform_(0.0, 1.0), running_(false), frames_received_(0),
+  frames_sent_(0), dropped_bytes_(0), bad_checksums_(0)
+{
+  for (auto& s : slots_) {
+    s.position = 0.0;
+    s.velocity = 0.0;
+    s.target = 0.0;
+    s.time_constant = SEED_MIN_TIME_CONSTANT;
+    s.temperature = SEED_AMBIENT_TEMPERATURE;
+    s.misstep = false;
+  }
+  last_update_ = clock::now();
+}
+
+//////////////////////////////////////////////////
+SeedEmulator::~SeedEmulator()
+{
+  if (!link_.empty()) ::unlink(link_.c_str());
+  if (slave_ >= 0) ::close(slave_);
+  if (master_ >= 0) ::close(master_);
+}
+
+//////////////////////////////////////////////////
+bool SeedEmulator::open(const std::string& _link)
+{
+  master_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+  if (master_ < 0 || ::grantpt(master_) != 0 || ::unlockpt(master_) != 0) {
+    std::cerr << "Emulator: ERROR: could not create pty" << std::endl;
+    return false;
+  }
+  port_ = ::ptsname(master_);
+  ::fcntl(master_, F_SETFL, ::fcntl(master_, F_GETFL) | O_NONBLOCK);
+
+  // keep slave open, pty stays alive while controller reopens it,
+  // and raw mode stops the line discipline from echoing responses
+  slave_ = ::open(port_.c_str(), O_RDWR | O_NOCTTY);
+  if (slave_ < 0) {
+    std::cerr << "Emulator: ERROR: could not open " << port_ << std::endl;
+    return false;
+  }
+  struct termios tio;
+  ::tcgetattr(slave_, &tio);
+  ::cfmakeraw(&tio);
+  ::tcsetattr(slave_, TCSANOW, &tio);
+
+  if (!_link.empty()) {
+    struct stat st;
+    if (::lstat(_link.c_str(), &st) == 0 && S_ISLNK(st.st_mode))
+      ::unlink(_link.c_str());
+    if (::symlink(port_.c_str(), _link.c_str()) != 0) {
+      std::cerr << "Emulator: ERROR: could not link " << _link << std::endl;
+      return false;
+    }
+    link_ = _link;
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+void SeedEmulator::run_once(int _timeout_ms)
+{
+  clock::time_point now = clock::now();
+
+  // wake up in time for the next response
+  int timeout_ms = _timeout_ms;
+  if (!responses_.empty()) {
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        responses_.front().due - now).count();
+    timeout_ms = std::max(0, std::min(timeout_ms, static_cast<int>(wait)));
+  }
+
+  struct pollfd pfd;
+  pfd.fd = master_;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  if (::poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN)) {
+    uint8_t buf[256];
+    ssize_t n = ::read(master_, buf, sizeof(buf));
+    if (n > 0) {
+      if (config_.verbose) print_("recv", buf, n);
+      parser_.push(buf, static_cast<size_t>(n));
+    }
+  }
+
+  now = clock::now();
+  SeedFrame frame;
+  while (parser_.pop(frame)) handle_(frame, now);
+
+  while (!responses_.empty() && responses_.front().due <= clock::now()) {
+    send_(responses_.front());
+    responses_.pop_front();
+  }
+}
+
+//////////////////////////////////////////////////
+void SeedEmulator::run()
+{
+  running_ = true;
+  while (running_) run_once(10);
+}
+
+//////////////////////////////////////////////////
+void SeedEmulator::update_model_(clock::time_point _now)
+{
+  double dt = std::chrono::duration<double>(_now - last_update_).count();
+  if (dt <= 0.0) return;
+  last_update_ = _now;
+
+  for (auto& s : slots_) {
+    double alpha = 1.0 - std::exp(-dt / s.time_constant);
+    double next = s.position + (s.target - s.position) * alpha;
+    s.velocity = (next - s.position) / dt;
+    s.position = next;
+    // heats with motion, cools towards ambient in about a minute
+    double heat = SEED_AMBIENT_TEMPERATURE + 0.01 * std::fabs(s.velocity);
+    s.temperature += std::min(1.0, dt / 60.0) * (heat - s.temperature);
+  }
+}
+
+//////////////////////////////////////////////////
+void SeedEmulator::handle_(const SeedFrame& _frame, clock::time_point _now)
+{
+  update_model_(_now);
+  ++frames_received_;
+
+  // short frames (script, single current limit) have no response
+  if (_frame.size() != RAW_DATA_LENGTH) return;
+
+  uint8_t cmd = _frame.cmd();
+  uint8_t sub = _frame[4];
+  std::array<int16_t, SEED_MAX_STROKES> values;
+  values.fill(0);
+
+  switch (cmd) {
+  case CMD_MOVE_ABS_POS:
+  case CMD_MOVE_ABS_POS_RET:
+  case CMD_MOVE_INC_POS_RET: {
+    uint16_t csec = static_cast<uint16_t>(
+        (_frame[RAW_DATA_LENGTH - 3] << 8) | _frame[RAW_DATA_LENGTH - 2]);
+    double time_constant = std::max(SEED_MIN_TIME_CONSTANT,
+                                    config_.time_constant_scale * csec * 0.01);
+    for (size_t i = 0; i < SEED_MAX_STROKES; ++i) {
+      int16_t v = read_short(_frame, i);
+      if (v == 0x7fff) continue;  // not sent
+      Slot& s = slots_[i];
+      s.target = (cmd == CMD_MOVE_INC_POS_RET) ? s.position + v : v;
+      s.time_constant = time_constant;
+    }
+    if (cmd == CMD_MOVE_ABS_POS) return;
+  }
+  // fall through, RET commands reply current position
+  case CMD_GET_POS:
+    for (size_t i = 0; i < SEED_MAX_STROKES; ++i)
+      values[i] = static_cast<int16_t>(std::lround(slots_[i].position));
+    respond_(cmd, sub, values, _now);
+    break;
+  case CMD_GET_CUR:
+    for (size_t i = 0; i < SEED_MAX_STROKES; ++i)
+      values[i] = static_cast<int16_t>(
+          std::min(32767.0, 10.0 + 0.05 * std::fabs(slots_[i].velocity)));
+    respond_(cmd, sub, values, _now);
+    break;
+  case CMD_GET_TMP:
+    for (size_t i = 0; i < SEED_MAX_STROKES; ++i)
+      values[i] = static_cast<int16_t>(std::lround(slots_[i].temperature));
+    respond_(cmd, sub, values, _now);
+    break;
+  case CMD_GET_AD:
+  case CMD_GET_DIO:
+    respond_(cmd, sub, values, _now);
+    break;
+  case CMD_WATCH_MISSTEP: {
+    bool any = false;
+    for (size_t i = 0; i < SEED_MAX_STROKES; ++i) {
+      Slot& s = slots_[i];
+      if (sub == 0xff)  // reset
+        s.misstep = false;
+      else if (uniform_(rng_) < config_.misstep_rate)
+        s.misstep = true;
+      values[i] = s.misstep ? 1 : 0;
+      any = any || s.misstep;
+    }
+    respond_(cmd, sub, values, _now);
+    if (any) responses_.back().frame[RAW_HEADER_OFFSET + 60] = SEED_STATUS_MISSTEP;
+    break;
+  }
+  default:
+    // servo, current, speed, accel and gain settings have no response
+    break;
+  }
+}
+
+//////////////////////////////////////////////////
+void SeedEmulator::respond_(
+    uint8_t _cmd, uint8_t _sub,
+    const std::array<int16_t, SEED_MAX_STROKES>& _values,
+    clock::time_point _now)
+{
+  Response r;
+  r.frame.set_header(_cmd, _sub);
+  for (size_t i = 0; i < SEED_MAX_STROKES; ++i)
+    write_short(r.frame, i, _values[i]);
+
+  // processing latency and transmission of 10 bits per byte
+  double delay = config_.latency_ms * 1e-3
+    + config_.jitter_ms * 1e-3 * uniform_(rng_)
+    + RAW_DATA_LENGTH * 10.0 / config_.baud_rate;
+  r.due = _now + std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(delay));
+  // a board answers in order
+  if (!responses_.empty() && r.due < responses_.back().due)
+    r.due = responses_.back().due;
+
+  responses_.push_back(r);
+}
+
+//////////////////////////////////////////////////
+void SeedEmulator::send_(Response& _response)
+{
+  SeedFrame& frame = _response.frame;
+  frame.set_checksum();
+  if (uniform_(rng_) < config_.bad_checksum_rate) {
+    frame[frame.size() - 1] ^= 0x5a;
+    ++bad_checksums_;
+  }
+
+  uint8_t buf[RAW_DATA_LENGTH];
+  size_t n = 0;
+  for (size_t i = 0; i < frame.size(); ++i) {
+    if (uniform_(rng_) < config_.drop_rate) {
+      ++dropped_bytes_;
+      continue;
+    }
+    buf[n++] = frame[i];
+  }
+
+  if (config_.verbose) print_("send", buf, n);
+  if (::write(master_, buf, n) != static_cast<ssize_t>(n))
+    std::cerr << "Emulator: ERROR: write failed" << std::endl;
+  ++frames_sent_;
+}
+
+//////////////////////////////////////////////////
+void SeedEmulator::print_(const char* _tag, const uint8_t* _data, size_t _size)
+{
+  std::cout << _tag << ": ";
+  for (size_t i = 0; i < _size; ++i)
+    std::cout << std::setw(2) << std::uppercase << std::hex
+              << std::setfill('0') << static_cast<int32_t>(_data[i]);
+  std::cout << std::dec << "\n";
+}
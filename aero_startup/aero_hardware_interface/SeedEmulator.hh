@@ -0,0 +1,175 @@
+#ifndef AERO_CONTROLLER_SEED_EMULATOR_H_
+#define AERO_CONTROLLER_SEED_EMULATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <array>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+#include "aero_hardware_interface/CommandList.hh"
+#include "aero_hardware_interface/SeedFrame.hh"
+#include "aero_hardware_interface/SeedFrameParser.hh"
+#include "aero_hardware_interface/StrokeSnapshot.hh"
+
+namespace aero
+{
+  namespace controller
+  {
+    /// @brief settings of SeedEmulator
+    struct SeedEmulatorConfig
+    {
+      SeedEmulatorConfig() :
+        latency_ms(2.0), jitter_ms(0.5), baud_rate(1000000),
+        time_constant_scale(0.25), drop_rate(0.0), bad_checksum_rate(0.0),
+        misstep_rate(0.0), seed(0), verbose(false) {}
+
+      /// @brief board processing time before a response [ms]
+      double latency_ms;
+
+      /// @brief uniform random jitter added to latency [ms]
+      double jitter_ms;
+
+      /// @brief emulated line speed, adds transmission time of response
+      int baud_rate;
+
+      /// @brief time constant of actuator = scale * commanded time
+      double time_constant_scale;
+
+      /// @brief probability to drop each response byte
+      double drop_rate;
+
+      /// @brief probability to corrupt checksum of a response
+      double bad_checksum_rate;
+
+      /// @brief probability that a joint reports misstep per watch command
+      double misstep_rate;
+
+      /// @brief random seed of fault injection
+      unsigned int seed;
+
+      /// @brief print received and sent frames
+      bool verbose;
+    };
+
+    /// @brief virtual SEED board on a pseudo terminal
+    ///
+    /// Answers the commands of CommandList.hh like a SEED micom on RS485,
+    /// so the real SEED485Controller path can run without hardware.
+    /// Each of the 30 raw slots is a first-order actuator
+    /// following the last position command,
+    /// responses are delayed by latency and line transmission time,
+    /// and dropped bytes, bad checksums and missteps can be injected.
+    class SeedEmulator
+    {
+     public: typedef std::chrono::steady_clock clock;
+
+      /// @brief constructor
+      /// @param _config settings
+     public: explicit SeedEmulator(const SeedEmulatorConfig& _config);
+
+      /// @brief destructor, closes pty and removes link
+     public: ~SeedEmulator();
+
+      /// @brief create pty
+      /// @param _link if not empty, symlink to the pty slave (e.g. /tmp/aero_upper)
+      /// @return false if pty could not be created
+     public: bool open(const std::string& _link="");
+
+      /// @brief file name of pty slave, pass this as port to the controller
+     public: const std::string& port() const {return port_;}
+
+      /// @brief handle received bytes and send due responses
+      /// @param _timeout_ms maximum wait for bytes
+     public: void run_once(int _timeout_ms);
+
+      /// @brief run_once until stop() is called
+     public: void run();
+
+      /// @brief make run() return, thread safe
+     public: void stop() {running_ = false;}
+
+      /// @brief number of valid frames received
+     public: size_t frames_received() const {return frames_received_;}
+
+      /// @brief number of responses sent
+     public: size_t frames_sent() const {return frames_sent_;}
+
+      /// @brief number of response bytes dropped by fault injection
+     public: size_t dropped_bytes() const {return dropped_bytes_;}
+
+      /// @brief number of responses sent with bad checksum
+     public: size_t bad_checksums() const {return bad_checksums_;}
+
+      /// @brief emulated position of a raw slot
+     public: double position(size_t _slot) const {return slots_[_slot].position;}
+
+     private: struct Slot
+      {
+        double position;
+        double velocity;  // [stroke/sec], for current
+        double target;
+        double time_constant;  // [sec]
+        double temperature;
+        bool misstep;
+      };
+
+     private: struct Response
+      {
+        clock::time_point due;
+        SeedFrame frame;
+      };
+
+      /// @brief advance actuator model to _now
+     private: void update_model_(clock::time_point _now);
+
+     private: void handle_(const SeedFrame& _frame, clock::time_point _now);
+
+      /// @brief queue response of _cmd filled with _values
+     private: void respond_(uint8_t _cmd, uint8_t _sub,
+                            const std::array<int16_t, SEED_MAX_STROKES>& _values,
+                            clock::time_point _now);
+
+     private: void send_(Response& _response);
+
+     private: void print_(const char* _tag, const uint8_t* _data, size_t _size);
+
+     private: SeedEmulatorConfig config_;
+
+     private: int master_;
+
+     private: int slave_;
+
+     private: std::string port_;
+
+     private: std::string link_;
+
+     private: SeedFrameParser parser_;
+
+     private: std::array<Slot, SEED_MAX_STROKES> slots_;
+
+     private: std::deque<Response> responses_;
+
+     private: clock::time_point last_update_;
+
+     private: std::mt19937 rng_;
+
+     private: std::uniform_real_distribution<double> uniform_;
+
+     private: std::atomic<bool> running_;
+
+     private: std::atomic<size_t> frames_received_;
+
+     private: std::atomic<size_t> frames_sent_;
+
+     private: std::atomic<size_t> dropped_bytes_;
+
+     private: std::atomic<size_t> bad_checksums_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_SEED_EMULATOR_H_
@@ -0,0 +1,54 @@
+#include "aero_hardware_interface/SeedFrame.hh"
+
+using namespace aero;
+using namespace controller;
+
+//////////////////////////////////////////////////
+SeedFrame::SeedFrame(size_t _size) : size_(_size)
+{
+  data_.fill(0);
+}
+
+//////////////////////////////////////////////////
+void SeedFrame::set_header(uint8_t _cmd, uint8_t _sub)
+{
+  data_[0] = 0xFD;
+  data_[1] = 0xDF;
+  data_[2] = static_cast<uint8_t>(size_ - 4);
+  data_[3] = _cmd;
+  data_[4] = _sub;
+}
+
+//////////////////////////////////////////////////
+void SeedFrame::set_time(uint16_t _time)
+{
+  data_[RAW_DATA_LENGTH - 3] = static_cast<uint8_t>(0xff & (_time >> 8));
+  data_[RAW_DATA_LENGTH - 2] = static_cast<uint8_t>(0xff & _time);
+}
+
+//////////////////////////////////////////////////
+void SeedFrame::set_checksum()
+{
+  data_[size_ - 1] = seed_checksum_(data_.data(), size_);
+}
+
+//////////////////////////////////////////////////
+bool SeedFrame::valid() const
+{
+  return (size_ >= 6 && size_ <= RAW_DATA_LENGTH &&
+          data_[0] == 0xFD && data_[1] == 0xDF &&
+          data_[2] == size_ - 4 &&
+          data_[size_ - 1] == seed_checksum_(data_.data(), size_));
+}
+
+//////////////////////////////////////////////////
+uint8_t aero::controller::seed_checksum_(const uint8_t* _frame, size_t _size)
+{
+  int32_t b_check_sum = 0;
+
+  for (size_t i = 2; i < _size - 1; ++i) {
+    b_check_sum += _frame[i];
+  }
+
+  return ~(reinterpret_cast<uint8_t*>(&b_check_sum)[0]);
+}
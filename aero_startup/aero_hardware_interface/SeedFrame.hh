@@ -0,0 +1,75 @@
+#ifndef AERO_CONTROLLER_SEED_FRAME_H_
+#define AERO_CONTROLLER_SEED_FRAME_H_
+
+#include <array>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "aero_hardware_interface/CommandList.hh"
+
+namespace aero
+{
+  namespace controller
+  {
+    // length of short command frame (header, length, cmd, sub, 2 data, sum)
+    const static size_t SHORT_DATA_LENGTH = 8;
+
+    /// @brief one SEED frame on fixed storage,
+    ///   long (RAW_DATA_LENGTH) or short (SHORT_DATA_LENGTH) frame.
+    ///   Copying or creating a frame never allocates.
+    class SeedFrame
+    {
+      /// @brief constructor, zero filled
+      /// @param _size frame length
+     public: explicit SeedFrame(size_t _size=RAW_DATA_LENGTH);
+
+     public: uint8_t& operator[](size_t _idx) {return data_[_idx];}
+
+     public: const uint8_t& operator[](size_t _idx) const {return data_[_idx];}
+
+     public: uint8_t* data() {return data_.data();}
+
+     public: const uint8_t* data() const {return data_.data();}
+
+     public: size_t size() const {return size_;}
+
+      /// @brief change frame length, must be <= RAW_DATA_LENGTH
+     public: void resize(size_t _size) {size_ = _size;}
+
+      /// @brief fill zero, keeps frame length
+     public: void clear() {data_.fill(0);}
+
+      /// @brief command id of frame
+     public: uint8_t cmd() const {return data_[3];}
+
+      /// @brief write header, length byte, command and sub command
+     public: void set_header(uint8_t _cmd, uint8_t _sub);
+
+      /// @brief write destination time of long frame
+      /// @param _time time[10ms]
+     public: void set_time(uint16_t _time);
+
+      /// @brief write checksum into last byte
+     public: void set_checksum();
+
+      /// @brief true if header, length byte and checksum are consistent
+     public: bool valid() const;
+
+     private: std::array<uint8_t, RAW_DATA_LENGTH> data_;
+
+     private: size_t size_;
+    };
+
+  /////////////////////
+  // nonclass functions
+  /////////////////////
+
+  /// @brief SEED checksum, inverted lower byte of sum from length byte
+  ///   to the byte before checksum
+  /// @param _frame frame bytes starting with header
+  /// @param _size frame length including checksum
+  uint8_t seed_checksum_(const uint8_t* _frame, size_t _size);
+  }
+}
+
+#endif  // AERO_CONTROLLER_SEED_FRAME_H_
@@ -0,0 +1,79 @@
+#include "aero_hardware_interface/SeedFrameParser.hh"
+
+using namespace aero;
+using namespace controller;
+
+//////////////////////////////////////////////////
+SeedFrameParser::SeedFrameParser() :
+  head_(0), size_(0), skipped_bytes_(0), bad_checksums_(0)
+{
+}
+
+//////////////////////////////////////////////////
+void SeedFrameParser::push(const uint8_t* _data, size_t _size)
+{
+  for (size_t i = 0; i < _size; ++i) {
+    if (size_ == SEED_PARSER_BUFFER_LENGTH) {
+      // overflow, drop the oldest byte
+      drop_(1);
+      ++skipped_bytes_;
+    }
+    ring_[(head_ + size_) & (SEED_PARSER_BUFFER_LENGTH - 1)] = _data[i];
+    ++size_;
+  }
+}
+
+//////////////////////////////////////////////////
+bool SeedFrameParser::pop(SeedFrame& _frame)
+{
+  while (size_ >= 3) {
+    // header
+    if (at_(0) != 0xFD || at_(1) != 0xDF) {
+      drop_(1);
+      ++skipped_bytes_;
+      continue;
+    }
+
+    // header + length + (cmd, sub, data) + checksum,
+    // length byte 0x40 is a long frame and 0x04 is a short frame
+    size_t frame_size = static_cast<size_t>(at_(2)) + 4;
+    if (frame_size < 6 || frame_size > RAW_DATA_LENGTH) {
+      drop_(1);
+      ++skipped_bytes_;
+      continue;
+    }
+
+    if (size_ < frame_size) return false;  // wait for remaining bytes
+
+    _frame.resize(frame_size);
+    for (size_t i = 0; i < frame_size; ++i) _frame[i] = at_(i);
+
+    if (!_frame.valid()) {
+      // header was a part of data, search again from next byte
+      drop_(1);
+      ++skipped_bytes_;
+      ++bad_checksums_;
+      continue;
+    }
+
+    drop_(frame_size);
+    return true;
+  }
+
+  return false;
+}
+
+//////////////////////////////////////////////////
+void SeedFrameParser::clear()
+{
+  skipped_bytes_ += size_;
+  head_ = 0;
+  size_ = 0;
+}
+
+//////////////////////////////////////////////////
+void SeedFrameParser::drop_(size_t _size)
+{
+  head_ = (head_ + _size) & (SEED_PARSER_BUFFER_LENGTH - 1);
+  size_ -= _size;
+}
@@ -0,0 +1,72 @@
+#ifndef AERO_CONTROLLER_SEED_FRAME_PARSER_H_
+#define AERO_CONTROLLER_SEED_FRAME_PARSER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "aero_hardware_interface/SeedFrame.hh"
+
+namespace aero
+{
+  namespace controller
+  {
+    // ring buffer size of SeedFrameParser, must be power of 2
+    const static size_t SEED_PARSER_BUFFER_LENGTH = 512;
+
+    /// @brief incremental parser of SEED frames from a byte stream
+    ///
+    /// Bytes are pushed as they arrive from the serial port.
+    /// The parser scans for the 0xFD 0xDF header, checks the length byte
+    /// and the checksum, and skips misaligned bytes until the stream
+    /// is synchronized again, so a glitch costs at most one frame.
+    class SeedFrameParser
+    {
+      /// @brief constructor
+     public: SeedFrameParser();
+
+      /// @brief append received bytes,
+      ///   the oldest bytes are dropped when buffer overflows
+      /// @param _data received bytes
+      /// @param _size number of bytes
+     public: void push(const uint8_t* _data, size_t _size);
+
+      /// @brief extract the next complete and valid frame
+      /// @param _frame output frame, resized to the frame length
+      /// @return false if no complete frame is buffered yet
+     public: bool pop(SeedFrame& _frame);
+
+      /// @brief discard all buffered bytes
+     public: void clear();
+
+      /// @brief number of buffered bytes
+     public: size_t size() const {return size_;}
+
+      /// @brief number of bytes skipped to resynchronize
+     public: size_t skipped_bytes() const {return skipped_bytes_;}
+
+      /// @brief number of frames dropped for bad checksum
+     public: size_t bad_checksums() const {return bad_checksums_;}
+
+      /// @brief byte at _idx from the head of buffer
+     private: uint8_t at_(size_t _idx) const
+      {
+        return ring_[(head_ + _idx) & (SEED_PARSER_BUFFER_LENGTH - 1)];
+      }
+
+      /// @brief drop _size bytes from the head of buffer
+     private: void drop_(size_t _size);
+
+     private: uint8_t ring_[SEED_PARSER_BUFFER_LENGTH];
+
+     private: size_t head_;
+
+     private: size_t size_;
+
+     private: size_t skipped_bytes_;
+
+     private: size_t bad_checksums_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_SEED_FRAME_PARSER_H_
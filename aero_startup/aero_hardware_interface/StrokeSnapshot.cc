@@ -0,0 +1,75 @@
+#include "aero_hardware_interface/StrokeSnapshot.hh"
+
+#include <algorithm>
+
+using namespace aero;
+using namespace controller;
+
+// reader retries before giving up
+static const int STROKE_SNAPSHOT_RETRY = 8;
+
+//////////////////////////////////////////////////
+StrokeSnapshot::StrokeSnapshot() : latest_(0), seq_(0)
+{
+  for (size_t i = 0; i < 2; ++i) {
+    slots_[i].version.store(0, std::memory_order_relaxed);
+    StrokeState& s = slots_[i].state;
+    s.seq = 0;
+    s.stamp = std::chrono::steady_clock::time_point();
+    s.size = 0;
+    s.reference.fill(0);
+    s.actual.fill(0);
+    s.status.fill(0);
+    s.bad_status = false;
+  }
+}
+
+//////////////////////////////////////////////////
+void StrokeSnapshot::publish(const std::vector<int16_t>& _reference,
+                             const std::vector<int16_t>& _actual,
+                             const std::vector<int16_t>& _status,
+                             bool _bad_status)
+{
+  uint32_t idx = latest_.load(std::memory_order_relaxed) ^ 1;
+  Slot& slot = slots_[idx];
+
+  uint32_t version = slot.version.load(std::memory_order_relaxed);
+  slot.version.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  StrokeState& s = slot.state;
+  s.seq = seq_.load(std::memory_order_relaxed) + 1;
+  s.stamp = std::chrono::steady_clock::now();
+  s.size = std::min(_reference.size(), SEED_MAX_STROKES);
+  std::copy(_reference.begin(), _reference.begin() + s.size,
+            s.reference.begin());
+  // actual and status may be shorter before first response
+  size_t n = std::min(_actual.size(), s.size);
+  std::copy(_actual.begin(), _actual.begin() + n, s.actual.begin());
+  std::fill(s.actual.begin() + n, s.actual.begin() + s.size, 0);
+  n = std::min(_status.size(), s.size);
+  std::copy(_status.begin(), _status.begin() + n, s.status.begin());
+  std::fill(s.status.begin() + n, s.status.begin() + s.size, 0);
+  s.bad_status = _bad_status;
+
+  slot.version.store(version + 2, std::memory_order_release);
+  latest_.store(idx, std::memory_order_release);
+  seq_.store(s.seq, std::memory_order_release);
+}
+
+//////////////////////////////////////////////////
+bool StrokeSnapshot::read(StrokeState& _state) const
+{
+  for (int i = 0; i < STROKE_SNAPSHOT_RETRY; ++i) {
+    const Slot& slot = slots_[latest_.load(std::memory_order_acquire)];
+    uint32_t before = slot.version.load(std::memory_order_acquire);
+    if (before & 1) continue;  // writer lapped us and is writing this slot
+
+    _state = slot.state;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.version.load(std::memory_order_relaxed) == before)
+      return true;
+  }
+  return false;
+}
@@ -0,0 +1,85 @@
+#ifndef AERO_CONTROLLER_STROKE_SNAPSHOT_H_
+#define AERO_CONTROLLER_STROKE_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace aero
+{
+  namespace controller
+  {
+    // a long SEED frame carries at most 30 strokes
+    const static size_t SEED_MAX_STROKES = 30;
+
+    /// @brief consistent set of controller state at one moment
+    struct StrokeState
+    {
+      /// @brief incremented by every publish, 0 if never published
+      uint64_t seq;
+
+      /// @brief time of publish
+      std::chrono::steady_clock::time_point stamp;
+
+      /// @brief number of valid strokes in each array
+      size_t size;
+
+      std::array<int16_t, SEED_MAX_STROKES> reference;
+
+      std::array<int16_t, SEED_MAX_STROKES> actual;
+
+      std::array<int16_t, SEED_MAX_STROKES> status;
+
+      bool bad_status;
+    };
+
+    /// @brief double-buffered seqlock of StrokeState
+    ///
+    /// The writer fills the slot readers are not pointed at
+    /// and then switches the published index,
+    /// so readers never wait for the writer and never take a lock.
+    /// A read is only retried when the writer published twice
+    /// during the copy. Only one thread may publish at a time.
+    class StrokeSnapshot
+    {
+      /// @brief constructor, publishes empty state
+     public: StrokeSnapshot();
+
+      /// @brief publish new state, not thread safe among writers
+      /// @param _reference reference strokes
+      /// @param _actual actual strokes
+      /// @param _status status of each stroke
+      /// @param _bad_status true if any stroke reports error
+     public: void publish(const std::vector<int16_t>& _reference,
+                          const std::vector<int16_t>& _actual,
+                          const std::vector<int16_t>& _status,
+                          bool _bad_status);
+
+      /// @brief copy latest state, does not lock nor allocate
+      /// @param _state output state
+      /// @return false if writer kept overwriting the slot (should not happen)
+     public: bool read(StrokeState& _state) const;
+
+      /// @brief sequence number of latest state
+     public: uint64_t seq() const {return seq_.load(std::memory_order_acquire);}
+
+     private: struct Slot
+      {
+        std::atomic<uint32_t> version;  // odd while writing
+        StrokeState state;
+      };
+
+     private: Slot slots_[2];
+
+      /// @brief index of latest slot
+     private: std::atomic<uint32_t> latest_;
+
+     private: std::atomic<uint64_t> seq_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_STROKE_SNAPSHOT_H_
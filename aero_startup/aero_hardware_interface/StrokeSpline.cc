@@ -0,0 +1,216 @@
+#include <cmath>
+#include <algorithm>
+
+#include "aero_hardware_interface/StrokeSpline.hh"
+
+using namespace aero;
+using namespace interpolation;
+
+//////////////////////////////////////////////////
+// true if the cubic from _y0 to _y1 with slopes _d0 and _d1 over _h
+// leaves the range of _y0 and _y1 (by more than rounding)
+static bool overshoots(double _y0, double _y1, double _d0, double _d1,
+                       double _h)
+{
+  double delta = (_y1 - _y0) / _h;
+  double c2 = (3 * delta - 2 * _d0 - _d1) / _h;
+  double c3 = (_d0 + _d1 - 2 * delta) / (_h * _h);
+  // extremes where the slope d0 + 2 c2 u + 3 c3 u^2 is 0
+  double roots[2];
+  int count = 0;
+  if (std::fabs(c3) < 1e-300) {
+    if (c2 != 0) roots[count++] = -_d0 / (2 * c2);
+  } else {
+    double discriminant = c2 * c2 - 3 * c3 * _d0;
+    if (discriminant >= 0) {
+      roots[count++] = (-c2 + std::sqrt(discriminant)) / (3 * c3);
+      roots[count++] = (-c2 - std::sqrt(discriminant)) / (3 * c3);
+    }
+  }
+  double low = std::min(_y0, _y1) - 0.5, high = std::max(_y0, _y1) + 0.5;
+  for (int r = 0; r < count; ++r) {
+    double u = roots[r];
+    if (u <= 0 || u >= _h) continue;
+    double y = _y0 + u * (_d0 + u * (c2 + u * c3));
+    if (y < low || y > high) return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+StrokeSpline::StrokeSpline(const StrokeTimeline& _trajectory)
+  : strokes_(_trajectory.number_of_strokes())
+{
+  points_.reserve(_trajectory.size() * strokes_);
+  for (size_t k = 0; k < _trajectory.size(); ++k) {
+    if (!times_.empty() && _trajectory.time(k) <= times_.back())
+      continue;
+    times_.push_back(static_cast<double>(_trajectory.time(k)));
+    points_.resize(points_.size() + strokes_);
+    _trajectory.point(k, points_.data() + points_.size() - strokes_);
+  }
+  if (!valid())
+    return;
+
+  const size_t n = times_.size() - 1; // segments
+  splined_.assign(strokes_, 1);
+  for (size_t k = 0; k <= n; ++k)
+    for (size_t i = 0; i < strokes_; ++i)
+      if (points_[k * strokes_ + i] == 0x7fff)
+        splined_[i] = 0;
+
+  // second derivatives m of clamped splines solve
+  //   h[k-1] m[k-1] + 2 (h[k-1] + h[k]) m[k] + h[k] m[k+1] = r[k],
+  // the matrix only depends on times, so it is eliminated once
+  std::vector<double> h(n);
+  for (size_t k = 0; k < n; ++k)
+    h[k] = times_[k + 1] - times_[k];
+  std::vector<double> pivot(n + 1), upper(n + 1);
+  for (size_t k = 0; k <= n; ++k) {
+    double lower = (k > 0 ? h[k - 1] : 0.0);
+    pivot[k] = 2 * (lower + (k < n ? h[k] : 0.0))
+      - (k > 0 ? lower * upper[k - 1] : 0.0);
+    upper[k] = (k < n ? h[k] : 0.0) / pivot[k];
+  }
+
+  coefficients_.assign(n * strokes_ * 4, 0.0);
+  std::vector<double> m(n + 1), d(n + 1);
+  for (size_t i = 0; i < strokes_; ++i) {
+    if (!splined_[i])
+      continue;
+    auto y = [&](size_t k) {
+      return static_cast<double>(points_[k * strokes_ + i]);
+    };
+
+    // slopes are 0 at first and last point
+    for (size_t k = 0; k <= n; ++k) {
+      double slope_in = (k > 0 ? (y(k) - y(k - 1)) / h[k - 1] : 0.0);
+      double slope_out = (k < n ? (y(k + 1) - y(k)) / h[k] : 0.0);
+      m[k] = 6 * (slope_out - slope_in);
+      if (k > 0)
+        m[k] -= h[k - 1] * m[k - 1];
+      m[k] /= pivot[k];
+    }
+    for (size_t k = n; k-- > 0; )
+      m[k] -= upper[k] * m[k + 1];
+
+    // slopes d at points
+    for (size_t k = 0; k < n; ++k)
+      d[k] = (y(k + 1) - y(k)) / h[k] - h[k] * (2 * m[k] + m[k + 1]) / 6;
+    d[n] = (y(n) - y(n - 1)) / h[n - 1] + h[n - 1] * (m[n - 1] + 2 * m[n]) / 6;
+
+    // segments overshooting their points (e.g. past a point at a joint
+    // limit) get monotone slopes (Fritsch-Carlson), only ever smaller,
+    // so segments once limited stay within their points
+    for (bool limited = true; limited; ) {
+      limited = false;
+      for (size_t k = 0; k < n; ++k) {
+        if (!overshoots(y(k), y(k + 1), d[k], d[k + 1], h[k]))
+          continue;
+        double delta = (y(k + 1) - y(k)) / h[k];
+        if (delta == 0) {
+          d[k] = d[k + 1] = 0;
+        } else {
+          if (d[k] * delta < 0) d[k] = 0;
+          if (d[k + 1] * delta < 0) d[k + 1] = 0;
+          double a = d[k] / delta, b = d[k + 1] / delta;
+          if (a * a + b * b > 9) {
+            double tau = 3 / std::sqrt(a * a + b * b);
+            d[k] *= tau;
+            d[k + 1] *= tau;
+          }
+        }
+        limited = true;
+      }
+    }
+
+    // cubic Hermite of points and slopes, the C2 spline where not limited
+    for (size_t k = 0; k < n; ++k) {
+      double* c = coefficients_.data() + (k * strokes_ + i) * 4;
+      double delta = (y(k + 1) - y(k)) / h[k];
+      c[0] = y(k);
+      c[1] = d[k];
+      c[2] = (3 * delta - 2 * d[k] - d[k + 1]) / h[k];
+      c[3] = (d[k] + d[k + 1] - 2 * delta) / (h[k] * h[k]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+bool StrokeSpline::valid() const
+{
+  return times_.size() >= 2 && strokes_ > 0;
+}
+
+//////////////////////////////////////////////////
+size_t StrokeSpline::number_of_strokes() const
+{
+  return strokes_;
+}
+
+//////////////////////////////////////////////////
+int64_t StrokeSpline::duration() const
+{
+  return times_.empty() ? 0 : static_cast<int64_t>(times_.back());
+}
+
+//////////////////////////////////////////////////
+void StrokeSpline::sample(double _usec, int16_t* _strokes) const
+{
+  if (!valid()) {
+    std::fill(_strokes, _strokes + strokes_, 0x7fff);
+    return;
+  }
+
+  // segment k from times_[k] to times_[k + 1]
+  const size_t n = times_.size() - 1;
+  _usec = std::min(std::max(_usec, times_.front()), times_.back());
+  size_t k = std::upper_bound(times_.begin(), times_.end(), _usec)
+    - times_.begin();
+  k = std::min(std::max(k, static_cast<size_t>(1)), n) - 1;
+  double u = _usec - times_[k];
+  double t = u / (times_[k + 1] - times_[k]);
+
+  const int16_t* from = points_.data() + k * strokes_;
+  const int16_t* to = from + strokes_;
+  const double* c = coefficients_.data() + k * strokes_ * 4;
+  for (size_t i = 0; i < strokes_; ++i, c += 4) {
+    if (splined_[i]) {
+      double stroke = c[0] + u * (c[1] + u * (c[2] + u * c[3]));
+      // 0x7fff is no-send
+      stroke = std::min(std::max(stroke, -32768.0), 32766.0);
+      _strokes[i] = static_cast<int16_t>(std::lround(stroke));
+    } else if (to[i] == 0x7fff) {
+      _strokes[i] = 0x7fff;
+    } else if (from[i] == 0x7fff) {
+      _strokes[i] = to[i];
+    } else {
+      _strokes[i] = static_cast<int16_t>((1 - t) * from[i] + t * to[i]);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+StrokeTimeline StrokeSpline::resample(int64_t _usec_per_frame) const
+{
+  if (!valid() || _usec_per_frame <= 0)
+    return StrokeTimeline(strokes_);
+
+  int64_t start = static_cast<int64_t>(times_.front());
+  int64_t end = duration();
+  StrokeTimeline trajectory(strokes_, (end - start) / _usec_per_frame + 2);
+  std::vector<int16_t> strokes(strokes_);
+  size_t k = 0;
+  for (int64_t usec = start; ; usec += _usec_per_frame, ++k) {
+    if (usec > end)
+      usec = end;
+    sample(static_cast<double>(usec), strokes.data());
+    for (size_t i = 0; i < strokes_; ++i)
+      trajectory.stroke(k, i) = strokes[i];
+    trajectory.set_time(k, usec);
+    if (usec == end)
+      break;
+  }
+  trajectory.resize(k + 1);
+  return trajectory;
+}
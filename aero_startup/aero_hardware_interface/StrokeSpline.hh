@@ -0,0 +1,65 @@
+#ifndef AERO_INTERPOLATION_STROKE_SPLINE_H_
+#define AERO_INTERPOLATION_STROKE_SPLINE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "aero_hardware_interface/StrokeTimeline.hh"
+
+namespace aero
+{
+  namespace interpolation
+  {
+    /// @brief cubic splines through all points of a stroke trajectory,
+    ///   one per stroke, C2 continuous at points and at rest (zero velocity)
+    ///   at first and last point
+    ///
+    /// Segments which would overshoot their points get monotone slopes
+    /// (Fritsch-Carlson), they stay within their points and are only C1.
+    ///
+    /// Strokes which are no-send (0x7fff) at any point are not splined,
+    /// they follow the points linearly as TrajectoryScheduler does.
+    class StrokeSpline
+    {
+    /// @brief fit splines to _trajectory,
+    ///   points not later than the previous point are skipped
+    public: explicit StrokeSpline(const StrokeTimeline& _trajectory);
+
+    /// @brief false if there are less than two points to fit
+    public: bool valid() const;
+
+    /// @brief number of strokes of a point
+    public: size_t number_of_strokes() const;
+
+    /// @brief time of the last point [usec]
+    public: int64_t duration() const;
+
+    /// @brief strokes at time _usec, clamped to the first and last point,
+    ///   does not allocate
+    /// @param _strokes number_of_strokes() strokes
+    public: void sample(double _usec, int16_t* _strokes) const;
+
+    /// @brief points every _usec_per_frame from the first point
+    ///   to the last point (included)
+    public: StrokeTimeline resample(int64_t _usec_per_frame) const;
+
+    /// @brief time of points fitted [usec]
+    private: std::vector<double> times_;
+
+    /// @brief strokes of points fitted, points x strokes
+    private: std::vector<int16_t> points_;
+
+    /// @brief true if the stroke is splined
+    private: std::vector<char> splined_;
+
+    /// @brief a + b u + c u^2 + d u^3 per segment and stroke,
+    ///   u is time from the start of the segment [usec]
+    private: std::vector<double> coefficients_;
+
+    private: size_t strokes_;
+    };
+  }
+}
+
+#endif
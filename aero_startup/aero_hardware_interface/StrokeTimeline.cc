@@ -0,0 +1,129 @@
+#include <algorithm>
+
+#include "aero_hardware_interface/StrokeTimeline.hh"
+
+using namespace aero;
+using namespace interpolation;
+
+//////////////////////////////////////////////////
+StrokeTimeline::StrokeTimeline()
+  : number_of_strokes_(0), points_(0), capacity_(0)
+{
+}
+
+//////////////////////////////////////////////////
+StrokeTimeline::StrokeTimeline(size_t _strokes, size_t _points)
+  : number_of_strokes_(_strokes), points_(0), capacity_(0)
+{
+  resize(_points);
+}
+
+//////////////////////////////////////////////////
+size_t StrokeTimeline::number_of_strokes() const
+{
+  return number_of_strokes_;
+}
+
+//////////////////////////////////////////////////
+size_t StrokeTimeline::size() const
+{
+  return points_;
+}
+
+//////////////////////////////////////////////////
+bool StrokeTimeline::empty() const
+{
+  return points_ == 0;
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::resize(size_t _points)
+{
+  if (_points > capacity_)
+    reserve_(std::max(_points, capacity_ * 2));
+  // only new points, points past the end are refilled when reused
+  for (size_t i = 0; i < number_of_strokes_ && _points > points_; ++i)
+    std::fill(strokes_.begin() + i * capacity_ + points_,
+              strokes_.begin() + i * capacity_ + _points, 0x7fff);
+  times_.resize(_points, 0);
+  points_ = _points;
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::reserve(size_t _points)
+{
+  if (_points > capacity_)
+    reserve_(_points);
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::push_back(const int16_t* _strokes, int64_t _usec)
+{
+  resize(points_ + 1);
+  for (size_t i = 0; i < number_of_strokes_; ++i)
+    stroke(points_ - 1, i) = _strokes[i];
+  times_.back() = _usec;
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::push_back(const std::vector<int16_t>& _strokes,
+                               int64_t _usec)
+{
+  push_back(_strokes.data(), _usec);
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::push_back(std::initializer_list<int16_t> _strokes,
+                               int64_t _usec)
+{
+  push_back(_strokes.begin(), _usec);
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::erase_front(size_t _points)
+{
+  _points = std::min(_points, points_);
+  if (_points == 0)
+    return;
+  for (size_t i = 0; i < number_of_strokes_; ++i) {
+    auto channel = strokes_.begin() + i * capacity_;
+    std::copy(channel + _points, channel + points_, channel);
+  }
+  times_.erase(times_.begin(), times_.begin() + _points);
+  points_ -= _points;
+}
+
+//////////////////////////////////////////////////
+int64_t StrokeTimeline::duration() const
+{
+  return times_.empty() ? 0 : times_.back();
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::point(size_t _k, int16_t* _strokes) const
+{
+  for (size_t i = 0; i < number_of_strokes_; ++i)
+    _strokes[i] = stroke(_k, i);
+}
+
+//////////////////////////////////////////////////
+std::vector<int16_t> StrokeTimeline::point(size_t _k) const
+{
+  std::vector<int16_t> strokes(number_of_strokes_);
+  point(_k, strokes.data());
+  return strokes;
+}
+
+//////////////////////////////////////////////////
+void StrokeTimeline::reserve_(size_t _capacity)
+{
+  // channels move to their new offsets
+  std::vector<int16_t> strokes(number_of_strokes_ * _capacity, 0x7fff);
+  for (size_t i = 0; i < number_of_strokes_; ++i)
+    std::copy(strokes_.begin() + i * capacity_,
+              strokes_.begin() + i * capacity_ + points_,
+              strokes.begin() + i * _capacity);
+  strokes_.swap(strokes);
+  times_.reserve(_capacity);
+  capacity_ = _capacity;
+}
@@ -0,0 +1,98 @@
+#ifndef AERO_INTERPOLATION_STROKE_TIMELINE_H_
+#define AERO_INTERPOLATION_STROKE_TIMELINE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <initializer_list>
+
+namespace aero
+{
+  namespace interpolation
+  {
+    /// @brief points of a stroke trajectory, strokes and time [usec]
+    ///
+    /// Strokes of all points are in one buffer, stroke by stroke
+    /// (channel(i) is stroke i of every point), times are 64 bit
+    /// microseconds from the start of the trajectory.
+    class StrokeTimeline
+    {
+    public: StrokeTimeline();
+
+    /// @param _strokes strokes of a point
+    /// @param _points number of points, no-send (0x7fff) at time 0
+    public: explicit StrokeTimeline(size_t _strokes, size_t _points=0);
+
+    public: size_t number_of_strokes() const;
+
+    /// @brief number of points
+    public: size_t size() const;
+
+    public: bool empty() const;
+
+    /// @brief keep first _points points, new points are no-send at time 0
+    public: void resize(size_t _points);
+
+    /// @brief allocate for _points points, so push_back up to them
+    ///   does not reallocate
+    public: void reserve(size_t _points);
+
+    /// @brief add a point
+    /// @param _strokes number_of_strokes() strokes
+    /// @param _usec time of the point [usec]
+    public: void push_back(const int16_t* _strokes, int64_t _usec);
+
+    public: void push_back(const std::vector<int16_t>& _strokes,
+                           int64_t _usec);
+
+    public: void push_back(std::initializer_list<int16_t> _strokes,
+                           int64_t _usec);
+
+    /// @brief remove first _points points
+    public: void erase_front(size_t _points);
+
+    /// @brief time of point _k [usec]
+    public: int64_t time(size_t _k) const
+    { return times_[_k]; };
+
+    public: void set_time(size_t _k, int64_t _usec)
+    { times_[_k] = _usec; };
+
+    /// @brief time of the last point [usec], 0 if empty
+    public: int64_t duration() const;
+
+    /// @brief stroke _i of point _k
+    public: int16_t stroke(size_t _k, size_t _i) const
+    { return strokes_[_i * capacity_ + _k]; };
+
+    public: int16_t& stroke(size_t _k, size_t _i)
+    { return strokes_[_i * capacity_ + _k]; };
+
+    /// @brief stroke _i of all points, size() strokes
+    public: const int16_t* channel(size_t _i) const
+    { return strokes_.data() + _i * capacity_; };
+
+    /// @brief copy strokes of point _k
+    /// @param _strokes number_of_strokes() strokes
+    public: void point(size_t _k, int16_t* _strokes) const;
+
+    public: std::vector<int16_t> point(size_t _k) const;
+
+    /// @brief points reserved per stroke
+    private: void reserve_(size_t _capacity);
+
+    private: size_t number_of_strokes_;
+
+    private: size_t points_;
+
+    private: size_t capacity_;
+
+    /// @brief number_of_strokes_ x capacity_
+    private: std::vector<int16_t> strokes_;
+
+    private: std::vector<int64_t> times_;
+    };
+  }
+}
+
+#endif
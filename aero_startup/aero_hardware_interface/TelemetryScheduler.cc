@@ -0,0 +1,111 @@
+#include "aero_hardware_interface/TelemetryScheduler.hh"
+
+using namespace aero;
+using namespace controller;
+
+// weight of the latest sample in averaged costs and utilization
+static const double TELEMETRY_AVERAGE_WEIGHT = 0.1;
+
+//////////////////////////////////////////////////
+static double to_sec(TelemetryScheduler::clock::duration _d)
+{
+  return std::chrono::duration<double>(_d).count();
+}
+
+//////////////////////////////////////////////////
+static TelemetryScheduler::clock::duration from_sec(double _sec)
+{
+  return std::chrono::duration_cast<TelemetryScheduler::clock::duration>(
+      std::chrono::duration<double>(_sec));
+}
+
+//////////////////////////////////////////////////
+TelemetryScheduler::TelemetryScheduler(double _period, double _margin) :
+  period_(from_sec(_period)), margin_(from_sec(_margin)),
+  motion_cost_(0.0), cycle_busy_(clock::duration::zero()),
+  cycle_started_(false), turn_(0), utilization_(0.0)
+{
+  for (size_t i = 0; i < NUM_TELEMETRY; ++i) {
+    interval_[i] = clock::duration::zero();
+    last_request_[i] = clock::time_point();
+    cost_[i] = 0.0;
+  }
+}
+
+//////////////////////////////////////////////////
+void TelemetryScheduler::set_rate(TelemetryItem _item, double _rate)
+{
+  if (_rate > 0.0)
+    interval_[_item] = from_sec(1.0 / _rate);
+  else
+    interval_[_item] = clock::duration::zero();
+}
+
+//////////////////////////////////////////////////
+void TelemetryScheduler::begin_cycle(clock::time_point _now)
+{
+  if (cycle_started_) {
+    // close previous period, it may have been longer than period_
+    double elapsed = to_sec(_now - cycle_start_);
+    if (elapsed > 0.0) {
+      double ratio = to_sec(cycle_busy_) / elapsed;
+      utilization_ += TELEMETRY_AVERAGE_WEIGHT * (ratio - utilization_);
+    }
+  }
+  cycle_start_ = _now;
+  cycle_busy_ = clock::duration::zero();
+  cycle_started_ = true;
+}
+
+//////////////////////////////////////////////////
+void TelemetryScheduler::record(clock::duration _busy)
+{
+  cycle_busy_ += _busy;
+  double sec = to_sec(_busy);
+  if (motion_cost_ == 0.0)
+    motion_cost_ = sec;
+  else
+    motion_cost_ += TELEMETRY_AVERAGE_WEIGHT * (sec - motion_cost_);
+}
+
+//////////////////////////////////////////////////
+bool TelemetryScheduler::next(clock::time_point _now, TelemetryItem& _item)
+{
+  if (!cycle_started_) return false;
+
+  clock::time_point deadline = cycle_start_ + period_ - margin_;
+
+  for (size_t k = 0; k < NUM_TELEMETRY; ++k) {
+    size_t i = (turn_ + k) % NUM_TELEMETRY;
+    if (interval_[i] == clock::duration::zero()) continue;  // disabled
+    if (_now - last_request_[i] < interval_[i]) continue;  // not due
+    TelemetryItem item = static_cast<TelemetryItem>(i);
+    if (_now + from_sec(cost(item)) > deadline) continue;  // does not fit
+
+    _item = item;
+    last_request_[i] = _now;
+    turn_ = (i + 1) % NUM_TELEMETRY;
+    return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+void TelemetryScheduler::done(TelemetryItem _item, clock::duration _busy)
+{
+  cycle_busy_ += _busy;
+  double sec = to_sec(_busy);
+  if (cost_[_item] == 0.0)
+    cost_[_item] = sec;
+  else
+    cost_[_item] += TELEMETRY_AVERAGE_WEIGHT * (sec - cost_[_item]);
+}
+
+//////////////////////////////////////////////////
+double TelemetryScheduler::cost(TelemetryItem _item) const
+{
+  // a request and its response are as long as a motion frame,
+  // use that until the item itself was measured
+  if (cost_[_item] > 0.0) return cost_[_item];
+  return motion_cost_;
+}
@@ -0,0 +1,97 @@
+#ifndef AERO_CONTROLLER_TELEMETRY_SCHEDULER_H_
+#define AERO_CONTROLLER_TELEMETRY_SCHEDULER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+
+namespace aero
+{
+  namespace controller
+  {
+    /// @brief telemetry requests polled in idle bus time
+    enum TelemetryItem
+    {
+      TELEMETRY_CURRENT = 0,      // CMD_GET_CUR
+      TELEMETRY_TEMPERATURE = 1,  // CMD_GET_TMP
+      TELEMETRY_MISSTEP = 2,      // CMD_WATCH_MISSTEP
+      NUM_TELEMETRY = 3
+    };
+
+    /// @brief time budget scheduler of one SEED bus
+    ///
+    /// Each control period starts with the motion frames
+    /// (position read and write), which are recorded as busy time.
+    /// The rest of the period is idle, and next() hands out
+    /// telemetry requests round-robin while their measured cost
+    /// still fits before the next period, so telemetry never delays
+    /// a position frame. Each item is requested at most at its rate.
+    class TelemetryScheduler
+    {
+     public: typedef std::chrono::steady_clock clock;
+
+      /// @brief constructor, all items disabled
+      /// @param _period control period [sec]
+      /// @param _margin idle time kept free at the end of period [sec]
+     public: explicit TelemetryScheduler(double _period, double _margin=0.0);
+
+      /// @brief set request rate of an item
+      /// @param _item telemetry item
+      /// @param _rate [Hz], 0 disables the item
+     public: void set_rate(TelemetryItem _item, double _rate);
+
+      /// @brief mark start of a control period
+      /// @param _now start time
+     public: void begin_cycle(clock::time_point _now);
+
+      /// @brief account bus time used by motion frames
+      /// @param _busy time the bus was occupied
+     public: void record(clock::duration _busy);
+
+      /// @brief next telemetry request fitting in the idle time
+      /// @param _now current time
+      /// @param _item output item
+      /// @return false if nothing is due or nothing fits
+     public: bool next(clock::time_point _now, TelemetryItem& _item);
+
+      /// @brief report a finished telemetry request
+      /// @param _item requested item
+      /// @param _busy time the request occupied the bus
+     public: void done(TelemetryItem _item, clock::duration _busy);
+
+      /// @brief ratio of bus busy time in the control period,
+      ///   averaged over recent periods
+     public: double utilization() const {return utilization_;}
+
+      /// @brief estimated bus time of an item [sec]
+     public: double cost(TelemetryItem _item) const;
+
+     private: clock::duration period_;
+
+     private: clock::duration margin_;
+
+     private: clock::duration interval_[NUM_TELEMETRY];
+
+     private: clock::time_point last_request_[NUM_TELEMETRY];
+
+      /// @brief averaged bus time of each item, zero if never measured
+     private: double cost_[NUM_TELEMETRY];
+
+      /// @brief averaged bus time of one motion frame
+     private: double motion_cost_;
+
+     private: clock::time_point cycle_start_;
+
+     private: clock::duration cycle_busy_;
+
+     private: bool cycle_started_;
+
+      /// @brief item to try first in next()
+     private: size_t turn_;
+
+     private: double utilization_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_TELEMETRY_SCHEDULER_H_
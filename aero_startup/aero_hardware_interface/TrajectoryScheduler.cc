@@ -0,0 +1,462 @@
+#include "aero_hardware_interface/TrajectoryScheduler.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace aero;
+using namespace controller;
+
+//////////////////////////////////////////////////
+// calls _f(i) for each stroke i set in _mask, lowest first
+template<typename F> static void for_each_stroke(const StrokeMask& _mask,
+                                                 F _f)
+{
+  static_assert(TRAJECTORY_MAX_STROKES <= 64, "mask must fit a word");
+  for (uint64_t bits = _mask.to_ullong(); bits != 0; bits &= bits - 1)
+    _f(static_cast<size_t>(__builtin_ctzll(bits)));
+}
+
+//////////////////////////////////////////////////
+TrajectoryScheduler::TrajectoryScheduler(size_t _strokes,
+                                         uint16_t _csec_per_frame,
+                                         uint16_t _overlap_csec,
+                                         SendFunction _send,
+                                         AbortFunction _abort,
+                                         TrajectoryClockPtr _clock) :
+  strokes_(std::min(_strokes, TRAJECTORY_MAX_STROKES)),
+  csec_per_frame_(_csec_per_frame),
+  overlap_csec_(_overlap_csec),
+  frame_usec_(static_cast<int64_t>(_csec_per_frame) * 10000),
+  send_(_send), abort_(_abort),
+  timeout_usec_(0), statistics_({0, 0, 0.0, 0.0}),
+  preemption_({0, 0, 0, 0.0, 0.0}), submit_pending_(false), blend_usec_(0),
+  pending_rate_(-1.0), rate_(1.0), clock_(_clock), last_(now_()), next_(last_),
+  frame_strokes_(_strokes), wake_(false), sending_(false), sent_frames_(0),
+  stop_(false)
+{
+  // stepped by the owner of the clock
+  if (!clock_)
+    thread_ = std::thread([this]() { loop_(); });
+}
+
+//////////////////////////////////////////////////
+TrajectoryScheduler::~TrajectoryScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    tracks_.clear();
+    stop_ = true;
+  }
+  cond_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::submit(
+    const interpolation::StrokeTimeline& _points,
+    const std::vector<interpolation::InterpolationPtr>& _interpolation)
+{
+  if (_points.size() < 2 || _points.number_of_strokes() < strokes_)
+    return;
+
+  TrajectoryTrack track = track_(_points);
+  track.interpolation = _interpolation;
+
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    clock::time_point now = now_();
+    advance_(now);
+    // paused tracks stay paused with the new one
+    track.rate = rate_;
+    ++preemption_.submits;
+    if (take_(track)) ++preemption_.preemptions;
+    tracks_.push_back(std::move(track));
+    submitted_ = now;
+    submit_pending_ = true;
+    wake_ = true;
+  }
+  cond_.notify_all();
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::append(const interpolation::StrokeTimeline& _points,
+                                 int64_t _lookahead_usec,
+                                 int64_t _timeout_usec)
+{
+  if (_points.size() < 2 || _points.number_of_strokes() < strokes_)
+    return;
+
+  TrajectoryTrack track = track_(_points);
+  track.stream = true;
+  std::vector<int16_t> strokes(_points.number_of_strokes());
+
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    clock::time_point now = now_();
+    advance_(now);
+    timeout_usec_ = _timeout_usec;
+    ++statistics_.appends;
+
+    auto it = tracks_.begin();
+    for (; it != tracks_.end(); ++it)
+      if (it->stream && it->joints == track.joints) break;
+
+    if (it == tracks_.end()) {
+      // new stream, starts from the first point
+      for (size_t k = 1; k < track.points.size(); ++k)
+        track.points.set_time(k, track.points.time(k) + _lookahead_usec);
+      track.mark = track.points.time(1);
+      track.marked = now;
+      track.rate = rate_;
+      take_(track);
+      tracks_.push_back(std::move(track));
+      wake_ = true;
+    } else {
+      interpolation::StrokeTimeline& points = it->points;
+      if (it->done && it->time >= points.duration()) {
+        // ran out of points, continue from the last point at once
+        ++statistics_.underruns;
+        it->time = points.duration();
+        wake_ = true;
+      }
+      it->done = false;
+
+      // where the track is now, the new points start from here
+      strokes.assign(strokes.size(), 0x7fff);
+      sample_(*it, it->time, strokes);
+
+      // drop points already passed
+      size_t passed = it->segment - 1;
+      points.erase_front(passed);
+      it->segment -= passed;
+
+      // replace points not sent yet by the current position
+      // and the new points
+      int64_t current = std::llround(it->time);
+      int64_t base = current + _lookahead_usec;
+      points.resize(it->segment);
+      points.push_back(strokes, current);
+      for (size_t k = 1; k < _points.size(); ++k) {
+        _points.point(k, strokes.data());
+        points.push_back(strokes, base + _points.time(k));
+      }
+      it->mark = points.time(it->segment + 1);
+      it->marked = now;
+    }
+  }
+  cond_.notify_all();
+}
+
+//////////////////////////////////////////////////
+StreamStatistics TrajectoryScheduler::stream_statistics() const
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  return statistics_;
+}
+
+//////////////////////////////////////////////////
+PreemptionStatistics TrajectoryScheduler::preemption_statistics() const
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  return preemption_;
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::clear()
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  tracks_.clear();
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::set_rate(double _rate)
+{
+  {
+    std::unique_lock<std::mutex> lock(mtx_);
+    pending_rate_.store(std::max(0.0, _rate));
+    wake_.store(true);
+    // a frame composed at the old rate may be on its way to the bus,
+    // frames composed from here on apply the new rate
+    if (sending_) {
+      uint64_t frame = sent_frames_;
+      sent_.wait(lock, [this, frame]() { return sent_frames_ != frame; });
+    }
+  }
+  cond_.notify_all();
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::set_blend(int64_t _usec)
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  blend_usec_ = _usec;
+}
+
+//////////////////////////////////////////////////
+bool TrajectoryScheduler::paused() const
+{
+  double rate = pending_rate_.load();
+  if (rate >= 0.0) return (rate <= 0.0 && active());
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  for (auto it = tracks_.begin(); it != tracks_.end(); ++it)
+    if (it->rate <= 0.0) return true;
+  return false;
+}
+
+//////////////////////////////////////////////////
+bool TrajectoryScheduler::active() const
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  return !tracks_.empty();
+}
+
+//////////////////////////////////////////////////
+size_t TrajectoryScheduler::number_of_tracks() const
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  return tracks_.size();
+}
+
+//////////////////////////////////////////////////
+TrajectoryTrack TrajectoryScheduler::track_(
+    const interpolation::StrokeTimeline& _points) const
+{
+  TrajectoryTrack track;
+  track.points = _points;
+  for (size_t i = 0; i < strokes_; ++i)
+    track.joints[i] = (_points.stroke(0, i) != 0x7fff);
+  track.time = 0.0;
+  track.rate = 1.0;
+  track.segment = 1;
+  track.done = false;
+  track.stream = false;
+  track.mark = -1.0;
+  track.blend_usec = 0.0;
+  return track;
+}
+
+//////////////////////////////////////////////////
+bool TrajectoryScheduler::take_(TrajectoryTrack& _track)
+{
+  bool took = false;
+  // within the track, so it ends where its points do
+  _track.blend_usec = static_cast<double>(
+      std::min(blend_usec_, _track.points.duration()));
+  for (auto it = tracks_.begin(); it != tracks_.end(); ) {
+    StrokeMask taken = _track.joints & it->joints;
+    if (taken.none()) {
+      ++it;
+      continue;
+    }
+    took = true;
+    it->joints &= ~_track.joints;
+    // the preempted part keeps running until blended out
+    if (blend_usec_ > 0 && !it->done) {
+      TrajectoryTrackPtr from(new TrajectoryTrack(*it));
+      from->joints = taken;
+      from->blend.clear();
+      _track.blend.push_back(from);
+    }
+    if (it->joints.any())
+      ++it;
+    else
+      it = tracks_.erase(it);
+  }
+  return took;
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::advance_(clock::time_point _now)
+{
+  double usec = std::chrono::duration<double, std::micro>(_now - last_).count();
+  last_ = _now;
+  for (auto it = tracks_.begin(); it != tracks_.end(); ++it) {
+    it->time += usec * it->rate;
+    for (auto b = it->blend.begin(); b != it->blend.end(); ++b)
+      (*b)->time += usec * (*b)->rate;
+    if (it->mark >= 0.0 && it->time >= it->mark) {
+      double ms = std::chrono::duration<double, std::milli>(
+          _now - it->marked).count();
+      statistics_.latency_ms = ms;
+      statistics_.max_latency_ms = std::max(statistics_.max_latency_ms, ms);
+      it->mark = -1.0;
+    }
+  }
+
+  // rate changes from here on
+  double rate = pending_rate_.exchange(-1.0);
+  if (rate < 0.0) return;
+  rate_ = rate;
+  for (auto it = tracks_.begin(); it != tracks_.end(); ++it) {
+    it->rate = rate;
+    for (auto b = it->blend.begin(); b != it->blend.end(); ++b)
+      (*b)->rate = rate;
+  }
+}
+
+//////////////////////////////////////////////////
+bool TrajectoryScheduler::compose_(std::vector<int16_t>& _frame)
+{
+  _frame.assign(strokes_, 0x7fff);
+  bool send = false;
+  for (auto it = tracks_.begin(); it != tracks_.end(); ) {
+    double end = static_cast<double>(it->points.duration());
+    // last point was sent a frame ago or more,
+    // streams hold the last point until timeout
+    if (it->done && it->time >= end + (it->stream ? timeout_usec_ : 0)) {
+      it = tracks_.erase(it);
+      continue;
+    }
+    if (!it->done && it->rate > 0.0) {
+      double time = std::min(it->time + frame_usec_ * it->rate, end);
+      if (time >= it->blend_usec)
+        it->blend.clear();
+      if (it->blend.empty()) {
+        sample_(*it, time, _frame);
+      } else {
+        // from the preempted tracks to this track over the blend window
+        blend_to_.assign(strokes_, 0x7fff);
+        blend_from_.assign(strokes_, 0x7fff);
+        sample_(*it, time, blend_to_);
+        for (auto b = it->blend.begin(); b != it->blend.end(); ++b) {
+          TrajectoryTrack& from = **b;
+          double from_end = static_cast<double>(from.points.duration());
+          sample_(from, std::min(from.time + frame_usec_ * from.rate,
+                                 from_end), blend_from_);
+        }
+        float w = static_cast<float>(time / it->blend_usec);
+        for_each_stroke(it->joints, [&](size_t i) {
+            if (blend_to_[i] == 0x7fff) return;
+            if (blend_from_[i] == 0x7fff)
+              _frame[i] = blend_to_[i];
+            else
+              _frame[i] = static_cast<int16_t>(
+                  (1 - w) * blend_from_[i] + w * blend_to_[i]);
+          });
+      }
+      it->done = (time >= end);
+      send = true;
+    }
+    ++it;
+  }
+  return send;
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::sample_(TrajectoryTrack& _track, double _time,
+                                  std::vector<int16_t>& _frame) const
+{
+  const interpolation::StrokeTimeline& points = _track.points;
+  while (_track.segment + 1 < points.size() &&
+         points.time(_track.segment) < _time)
+    ++_track.segment;
+  size_t k = _track.segment;
+
+  double duration = static_cast<double>(points.time(k) - points.time(k - 1));
+  float s = 1.0f;
+  if (duration > 0)
+    s = static_cast<float>(
+        std::min(std::max((_time - points.time(k - 1)) / duration, 0.0),
+                 1.0));
+
+  // segments shorter than a frame are not interpolated (linear)
+  float t = s;
+  if (s < 1.0f && duration >= frame_usec_ &&
+      k < _track.interpolation.size() && _track.interpolation[k] &&
+      !_track.interpolation[k]->is(interpolation::i_constant))
+    t = _track.interpolation[k]->interpolate(s);
+
+  // only strokes owned by the track, however many the frame has
+  for_each_stroke(_track.joints, [&](size_t i) {
+      int16_t from = points.stroke(k - 1, i);
+      int16_t to = points.stroke(k, i);
+      if (to == 0x7fff) return; // skip non-send
+      if (from == 0x7fff)
+        _frame[i] = to;
+      else
+        _frame[i] = static_cast<int16_t>((1 - t) * from + t * to);
+    });
+}
+
+//////////////////////////////////////////////////
+bool TrajectoryScheduler::step()
+{
+  std::unique_lock<std::mutex> lock(mtx_);
+  clock::time_point now = now_();
+  if (!wake_.exchange(false) && (tracks_.empty() || now < next_))
+    return false;
+  frame_(lock, now);
+  return true;
+}
+
+//////////////////////////////////////////////////
+TrajectoryScheduler::clock::time_point TrajectoryScheduler::next_frame() const
+{
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (wake_)
+    return now_();
+  if (tracks_.empty())
+    return clock::time_point::max();
+  return next_;
+}
+
+//////////////////////////////////////////////////
+TrajectoryScheduler::clock::time_point TrajectoryScheduler::now_() const
+{
+  return clock_ ? clock_->now() : clock::now();
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::frame_(std::unique_lock<std::mutex>& _lock,
+                                 clock::time_point _now)
+{
+  advance_(_now);
+  bool send = compose_(frame_strokes_);
+  next_ = _now + std::chrono::milliseconds(csec_per_frame_ * 10);
+  if (!send) return;
+
+  // frame of the latest submit
+  bool measure = submit_pending_;
+  clock::time_point submitted = submitted_;
+  submit_pending_ = false;
+
+  // the bus is not accessed under the lock, tracks may be submitted
+  // and are sent as soon as this frame is
+  sending_ = true;
+  _lock.unlock();
+  bool abort = abort_ && abort_();
+  if (!abort) send_(frame_strokes_, csec_per_frame_ + overlap_csec_);
+  clock::time_point sent = now_();
+  _lock.lock();
+  sending_ = false;
+  ++sent_frames_;
+  sent_.notify_all();
+  if (abort) tracks_.clear();
+
+  if (measure && !abort) {
+    double ms =
+      std::chrono::duration<double, std::milli>(sent - submitted).count();
+    ++preemption_.measured;
+    preemption_.latency_ms = ms;
+    preemption_.max_latency_ms = std::max(preemption_.max_latency_ms, ms);
+  }
+}
+
+//////////////////////////////////////////////////
+void TrajectoryScheduler::loop_()
+{
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (true) {
+    if (tracks_.empty())
+      cond_.wait(lock, [this]() { return stop_ || wake_.load(); });
+    else
+      cond_.wait_until(lock, next_,
+                       [this]() { return stop_ || wake_.load(); });
+    if (stop_) break;
+
+    clock::time_point now = now_();
+    if (!wake_.exchange(false) && now < next_) continue;
+    frame_(lock, now);
+  }
+}
@@ -0,0 +1,340 @@
+#ifndef AERO_CONTROLLER_TRAJECTORY_SCHEDULER_H_
+#define AERO_CONTROLLER_TRAJECTORY_SCHEDULER_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <list>
+#include <bitset>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include "aero_hardware_interface/Interpolation.hh"
+#include "aero_hardware_interface/StrokeTimeline.hh"
+
+namespace aero
+{
+  namespace controller
+  {
+    /// @brief most strokes of a TrajectoryScheduler
+    const static size_t TRAJECTORY_MAX_STROKES = 64;
+
+    /// @brief strokes owned by a track, bit i for stroke i
+    typedef std::bitset<TRAJECTORY_MAX_STROKES> StrokeMask;
+
+    struct TrajectoryTrack;
+
+    typedef std::shared_ptr<TrajectoryTrack> TrajectoryTrackPtr;
+
+    /// @brief one trajectory of TrajectoryScheduler,
+    ///   moves the strokes it owns along its points
+    struct TrajectoryTrack
+    {
+      /// @brief strokes and time [usec] of points,
+      ///   the first point is where the track starts from
+      interpolation::StrokeTimeline points;
+
+      /// @brief curve of each segment (ending at point k), linear if missing
+      std::vector<interpolation::InterpolationPtr> interpolation;
+
+      /// @brief strokes owned by the track
+      StrokeMask joints;
+
+      /// @brief phase, time along points [usec]
+      double time;
+
+      /// @brief speed of phase, 1.0 as in the points, 0.0 paused
+      double rate;
+
+      /// @brief segment of time, ends at points[segment]
+      size_t segment;
+
+      /// @brief true once the last point was sent
+      bool done;
+
+      /// @brief true if points are appended (TrajectoryScheduler::append)
+      bool stream;
+
+      /// @brief phase of the first point of the latest append,
+      ///   negative once reached
+      double mark;
+
+      /// @brief when the latest append arrived
+      std::chrono::steady_clock::time_point marked;
+
+      /// @brief tracks this track took strokes from, owning the strokes
+      ///   taken, blended into this track until time reaches blend_usec
+      std::vector<TrajectoryTrackPtr> blend;
+
+      /// @brief blend window from the start of the track [usec]
+      double blend_usec;
+    };
+
+    /// @brief latency and underruns of appended points
+    struct StreamStatistics
+    {
+      /// @brief number of append calls
+      size_t appends;
+
+      /// @brief number of appends arriving after their track ran out
+      size_t underruns;
+
+      /// @brief time from the latest append until its first point
+      ///   was reached [ms]
+      double latency_ms;
+
+      /// @brief maximum of latency_ms
+      double max_latency_ms;
+    };
+
+    /// @brief time source of TrajectoryScheduler
+    class TrajectoryClock
+    {
+     public: typedef std::chrono::steady_clock::time_point time_point;
+
+     public: virtual ~TrajectoryClock() {};
+
+     public: virtual time_point now() const = 0;
+    };
+
+    typedef std::shared_ptr<TrajectoryClock> TrajectoryClockPtr;
+
+    /// @brief clock moved by hand, to run a scheduler offline
+    ///   (faster than real time)
+    class ManualTrajectoryClock : public TrajectoryClock
+    {
+     public: ManualTrajectoryClock() : now_() {};
+
+     public: virtual time_point now() const { return now_; };
+
+     public: void set(time_point _now) { now_ = _now; };
+
+      /// @param _usec time to move forward [usec]
+     public: void advance(int64_t _usec)
+      { now_ += std::chrono::microseconds(_usec); };
+
+     private: time_point now_;
+    };
+
+    /// @brief latency of submitted trajectories
+    struct PreemptionStatistics
+    {
+      /// @brief number of submit calls
+      size_t submits;
+
+      /// @brief number of submits taking strokes from running tracks
+      size_t preemptions;
+
+      /// @brief number of submits whose latency was measured
+      size_t measured;
+
+      /// @brief time from the latest submit until its first frame
+      ///   was sent to the bus [ms]
+      double latency_ms;
+
+      /// @brief maximum of latency_ms
+      double max_latency_ms;
+    };
+
+    /// @brief sends the trajectories of one SEED bus from a single thread
+    ///
+    /// Trajectories are tracks owning a set of strokes.
+    /// Every frame the scheduler advances all tracks by the elapsed time
+    /// (times their rate), merges the position of each track one frame ahead
+    /// into one stroke vector (0x7fff for strokes no track owns),
+    /// and sends it once. A new track takes its strokes from running tracks
+    /// at once, tracks left without strokes are dropped.
+    class TrajectoryScheduler
+    {
+     public: typedef std::chrono::steady_clock clock;
+
+      /// @brief sends one frame, strokes and time to reach them [csec]
+     public: typedef std::function<void(const std::vector<int16_t>&, uint16_t)>
+      SendFunction;
+
+      /// @brief true to abort all tracks (e.g. collision)
+     public: typedef std::function<bool()> AbortFunction;
+
+      /// @brief constructor, starts scheduler thread
+      /// @param _strokes strokes of a frame,
+      ///   at most TRAJECTORY_MAX_STROKES are sent
+      /// @param _csec_per_frame period of frames [csec]
+      /// @param _overlap_csec added to the time of each frame, so the next
+      ///   frame arrives before a stroke stops
+      /// @param _send sends a frame to the bus, called from scheduler thread
+      /// @param _abort checked before each frame, nullptr to never abort
+      /// @param _clock time source, nullptr for steady_clock and a scheduler
+      ///   thread; with a clock no thread is started, frames are sent
+      ///   by step()
+     public: TrajectoryScheduler(size_t _strokes, uint16_t _csec_per_frame,
+                                 uint16_t _overlap_csec, SendFunction _send,
+                                 AbortFunction _abort=nullptr,
+                                 TrajectoryClockPtr _clock=nullptr);
+
+      /// @brief destructor, drops tracks and joins scheduler thread
+     public: ~TrajectoryScheduler();
+
+      /// @brief add a trajectory, sent from the next frame on
+      /// @param _points strokes and time [usec] of points, strokes which are
+      ///   not 0x7fff at the first point are owned by the track
+      /// @param _interpolation curve of each segment, linear if empty
+     public: void submit(
+         const interpolation::StrokeTimeline& _points,
+         const std::vector<interpolation::InterpolationPtr>& _interpolation);
+
+      /// @brief append points to the stream track owning the same strokes,
+      ///   or start one (as submit) if there is none
+      ///
+      /// Points after the first are played _lookahead_usec after now,
+      /// their time relative to now. Points of the track not reached yet
+      /// are replaced. A track running out of points holds its last point,
+      /// and is dropped if nothing is appended for _timeout_usec.
+      /// @param _points as submit, the first point is used only
+      ///   to start a new track
+      /// @param _lookahead_usec delay of points to absorb jitter [usec]
+      /// @param _timeout_usec time to hold the last point [usec]
+     public: void append(const interpolation::StrokeTimeline& _points,
+                         int64_t _lookahead_usec, int64_t _timeout_usec);
+
+     public: StreamStatistics stream_statistics() const;
+
+     public: PreemptionStatistics preemption_statistics() const;
+
+      /// @brief drop all tracks, strokes stay where they were sent
+     public: void clear();
+
+      /// @brief speed of running tracks, 1.0 as in the points, 0.0 pauses
+      ///   (nothing is sent for paused tracks), also of tracks submitted
+      ///   or appended later, applied by the scheduler
+      ///   thread once woken; returns once a frame composed at the old rate
+      ///   was sent, so bus commands issued after it follow that frame
+     public: void set_rate(double _rate);
+
+      /// @brief blend window of new tracks taking strokes from running
+      ///   tracks, 0 to switch at once (default)
+      /// @param _usec time from the preempted to the new track [usec]
+     public: void set_blend(int64_t _usec);
+
+      /// @brief true if any track is paused
+     public: bool paused() const;
+
+      /// @brief true if any track is running
+     public: bool active() const;
+
+     public: size_t number_of_tracks() const;
+
+      /// @brief send a frame if one is due at the time of the clock,
+      ///   for schedulers with a clock (no scheduler thread)
+      /// @return true if a frame was due
+     public: bool step();
+
+      /// @brief time the next frame is due, time_point::max() if idle
+     public: clock::time_point next_frame() const;
+
+      /// @brief advance tracks to _now, then apply pending_rate_
+     private: void advance_(clock::time_point _now);
+
+      /// @brief new track of _points, starting from now
+     private: TrajectoryTrack track_(
+         const interpolation::StrokeTimeline& _points) const;
+
+      /// @brief remove strokes of _track from other tracks,
+      ///   drops tracks left without strokes,
+      ///   keeps what was taken in _track.blend if blending
+      /// @return true if strokes were taken
+     private: bool take_(TrajectoryTrack& _track);
+
+      /// @brief merge positions of tracks one frame ahead into _frame,
+      ///   drops finished tracks
+      /// @return false if there is nothing to send
+     private: bool compose_(std::vector<int16_t>& _frame);
+
+      /// @brief position of a track at time _time into _frame
+     private: void sample_(TrajectoryTrack& _track, double _time,
+                           std::vector<int16_t>& _frame) const;
+
+     private: clock::time_point now_() const;
+
+      /// @brief advance, compose and send a frame, unlocks while sending
+     private: void frame_(std::unique_lock<std::mutex>& _lock,
+                          clock::time_point _now);
+
+     private: void loop_();
+
+     private: size_t strokes_;
+
+     private: uint16_t csec_per_frame_;
+
+     private: uint16_t overlap_csec_;
+
+      /// @brief period of frames [usec]
+     private: int64_t frame_usec_;
+
+     private: SendFunction send_;
+
+     private: AbortFunction abort_;
+
+      /// @brief time to hold the last point of stream tracks [usec]
+     private: int64_t timeout_usec_;
+
+     private: StreamStatistics statistics_;
+
+     private: PreemptionStatistics preemption_;
+
+      /// @brief time of the latest submit not sent yet
+     private: clock::time_point submitted_;
+
+     private: bool submit_pending_;
+
+     private: int64_t blend_usec_;
+
+      /// @brief positions of a blended track and the tracks it took from
+     private: std::vector<int16_t> blend_to_, blend_from_;
+
+     private: std::list<TrajectoryTrack> tracks_;
+
+      /// @brief rate set by set_rate not applied to tracks yet, negative if none
+     private: std::atomic<double> pending_rate_;
+
+      /// @brief rate applied to tracks, new tracks start at it
+     private: double rate_;
+
+     private: TrajectoryClockPtr clock_;
+
+      /// @brief time tracks were advanced to
+     private: clock::time_point last_;
+
+      /// @brief time the next frame is due
+     private: clock::time_point next_;
+
+     private: std::vector<int16_t> frame_strokes_;
+
+     private: mutable std::mutex mtx_;
+
+     private: std::condition_variable cond_;
+
+      /// @brief true to send a frame now (new track or rate)
+     private: std::atomic<bool> wake_;
+
+      /// @brief true while a frame is sent (unlocked)
+     private: bool sending_;
+
+      /// @brief number of frames sent, counted once send returns
+     private: uint64_t sent_frames_;
+
+      /// @brief notified when a frame was sent
+     private: std::condition_variable sent_;
+
+     private: bool stop_;
+
+     private: std::thread thread_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_TRAJECTORY_SCHEDULER_H_
@@ -0,0 +1,269 @@
+#include "aero_hardware_interface/TrajectorySimulator.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <time.h>
+
+using namespace aero;
+using namespace controller;
+
+//////////////////////////////////////////////////
+// CPU time of the calling thread [usec]
+static double thread_cpu_usec()
+{
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+//////////////////////////////////////////////////
+// stroke _i of _points at _usec, along the curves as in
+// TrajectoryScheduler (segments shorter than _frame_usec linear),
+// false if either end of the segment is no-send
+static bool sample(const interpolation::StrokeTimeline& _points,
+                   const std::vector<interpolation::InterpolationPtr>&
+                   _interpolation, size_t _i, double _usec,
+                   int64_t _frame_usec, double& _stroke)
+{
+  size_t k = 1;
+  while (k < _points.size() - 1 && _points.time(k) < _usec) ++k;
+  int16_t from = _points.stroke(k - 1, _i);
+  int16_t to = _points.stroke(k, _i);
+  if (from == 0x7fff || to == 0x7fff) return false;
+
+  double span = static_cast<double>(_points.time(k) - _points.time(k - 1));
+  double t = (span > 0.0 ? (_usec - _points.time(k - 1)) / span : 1.0);
+  t = std::max(0.0, std::min(1.0, t));
+  if (t < 1.0 && span >= _frame_usec && k < _interpolation.size() &&
+      _interpolation[k] &&
+      !_interpolation[k]->is(interpolation::i_constant))
+    t = _interpolation[k]->interpolate(static_cast<float>(t));
+  _stroke = from + (to - from) * t;
+  return true;
+}
+
+//////////////////////////////////////////////////
+TrajectorySimulator::TrajectorySimulator(const std::vector<int16_t>& _initial,
+                                         uint16_t _csec_per_frame,
+                                         uint16_t _overlap_csec) :
+  initial_(_initial), csec_per_frame_(_csec_per_frame),
+  overlap_csec_(_overlap_csec), blend_usec_(0),
+  lookahead_usec_(0), timeout_usec_(0), cpu_usec_(0.0),
+  record_usec_(0.0)
+{
+}
+
+//////////////////////////////////////////////////
+void TrajectorySimulator::set_blend(int64_t _usec)
+{
+  blend_usec_ = _usec;
+}
+
+//////////////////////////////////////////////////
+void TrajectorySimulator::set_stream(int64_t _lookahead_usec,
+                                     int64_t _timeout_usec)
+{
+  lookahead_usec_ = _lookahead_usec;
+  timeout_usec_ = _timeout_usec;
+}
+
+//////////////////////////////////////////////////
+void TrajectorySimulator::add(const SimulatedTrajectory& _trajectory)
+{
+  trajectories_.push_back(_trajectory);
+}
+
+//////////////////////////////////////////////////
+size_t TrajectorySimulator::size() const
+{
+  return trajectories_.size();
+}
+
+//////////////////////////////////////////////////
+void TrajectorySimulator::run()
+{
+  size_t n = trajectories_.size();
+  frames_.clear();
+  reports_.assign(n, {0, -1, 0.0, 0.0, 0.0, 0.0, 0.0});
+  expected_.assign(n, interpolation::StrokeTimeline());
+  error_sum_.assign(n, 0.0);
+  jitter_sum_.assign(n, 0.0);
+  errors_.assign(n, 0);
+  sent_usec_.assign(n, -1);
+  owner_.assign(initial_.size(), -1);
+  reference_ = initial_;
+  cpu_usec_ = 0.0;
+
+  clock_ = std::make_shared<ManualTrajectoryClock>();
+  scheduler_.reset(new TrajectoryScheduler(
+      initial_.size(), csec_per_frame_, overlap_csec_,
+      [this](const std::vector<int16_t>& _strokes, uint16_t _csec) {
+        send_(_strokes, _csec);
+      }, nullptr, clock_));
+  scheduler_->set_blend(blend_usec_);
+
+  std::vector<size_t> order(n);
+  for (size_t k = 0; k < n; ++k) order[k] = k;
+  std::stable_sort(order.begin(), order.end(), [this](size_t _a, size_t _b) {
+      return trajectories_[_a].arrival_usec < trajectories_[_b].arrival_usec;
+    });
+
+  const int64_t idle = std::numeric_limits<int64_t>::max();
+  size_t next = 0;
+  while (true) {
+    TrajectoryScheduler::clock::time_point frame = scheduler_->next_frame();
+    int64_t frame_usec = idle;
+    if (frame != TrajectoryScheduler::clock::time_point::max())
+      frame_usec = std::chrono::duration_cast<std::chrono::microseconds>(
+          frame.time_since_epoch()).count();
+    int64_t arrival_usec =
+      (next < n ? trajectories_[order[next]].arrival_usec : idle);
+    if (frame_usec == idle && arrival_usec == idle) break;
+
+    // arrivals go first, as a submit wakes the scheduler before its frame
+    if (arrival_usec <= frame_usec) {
+      clock_->set(TrajectoryClock::time_point(
+          std::chrono::microseconds(std::max(arrival_usec, now_()))));
+      deliver_(order[next++]);
+      continue;
+    }
+
+    clock_->set(frame);
+    senders_.clear();
+    record_usec_ = 0.0;
+    double start = thread_cpu_usec();
+    scheduler_->step();
+    double cpu = thread_cpu_usec() - start - record_usec_;
+    cpu_usec_ += cpu;
+    for (int k : senders_)
+      reports_[k].cpu_usec += cpu / senders_.size();
+  }
+  scheduler_.reset();
+
+  for (size_t k = 0; k < n; ++k) {
+    SimulatedTrajectoryReport& r = reports_[k];
+    if (errors_[k] > 0) r.rms_error = std::sqrt(error_sum_[k] / errors_[k]);
+    if (r.frames > 1)
+      r.rms_jitter_usec = std::sqrt(jitter_sum_[k] / (r.frames - 1));
+  }
+}
+
+//////////////////////////////////////////////////
+const std::vector<SimulatedFrame>& TrajectorySimulator::frames() const
+{
+  return frames_;
+}
+
+//////////////////////////////////////////////////
+const std::vector<SimulatedTrajectoryReport>&
+TrajectorySimulator::reports() const
+{
+  return reports_;
+}
+
+//////////////////////////////////////////////////
+double TrajectorySimulator::cpu_usec() const
+{
+  return cpu_usec_;
+}
+
+//////////////////////////////////////////////////
+int64_t TrajectorySimulator::duration() const
+{
+  return frames_.empty() ? 0 : frames_.back().usec;
+}
+
+//////////////////////////////////////////////////
+void TrajectorySimulator::deliver_(size_t _k)
+{
+  const SimulatedTrajectory& trajectory = trajectories_[_k];
+  if (trajectory.points.size() < 2 ||
+      trajectory.points.number_of_strokes() < initial_.size())
+    return;
+
+  // starts from the strokes sent last, as from the reference
+  interpolation::StrokeTimeline points = trajectory.points;
+  for (size_t i = 0; i < initial_.size(); ++i)
+    if (points.stroke(0, i) != 0x7fff)
+      points.stroke(0, i) = reference_[i];
+
+  interpolation::StrokeTimeline& expected = expected_[_k];
+  expected = points;
+  if (trajectory.stream)
+    for (size_t p = 1; p < expected.size(); ++p)
+      expected.set_time(p, expected.time(p) + lookahead_usec_);
+
+  double start = thread_cpu_usec();
+  if (trajectory.stream)
+    scheduler_->append(points, lookahead_usec_, timeout_usec_);
+  else
+    scheduler_->submit(points, trajectory.interpolation);
+  double cpu = thread_cpu_usec() - start;
+  cpu_usec_ += cpu;
+  reports_[_k].cpu_usec += cpu;
+
+  for (size_t i = 0; i < initial_.size(); ++i)
+    if (points.stroke(0, i) != 0x7fff)
+      owner_[i] = static_cast<int>(_k);
+}
+
+//////////////////////////////////////////////////
+void TrajectorySimulator::send_(const std::vector<int16_t>& _strokes,
+                                uint16_t _csec)
+{
+  // recording is not part of the cost of the frame
+  double start = thread_cpu_usec();
+
+  int64_t now = now_();
+  frames_.push_back({now, _csec, _strokes});
+
+  // strokes are reached one frame after sending
+  int64_t period = static_cast<int64_t>(csec_per_frame_) * 10000;
+  int64_t reached = now + period;
+  static const std::vector<interpolation::InterpolationPtr> no_interpolation;
+  for (size_t i = 0; i < _strokes.size() && i < reference_.size(); ++i) {
+    if (_strokes[i] == 0x7fff) continue;
+    reference_[i] = _strokes[i];
+
+    int k = owner_[i];
+    if (k < 0) continue;
+    if (std::find(senders_.begin(), senders_.end(), k) == senders_.end())
+      senders_.push_back(k);
+
+    double expected;
+    const SimulatedTrajectory& trajectory = trajectories_[k];
+    if (!sample(expected_[k],
+                trajectory.stream ? no_interpolation : trajectory.interpolation,
+                i, static_cast<double>(reached - trajectory.arrival_usec),
+                period, expected))
+      continue;
+    double error = std::fabs(_strokes[i] - expected);
+    SimulatedTrajectoryReport& r = reports_[k];
+    r.max_error = std::max(r.max_error, error);
+    error_sum_[k] += error * error;
+    ++errors_[k];
+  }
+
+  for (int k : senders_) {
+    SimulatedTrajectoryReport& r = reports_[k];
+    ++r.frames;
+    if (r.latency_usec < 0)
+      r.latency_usec = now - trajectories_[k].arrival_usec;
+    if (sent_usec_[k] >= 0) {
+      double jitter = static_cast<double>(now - sent_usec_[k] - period);
+      r.max_jitter_usec = std::max(r.max_jitter_usec, std::fabs(jitter));
+      jitter_sum_[k] += jitter * jitter;
+    }
+    sent_usec_[k] = now;
+  }
+
+  record_usec_ += thread_cpu_usec() - start;
+}
+
+//////////////////////////////////////////////////
+int64_t TrajectorySimulator::now_() const
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      clock_->now().time_since_epoch()).count();
+}
@@ -0,0 +1,180 @@
+#ifndef AERO_CONTROLLER_TRAJECTORY_SIMULATOR_H_
+#define AERO_CONTROLLER_TRAJECTORY_SIMULATOR_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <memory>
+
+#include "aero_hardware_interface/StrokeTimeline.hh"
+#include "aero_hardware_interface/TrajectoryScheduler.hh"
+
+namespace aero
+{
+  namespace controller
+  {
+    /// @brief trajectory replayed by TrajectorySimulator
+    struct SimulatedTrajectory
+    {
+      /// @brief time the trajectory arrives, from the start of the run [usec]
+      int64_t arrival_usec;
+
+      /// @brief true to append as command_stream, false to submit
+      bool stream;
+
+      /// @brief as TrajectoryScheduler::submit, strokes not 0x7fff
+      ///   at the first point are owned, the first point is replaced by
+      ///   the strokes sent last (as the reference of the controller)
+      interpolation::StrokeTimeline points;
+
+      /// @brief curve of each segment as TrajectoryScheduler::submit,
+      ///   linear if empty, not used by streams
+      std::vector<interpolation::InterpolationPtr> interpolation;
+    };
+
+    /// @brief frame which would be sent to the bus
+    struct SimulatedFrame
+    {
+      /// @brief time the frame was sent, from the start of the run [usec]
+      int64_t usec;
+
+      /// @brief time to reach the strokes [csec]
+      uint16_t csec;
+
+      /// @brief 0x7fff for strokes not sent
+      std::vector<int16_t> strokes;
+    };
+
+    /// @brief tracking error, jitter and CPU cost of one trajectory
+    struct SimulatedTrajectoryReport
+    {
+      /// @brief frames sending strokes owned by the trajectory
+      size_t frames;
+
+      /// @brief time from arrival until the first frame [usec],
+      ///   -1 if never sent
+      int64_t latency_usec;
+
+      /// @brief maximum of |frame - points| over owned strokes [stroke],
+      ///   points along their curves at the time the frame is reached
+      double max_error;
+
+      /// @brief root mean square of |frame - points| [stroke]
+      double rms_error;
+
+      /// @brief maximum of |interval - period| between frames [usec],
+      ///   on the manual clock only frames moved by submits and appends
+      ///   (no timing noise of a real thread or bus)
+      double max_jitter_usec;
+
+      /// @brief root mean square of interval - period [usec]
+      double rms_jitter_usec;
+
+      /// @brief CPU time of submit or append and of the frames
+      ///   (shared by the trajectories sent in a frame) [usec]
+      double cpu_usec;
+    };
+
+    /// @brief replays trajectories through a TrajectoryScheduler
+    ///   on a manual clock, faster than real time
+    ///
+    /// The scheduler has no thread, frames are sent by stepping
+    /// the clock to the next frame or arrival, and recorded with their
+    /// time instead of going to a bus. No ROS and no controllers involved.
+    class TrajectorySimulator
+    {
+      /// @param _initial strokes before the first frame, also sets
+      ///   the strokes of a frame
+      /// @param _csec_per_frame as TrajectoryScheduler
+      /// @param _overlap_csec as TrajectoryScheduler
+     public: TrajectorySimulator(const std::vector<int16_t>& _initial,
+                                 uint16_t _csec_per_frame,
+                                 uint16_t _overlap_csec);
+
+      /// @brief as TrajectoryScheduler::set_blend
+     public: void set_blend(int64_t _usec);
+
+      /// @brief lookahead and timeout of appended trajectories [usec],
+      ///   as TrajectoryScheduler::append
+     public: void set_stream(int64_t _lookahead_usec, int64_t _timeout_usec);
+
+      /// @brief add a trajectory, replayed in order of arrival
+     public: void add(const SimulatedTrajectory& _trajectory);
+
+     public: size_t size() const;
+
+      /// @brief replay all trajectories until the scheduler is idle,
+      ///   frames and reports of a previous run are cleared
+     public: void run();
+
+     public: const std::vector<SimulatedFrame>& frames() const;
+
+      /// @brief report of each trajectory, in order of add
+     public: const std::vector<SimulatedTrajectoryReport>& reports() const;
+
+      /// @brief CPU time of the whole run [usec]
+     public: double cpu_usec() const;
+
+      /// @brief time of the last frame [usec]
+     public: int64_t duration() const;
+
+      /// @brief deliver trajectory _k at the time of the clock
+     private: void deliver_(size_t _k);
+
+      /// @brief record a frame and its error, called by the scheduler
+     private: void send_(const std::vector<int16_t>& _strokes, uint16_t _csec);
+
+     private: int64_t now_() const;
+
+     private: std::vector<int16_t> initial_;
+
+     private: uint16_t csec_per_frame_;
+
+     private: uint16_t overlap_csec_;
+
+     private: int64_t blend_usec_;
+
+     private: int64_t lookahead_usec_;
+
+     private: int64_t timeout_usec_;
+
+     private: std::vector<SimulatedTrajectory> trajectories_;
+
+      /// @brief points as expected by each trajectory, time from arrival
+     private: std::vector<interpolation::StrokeTimeline> expected_;
+
+     private: std::vector<SimulatedFrame> frames_;
+
+     private: std::vector<SimulatedTrajectoryReport> reports_;
+
+      /// @brief squared errors and jitters, count of samples
+     private: std::vector<double> error_sum_, jitter_sum_;
+
+     private: std::vector<size_t> errors_;
+
+      /// @brief time of the previous frame of each trajectory, -1 if none
+     private: std::vector<int64_t> sent_usec_;
+
+      /// @brief trajectory owning each stroke, -1 if none
+     private: std::vector<int> owner_;
+
+      /// @brief strokes sent last
+     private: std::vector<int16_t> reference_;
+
+      /// @brief trajectories in the frame being sent
+     private: std::vector<int> senders_;
+
+     private: double cpu_usec_;
+
+      /// @brief CPU time of send_ in the frame being sent,
+      ///   not part of the cost of the frame
+     private: double record_usec_;
+
+     private: std::shared_ptr<ManualTrajectoryClock> clock_;
+
+     private: std::unique_ptr<TrajectoryScheduler> scheduler_;
+    };
+  }
+}
+
+#endif  // AERO_CONTROLLER_TRAJECTORY_SIMULATOR_H_
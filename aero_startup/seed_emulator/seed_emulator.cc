@@ -0,0 +1,71 @@
+/// @brief virtual SEED board for running aero controllers without hardware
+///
+/// usage: seed_emulator [options]
+///   -l PATH   symlink to pty (e.g. /tmp/aero_upper), pass it as port_upper
+///   -L MS     response latency [ms] (default 2.0)
+///   -j MS     latency jitter [ms] (default 0.5)
+///   -d RATE   probability to drop each response byte
+///   -c RATE   probability of bad checksum per response
+///   -m RATE   probability of misstep per joint and watch command
+///   -s SEED   random seed of fault injection
+///   -v        print frames
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+#include "aero_hardware_interface/SeedEmulator.hh"
+
+static aero::controller::SeedEmulator* g_emulator = nullptr;
+
+//////////////////////////////////////////////////
+static void on_signal(int)
+{
+  if (g_emulator) g_emulator->stop();
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  aero::controller::SeedEmulatorConfig config;
+  std::string link;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "l:L:j:d:c:m:s:v")) != -1) {
+    switch (opt) {
+    case 'l': link = optarg; break;
+    case 'L': config.latency_ms = atof(optarg); break;
+    case 'j': config.jitter_ms = atof(optarg); break;
+    case 'd': config.drop_rate = atof(optarg); break;
+    case 'c': config.bad_checksum_rate = atof(optarg); break;
+    case 'm': config.misstep_rate = atof(optarg); break;
+    case 's': config.seed = static_cast<unsigned int>(atoi(optarg)); break;
+    case 'v': config.verbose = true; break;
+    default:
+      std::cerr << "usage: " << argv[0]
+                << " [-l link] [-L latency_ms] [-j jitter_ms]"
+                << " [-d drop_rate] [-c bad_checksum_rate]"
+                << " [-m misstep_rate] [-s seed] [-v]" << std::endl;
+      return 1;
+    }
+  }
+
+  aero::controller::SeedEmulator emulator(config);
+  if (!emulator.open(link)) return 1;
+  std::cout << "seed_emulator: " << emulator.port();
+  if (!link.empty()) std::cout << " (" << link << ")";
+  std::cout << std::endl;
+
+  g_emulator = &emulator;
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+
+  emulator.run();
+
+  std::cout << "seed_emulator: received " << emulator.frames_received()
+            << ", sent " << emulator.frames_sent()
+            << ", dropped bytes " << emulator.dropped_bytes()
+            << ", bad checksums " << emulator.bad_checksums() << std::endl;
+  return 0;
+}
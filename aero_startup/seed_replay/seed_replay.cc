@@ -0,0 +1,138 @@
+/// @brief replay a SEED bus capture offline through AeroControllerProto
+///
+/// usage: seed_replay [options] FILE
+///   -b BUS    upper or lower, joint layout to decode with (default upper)
+///   -n COUNT  repeat decoding COUNT times for profiling (default 1)
+///   -p        print decoded strokes of each response
+///
+/// Received bytes are fed to SeedFrameParser as they came from the port,
+/// and each frame goes through AeroControllerProto::decode_frame,
+/// the same path as get_data on the bus.
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <unistd.h>
+
+#include "aero_hardware_interface/AeroControllers.hh"
+#include "aero_hardware_interface/SeedCapture.hh"
+
+using namespace aero::controller;
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  std::string bus("upper");
+  int repeat = 1;
+  bool print = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "b:n:p")) != -1) {
+    switch (opt) {
+    case 'b': bus = optarg; break;
+    case 'n': repeat = std::max(1, atoi(optarg)); break;
+    case 'p': print = true; break;
+    default:
+      std::cerr << "usage: " << argv[0]
+                << " [-b upper|lower] [-n repeat] [-p] FILE" << std::endl;
+      return 1;
+    }
+  }
+  if (optind >= argc || (bus != "upper" && bus != "lower")) {
+    std::cerr << "usage: " << argv[0]
+              << " [-b upper|lower] [-n repeat] [-p] FILE" << std::endl;
+    return 1;
+  }
+
+  SeedCaptureReader capture;
+  if (!capture.open(argv[optind])) return 1;
+
+  // empty port, controllers run in debug mode without bus
+  std::unique_ptr<AeroControllerProto> controller;
+  if (bus == "upper")
+    controller.reset(new AeroUpperController(""));
+  else
+    controller.reset(new AeroLowerController(""));
+
+  std::vector<int16_t> strokes;
+  strokes.reserve(controller->get_number_of_strokes());
+  size_t sent = 0, received = 0, decoded = 0, answered = 0;
+  size_t skipped = 0, bad_checksums = 0;
+  double latency_sum = 0.0, latency_max = 0.0;
+  std::chrono::steady_clock::duration elapsed(0);
+
+  for (int k = 0; k < repeat; ++k) {
+    SeedFrameParser parser;
+    SeedFrame frame;
+    uint64_t sent_ns = 0;
+    bool waiting = false;
+    bool first = (k == 0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < capture.size(); ++i) {
+      const SeedCaptureRecord& r = capture[i];
+
+      if (r.direction == SEED_CAPTURE_TX) {
+        // same as bus, bytes left cannot answer the next command
+        parser.clear();
+        sent_ns = r.stamp_ns;
+        waiting = true;
+        if (first) ++sent;
+        continue;
+      }
+
+      parser.push(r.data, r.length);
+      while (parser.pop(frame)) {
+        bool has_strokes = controller->decode_frame(frame, strokes);
+        if (!first) continue;
+
+        ++received;
+        if (has_strokes) ++decoded;
+        if (waiting) {
+          double latency = (r.stamp_ns - sent_ns) * 1e-3;
+          latency_sum += latency;
+          latency_max = std::max(latency_max, latency);
+          ++answered;
+          waiting = false;
+        }
+        if (print && has_strokes) {
+          std::cout << std::fixed << std::setprecision(6)
+                    << r.stamp_ns * 1e-9 << " " << std::hex << std::uppercase
+                    << std::setw(2) << std::setfill('0')
+                    << static_cast<int>(frame.cmd()) << std::dec;
+          for (size_t j = 0; j < strokes.size(); ++j)
+            std::cout << " " << strokes[j];
+          std::cout << "\n";
+        }
+      }
+    }
+    elapsed += std::chrono::steady_clock::now() - start;
+
+    if (first) {
+      skipped = parser.skipped_bytes();
+      bad_checksums = parser.bad_checksums();
+    }
+  }
+
+  double elapsed_ns = std::chrono::duration<double, std::nano>(elapsed).count();
+  std::cout << "records: " << capture.size()
+            << ", sent: " << sent
+            << ", received frames: " << received
+            << " (with strokes " << decoded << ")"
+            << ", skipped bytes: " << skipped
+            << ", bad checksums: " << bad_checksums << std::endl;
+  if (answered > 0) {
+    std::cout << "response latency: mean "
+              << latency_sum / answered << " [us], max "
+              << latency_max << " [us]" << std::endl;
+  }
+  if (received > 0) {
+    std::cout << "parse and decode: "
+              << elapsed_ns / (static_cast<double>(received) * repeat)
+              << " [ns/frame]" << std::endl;
+  }
+  return 0;
+}
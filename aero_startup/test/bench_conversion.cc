@@ -0,0 +1,127 @@
+/// @brief microbenchmark of common::Angle2Stroke, Stroke2Angle
+///   and UnusedAngle2Stroke
+///
+/// usage: bench_conversion [iterations]
+///
+/// Converts poses sweeping each joint over its URDF limits
+/// (see joint_sweep.hh) as AeroRobotHW does every control cycle,
+/// and prints ns per call and the Angle2Stroke -> Stroke2Angle
+/// round trip error of the swept joint
+/// (test_conversion_sweep prints it per joint).
+/// With ROS_PACKAGE_PATH unset (no limits), strokes are swept
+/// over +-60 [mm] for Stroke2Angle only.
+
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+
+#include "aero_hardware_interface/Angle2Stroke.hh"
+#include "aero_hardware_interface/Stroke2Angle.hh"
+#include "aero_hardware_interface/UnusedAngle2Stroke.hh"
+#include "joint_sweep.hh"
+
+using namespace aero;
+
+// 0.1 degree
+static const double SWEEP_STEP = 0.001745;
+
+//////////////////////////////////////////////////
+// ns per call of _call(n) over _iterations calls
+static double measure(int _iterations, const std::function<void(int)>& _call)
+{
+  // warm up
+  for (int n = 0; n < std::min(_iterations, 1000); ++n) _call(n);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int n = 0; n < _iterations; ++n) _call(n);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count()
+    / _iterations;
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  int iterations = 1000000;
+  if (argc > 1) iterations = std::max(1, atoi(argv[1]));
+
+  std::vector<std::string> names = test::angle_joint_names();
+  std::string robot_dir = test::generated_robot_dir();
+  std::vector<size_t> joints;
+  std::vector<std::vector<double> > poses;
+  if (!robot_dir.empty())
+    poses = test::sweep_poses(names, test::read_joint_limits(robot_dir),
+                              SWEEP_STEP, joints);
+
+  // strokes of the poses, or a set of stroke vectors covering
+  // negative and positive table sides
+  std::vector<std::vector<int16_t> > strokes;
+  for (size_t k = 0; k < poses.size(); ++k) {
+    strokes.push_back(std::vector<int16_t>(controller::AERO_DOF));
+    common::Angle2Stroke(strokes.back(), poses[k]);
+  }
+  if (strokes.empty()) {
+    std::cout << "no joint limits, sweeping strokes only" << std::endl;
+    for (int k = 0; k < 256; ++k) {
+      strokes.push_back(std::vector<int16_t>(controller::AERO_DOF));
+      for (size_t i = 0; i < controller::AERO_DOF; ++i)
+        strokes[k][i] = static_cast<int16_t>(
+            ((k * 37 + i * 101) % 12001) - 6000);
+    }
+  }
+
+  std::vector<double> angles(names.size());
+  std::vector<int16_t> result(controller::AERO_DOF);
+  double sum = 0.0;
+
+  if (!poses.empty()) {
+    double ns = measure(iterations, [&](int n) {
+        common::Angle2Stroke(result, poses[n % poses.size()]);
+        sum += result[n % result.size()];
+      });
+    std::cout << "Angle2Stroke: " << ns << " [ns/call]" << std::endl;
+
+    // one joint not sent per call
+    std::vector<std::vector<bool> > sends(
+        names.size(), std::vector<bool>(names.size(), true));
+    for (size_t j = 0; j < names.size(); ++j) sends[j][j] = false;
+    ns = measure(iterations, [&](int n) {
+        std::fill(result.begin(), result.end(), 0);
+        common::UnusedAngle2Stroke(result, sends[n % sends.size()]);
+        sum += result[n % result.size()];
+      });
+    std::cout << "UnusedAngle2Stroke: " << ns << " [ns/call]" << std::endl;
+  }
+
+  double ns = measure(iterations, [&](int n) {
+      common::Stroke2Angle(angles, strokes[n % strokes.size()]);
+      sum += angles[n % angles.size()];
+    });
+  std::cout << "Stroke2Angle: " << ns << " [ns/call]" << std::endl;
+
+  // round trip of the swept joint, if it has a stroke
+  double max_error = 0.0, sum_error = 0.0;
+  size_t count = 0;
+  for (size_t k = 0; k < poses.size(); ++k) {
+    if (!test::has_stroke(joints[k], names.size()))
+      continue;
+    common::Stroke2Angle(angles, strokes[k]);
+    double error = std::fabs(angles[joints[k]] - poses[k][joints[k]]);
+    max_error = std::max(max_error, error);
+    sum_error += error;
+    ++count;
+  }
+  if (count > 0)
+    std::cout << "round trip: max " << max_error << " mean "
+              << sum_error / count << " [rad] (" << count
+              << " poses of " << robot_dir << ")" << std::endl;
+
+  std::cout << "(" << iterations << " calls, " << names.size() << " joints, "
+            << "checksum " << sum << ")" << std::endl;
+  return 0;
+}
@@ -0,0 +1,206 @@
+/// @brief helpers to sweep angle joints over their URDF limits
+///   without robot_description or hardware
+///
+/// Limits are read from <limit> of the urdf xacro of each parts
+/// in robot.cfg (${prefix} is expanded to l and r).
+
+#ifndef AERO_TEST_JOINT_SWEEP_H_
+#define AERO_TEST_JOINT_SWEEP_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <unistd.h>
+
+#include <ros/package.h>
+
+#include "aero_hardware_interface/AeroControllers.hh"
+#include "aero_hardware_interface/AngleJointNames.hh"
+#include "aero_hardware_interface/UnusedAngle2Stroke.hh"
+#include "aero_hardware_interface/ConversionTables.hh"
+
+namespace aero
+{
+  namespace test
+  {
+    struct JointLimit
+    {
+      double lower;
+      double upper;
+    };
+
+    /// @brief angle joints of the built controllers
+    inline size_t number_of_angle_joints()
+    {
+      // controllers without port
+      controller::AeroUpperController upper("");
+      controller::AeroLowerController lower("");
+      return upper.get_number_of_angle_joints() +
+        lower.get_number_of_angle_joints();
+    }
+
+    /// @brief AngleJointNames of the built controllers
+    inline std::vector<std::string> angle_joint_names()
+    {
+      std::vector<std::string> names(number_of_angle_joints());
+      common::AngleJointNames(names);
+      return names;
+    }
+
+    /// @brief false if the joint has no stroke of its own
+    ///   (follows another joint, e.g. fingers of a hand)
+    inline bool has_stroke(size_t _joint, size_t _joints)
+    {
+      std::vector<bool> send(_joints, false);
+      send[_joint] = true;
+      std::vector<int16_t> strokes(controller::AERO_DOF, 0);
+      common::UnusedAngle2Stroke(strokes, send);
+      return std::count(strokes.begin(), strokes.end(), 0x7fff) <
+        static_cast<int>(controller::AERO_DOF);
+    }
+
+    /// @brief robot directory of aero_description the code was generated for
+    inline std::string generated_robot_dir()
+    {
+      std::vector<std::string> names = angle_joint_names();
+
+      std::string description = ros::package::getPath("aero_description");
+      DIR* dir = opendir(description.c_str());
+      if (!dir)
+        return "";
+      std::string found;
+      while (struct dirent* entry = readdir(dir)) {
+        std::string robot = description + "/" + entry->d_name;
+        if (entry->d_name[0] == '.' ||
+            access((robot + "/robot.cfg").c_str(), R_OK))
+          continue;
+        common::ConversionTables tables;
+        if (tables.load(robot, "") && tables.angle_joint_names() == names)
+          found = robot;
+      }
+      closedir(dir);
+      return found;
+    }
+
+    /// @brief value of attribute _name in _tag, empty if not found
+    inline std::string xml_attribute(const std::string& _tag,
+                                     const std::string& _name)
+    {
+      size_t pos = _tag.find(" " + _name + "=\"");
+      if (pos == std::string::npos)
+        return "";
+      pos += _name.size() + 3;
+      return _tag.substr(pos, _tag.find('"', pos) - pos);
+    }
+
+    /// @brief add limits of joints in one xacro file
+    inline void read_xacro_limits(const std::string& _file,
+                                  std::map<std::string, JointLimit>& _limits)
+    {
+      std::ifstream file(_file.c_str());
+      std::stringstream stream;
+      stream << file.rdbuf();
+      const std::string xml = stream.str();
+
+      size_t pos = 0;
+      while ((pos = xml.find("<joint ", pos)) != std::string::npos) {
+        size_t tag_end = xml.find('>', pos);
+        size_t end = xml.find("</joint>", pos);
+        if (tag_end == std::string::npos)
+          break;
+        std::string name = xml_attribute(xml.substr(pos, tag_end - pos), "name");
+        std::string body = xml.substr(pos, end == std::string::npos ?
+                                      std::string::npos : end - pos);
+        pos = tag_end;
+
+        size_t limit = body.find("<limit");
+        if (name.empty() || limit == std::string::npos)
+          continue;
+        std::string tag = body.substr(limit, body.find('>', limit) - limit);
+        JointLimit l = {atof(xml_attribute(tag, "lower").c_str()),
+                        atof(xml_attribute(tag, "upper").c_str())};
+
+        size_t prefix = name.find("${prefix}");
+        if (prefix == std::string::npos) {
+          _limits[name] = l;
+        } else {
+          _limits[std::string(name).replace(prefix, 9, "l")] = l;
+          _limits[std::string(name).replace(prefix, 9, "r")] = l;
+        }
+      }
+    }
+
+    /// @brief limits of all revolute joints in parts of robot.cfg
+    inline std::map<std::string, JointLimit> read_joint_limits(
+        const std::string& _robot_dir)
+    {
+      std::map<std::string, JointLimit> limits;
+      std::ifstream cfg((_robot_dir + "/robot.cfg").c_str());
+      std::string line;
+      while (std::getline(cfg, line)) {
+        std::istringstream fields(line);
+        std::string parts;
+        fields >> parts;
+        if (parts.empty() || parts[0] == ':' || parts[0] == '#')
+          continue;
+
+        std::string shop = parts.substr(0, parts.find('/'));
+        std::string dir;
+        if (shop == "aero_shop")
+          dir = _robot_dir + "/../../" + parts + "/urdf";
+        else
+          dir = ros::package::getPath(shop) + parts.substr(shop.size()) + "/urdf";
+
+        DIR* d = opendir(dir.c_str());
+        if (!d)
+          continue;
+        while (struct dirent* entry = readdir(d)) {
+          std::string name = entry->d_name;
+          if (name.find(".xacro") != std::string::npos)
+            read_xacro_limits(dir + "/" + name, limits);
+        }
+        closedir(d);
+      }
+      return limits;
+    }
+
+    /// @brief all joints at 0 (or nearest limit), one joint swept
+    ///   from lower to upper limit by _step
+    /// @param _joints joint swept at each pose
+    inline std::vector<std::vector<double> > sweep_poses(
+        const std::vector<std::string>& _names,
+        const std::map<std::string, JointLimit>& _limits, double _step,
+        std::vector<size_t>& _joints)
+    {
+      std::vector<double> base(_names.size(), 0.0);
+      for (size_t j = 0; j < _names.size(); ++j) {
+        auto l = _limits.find(_names[j]);
+        if (l != _limits.end())
+          base[j] = std::min(std::max(0.0, l->second.lower), l->second.upper);
+      }
+
+      std::vector<std::vector<double> > poses;
+      _joints.clear();
+      for (size_t j = 0; j < _names.size(); ++j) {
+        auto l = _limits.find(_names[j]);
+        if (l == _limits.end())
+          continue;
+        size_t steps = static_cast<size_t>(
+            (l->second.upper - l->second.lower) / _step);
+        for (size_t k = 0; k <= steps; ++k) {
+          poses.push_back(base);
+          poses.back()[j] = l->second.lower + k * _step;
+          _joints.push_back(j);
+        }
+      }
+      return poses;
+    }
+  }
+}
+
+#endif
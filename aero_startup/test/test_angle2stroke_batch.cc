@@ -0,0 +1,84 @@
+#include "aero_hardware_interface/AeroControllers.hh"
+#include "aero_hardware_interface/Angle2Stroke.hh"
+#include "aero_hardware_interface/UnusedAngle2Stroke.hh"
+#include "aero_hardware_interface/Angle2StrokeBatch.hh"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <algorithm>
+
+using namespace aero;
+using namespace aero::controller;
+
+/////////////////////////
+static size_t number_of_angle_joints()
+{
+  // controllers without port
+  AeroUpperController upper("");
+  AeroLowerController lower("");
+  return upper.get_number_of_angle_joints() +
+    lower.get_number_of_angle_joints();
+}
+
+/////////////////////////
+// converts one point as JointTrajectoryCallback did
+static std::vector<int16_t> convert_point(
+    std::vector<double> _angles, std::vector<bool> _send)
+{
+  for (size_t j = 0; j < _angles.size(); ++j)
+    if (std::isnan(_angles[j])) {
+      _angles[j] = 0.0;
+      _send[j] = false;
+    }
+  std::vector<int16_t> strokes(AERO_DOF);
+  common::Angle2Stroke(strokes, _angles);
+  common::UnusedAngle2Stroke(strokes, _send);
+  return strokes;
+}
+
+/////////////////////////
+TEST(Angle2StrokeBatchTest, matchesPointByPoint)
+{
+  const size_t joints = number_of_angle_joints();
+  const size_t points = 50;
+
+  std::vector<bool> send(joints, true);
+  send[joints / 2] = false; // not in trajectory
+  std::vector<double> angles(points * joints, 0.0);
+  for (size_t n = 0; n < points; ++n)
+    for (size_t j = 0; j < joints; ++j)
+      if (send[j]) angles[n * joints + j] = 0.002 * n * (j % 2 ? 1 : -1);
+  angles[3 * joints + 1] = NAN; // cancelled at point 3
+  angles[7 * joints + joints - 1] = NAN; // cancelled at point 7
+
+  std::vector<int16_t> upper, lower;
+  common::Angle2StrokeBatch(angles, send, upper, lower);
+  ASSERT_EQ(upper.size(), points * AERO_DOF_UPPER);
+  ASSERT_EQ(lower.size(), points * AERO_DOF_LOWER);
+
+  for (size_t n = 0; n < points; ++n) {
+    std::vector<int16_t> strokes = convert_point(
+        std::vector<double>(angles.begin() + n * joints,
+                            angles.begin() + (n + 1) * joints), send);
+    EXPECT_TRUE(std::equal(strokes.begin(), strokes.begin() + AERO_DOF_UPPER,
+                           upper.begin() + n * AERO_DOF_UPPER)) << n;
+    EXPECT_TRUE(std::equal(strokes.begin() + AERO_DOF_UPPER, strokes.end(),
+                           lower.begin() + n * AERO_DOF_LOWER)) << n;
+  }
+}
+
+/////////////////////////
+TEST(Angle2StrokeBatchTest, emptyTrajectory)
+{
+  std::vector<int16_t> upper(3), lower(3);
+  common::Angle2StrokeBatch(std::vector<double>(),
+                            std::vector<bool>(number_of_angle_joints(), true),
+                            upper, lower);
+  EXPECT_TRUE(upper.empty());
+  EXPECT_TRUE(lower.empty());
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
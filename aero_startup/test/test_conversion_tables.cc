@@ -0,0 +1,218 @@
+#include "aero_hardware_interface/Angle2Stroke.hh"
+#include "aero_hardware_interface/Stroke2Angle.hh"
+#include "aero_hardware_interface/UnusedAngle2Stroke.hh"
+#include "joint_sweep.hh"
+#include <gtest/gtest.h>
+#include <random>
+
+using namespace aero;
+using namespace aero::controller;
+
+/////////////////////////
+class ConversionTablesTest : public ::testing::Test
+{
+  protected: virtual void SetUp()
+  {
+    robot_dir = test::generated_robot_dir();
+    ASSERT_FALSE(robot_dir.empty());
+    ASSERT_TRUE(tables.load(robot_dir, ""));
+    ASSERT_EQ(tables.number_of_strokes(), AERO_DOF);
+  }
+
+  protected: std::string robot_dir;
+
+  protected: common::ConversionTables tables;
+};
+
+/////////////////////////
+TEST_F(ConversionTablesTest, angle2StrokeMatchesGenerated)
+{
+  const size_t joints = tables.number_of_angle_joints();
+  std::mt19937 random(0);
+  std::uniform_real_distribution<double> angle(-1.6, 1.6);
+
+  for (int n = 0; n < 2000; ++n) {
+    std::vector<double> angles(joints);
+    for (size_t j = 0; j < joints; ++j)
+      angles[j] = (n == 0 ? 0.0 : angle(random));
+    std::vector<int16_t> expected(AERO_DOF), strokes(AERO_DOF);
+    common::Angle2Stroke(expected, angles);
+    tables.Angle2Stroke(strokes, angles);
+    ASSERT_EQ(expected, strokes) << n;
+  }
+}
+
+/////////////////////////
+TEST_F(ConversionTablesTest, angle2StrokeSaturatesOutOfTable)
+{
+  const size_t joints = tables.number_of_angle_joints();
+  size_t saturated = 0;
+  for (size_t j = 0; j < joints; ++j) {
+    // strokes of joint j at a few angles, tables are not linear
+    std::vector<std::vector<int16_t> > inside;
+    for (int k = -2; k <= 2; ++k) {
+      std::vector<double> angles(joints, 0.0);
+      angles[j] = 0.2 * k;
+      std::vector<int16_t> strokes(AERO_DOF);
+      common::Angle2Stroke(strokes, angles);
+      inside.push_back(strokes);
+    }
+
+    for (double sign : {-1.0, 1.0}) {
+      // far past any table (no stroke to reach them)
+      std::vector<double> far(joints, 0.0), farther(joints, 0.0);
+      far[j] = sign * 10.0;
+      farther[j] = sign * 20.0;
+      std::vector<int16_t> expected(AERO_DOF), strokes(AERO_DOF),
+        further(AERO_DOF);
+      common::Angle2Stroke(expected, far);
+      tables.Angle2Stroke(strokes, far);
+      tables.Angle2Stroke(further, farther);
+
+      for (size_t i = 0; i < AERO_DOF; ++i) {
+        bool linear = true;
+        for (size_t k = 1; k + 1 < inside.size(); ++k)
+          linear &= (std::abs(inside[k + 1][i] - 2 * inside[k][i]
+                              + inside[k - 1][i]) <= 1);
+        if (linear) continue;
+        EXPECT_EQ(strokes[i], expected[i]) << "joint " << j << " stroke " << i;
+        EXPECT_EQ(further[i], strokes[i]) << "joint " << j << " stroke " << i;
+        ++saturated;
+      }
+    }
+  }
+  EXPECT_GT(saturated, 0u);
+}
+
+/////////////////////////
+TEST_F(ConversionTablesTest, stroke2AngleMatchesGenerated)
+{
+  const size_t joints = tables.number_of_angle_joints();
+  std::mt19937 random(0);
+  std::uniform_int_distribution<int> stroke(-3000, 3000);
+
+  for (int n = 0; n < 2000; ++n) {
+    std::vector<int16_t> strokes(AERO_DOF);
+    for (size_t i = 0; i < strokes.size(); ++i)
+      strokes[i] = static_cast<int16_t>(n == 0 ? 0 : stroke(random));
+    std::vector<double> expected(joints), angles(joints);
+    common::Stroke2Angle(expected, strokes);
+    tables.Stroke2Angle(angles, strokes);
+    for (size_t j = 0; j < joints; ++j)
+      ASSERT_EQ(expected[j], angles[j]) << n << " " << j;
+  }
+}
+
+/////////////////////////
+TEST_F(ConversionTablesTest, unusedMatchesGenerated)
+{
+  const size_t joints = tables.number_of_angle_joints();
+  for (size_t j = 0; j < joints; ++j) {
+    std::vector<bool> send(joints, true);
+    send[j] = false;
+    std::vector<int16_t> expected(AERO_DOF, 0), strokes(AERO_DOF, 0);
+    common::UnusedAngle2Stroke(expected, send);
+    tables.UnusedAngle2Stroke(strokes, send);
+    ASSERT_EQ(expected, strokes) << j;
+
+    // all but one
+    send.assign(joints, false);
+    send[j] = true;
+    expected.assign(AERO_DOF, 0);
+    strokes.assign(AERO_DOF, 0);
+    common::UnusedAngle2Stroke(expected, send);
+    tables.UnusedAngle2Stroke(strokes, send);
+    ASSERT_EQ(expected, strokes) << j;
+  }
+}
+
+/////////////////////////
+TEST_F(ConversionTablesTest, cacheIsReused)
+{
+  char name[] = "/tmp/aero_tables_XXXXXX";
+  int fd = mkstemp(name);
+  ASSERT_GE(fd, 0);
+  close(fd);
+  unlink(name); // missing cache is created
+
+  common::ConversionTables built, cached;
+  ASSERT_TRUE(built.load(robot_dir, name));
+  EXPECT_FALSE(built.from_cache());
+  ASSERT_TRUE(cached.load(robot_dir, name));
+  EXPECT_TRUE(cached.from_cache());
+  EXPECT_EQ(built.hash(), cached.hash());
+
+  std::vector<double> angles(cached.number_of_angle_joints(), 0.3);
+  std::vector<int16_t> expected(AERO_DOF), strokes(AERO_DOF);
+  common::Angle2Stroke(expected, angles);
+  cached.Angle2Stroke(strokes, angles);
+  EXPECT_EQ(expected, strokes);
+
+  // broken cache is rebuilt
+  FILE* fp = fopen(name, "r+b");
+  ASSERT_TRUE(fp != nullptr);
+  fseek(fp, 16, SEEK_SET);
+  fputc(0xff, fp);
+  fclose(fp);
+  common::ConversionTables rebuilt;
+  ASSERT_TRUE(rebuilt.load(robot_dir, name));
+  EXPECT_FALSE(rebuilt.from_cache());
+
+  unlink(name);
+}
+
+/////////////////////////
+TEST_F(ConversionTablesTest, velocityMatchesFiniteDifference)
+{
+  const size_t joints = tables.number_of_angle_joints();
+  std::mt19937 random(0);
+  std::uniform_int_distribution<int> stroke(-3000, 3000);
+
+  size_t checked = 0;
+  for (int n = 0; n < 500; ++n) {
+    std::vector<int16_t> strokes(AERO_DOF);
+    for (size_t i = 0; i < strokes.size(); ++i)
+      strokes[i] = static_cast<int16_t>(stroke(random));
+
+    for (size_t i = 0; i < AERO_DOF; ++i) {
+      // one stroke moving at 1 [stroke/s]
+      std::vector<double> stroke_velocities(AERO_DOF, 0.0);
+      stroke_velocities[i] = 1.0;
+      std::vector<double> velocities(joints);
+      tables.Stroke2AngleVelocity(velocities, strokes, stroke_velocities);
+
+      std::vector<int16_t> forward(strokes), backward(strokes);
+      ++forward[i];
+      --backward[i];
+      std::vector<double> angles(joints), next(joints), previous(joints);
+      tables.Stroke2Angle(angles, strokes);
+      tables.Stroke2Angle(next, forward);
+      tables.Stroke2Angle(previous, backward);
+
+      for (size_t j = 0; j < joints; ++j) {
+        double ahead = next[j] - angles[j];
+        double behind = angles[j] - previous[j];
+        // skip table knots and clamped ends, where the slope changes
+        if (std::fabs(ahead - behind) > 1e-6 * (1 + std::fabs(ahead)))
+          continue;
+        EXPECT_NEAR(velocities[j], ahead, 1e-6 + 1e-3 * std::fabs(ahead))
+          << n << " stroke " << i << " joint " << j;
+        checked += (ahead != 0);
+      }
+
+      // linear in the stroke velocities
+      stroke_velocities[i] = -2.5;
+      std::vector<double> scaled(joints);
+      tables.Stroke2AngleVelocity(scaled, strokes, stroke_velocities);
+      for (size_t j = 0; j < joints; ++j)
+        ASSERT_NEAR(scaled[j], -2.5 * velocities[j], 1e-9) << n << " " << j;
+    }
+  }
+  EXPECT_GT(checked, 0u);
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
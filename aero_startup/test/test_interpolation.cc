@@ -0,0 +1,69 @@
+#include "aero_hardware_interface/Interpolation.hh"
+#include <gtest/gtest.h>
+
+using namespace aero::interpolation;
+
+/////////////////////////
+TEST(InterpolationTest, defaultCurves)
+{
+  // values of the default control points
+  EXPECT_FLOAT_EQ(Interpolation(i_constant).interpolate(0.5), 0.0);
+  EXPECT_FLOAT_EQ(Interpolation(i_linear).interpolate(0.3), 0.3);
+  EXPECT_FLOAT_EQ(Interpolation(i_bezier).interpolate(0.5), 0.75);
+  EXPECT_FLOAT_EQ(Interpolation(i_cbezier).interpolate(0.5), 0.5);
+  EXPECT_FLOAT_EQ(Interpolation(i_slowout).interpolate(0.25), 0.4);
+  EXPECT_FLOAT_EQ(Interpolation(i_slowin).interpolate(0.75), 0.6);
+  EXPECT_FLOAT_EQ(Interpolation(i_sigmoid).interpolate(0.5), 0.5);
+
+  for (int id = i_linear; id <= i_cbezier; ++id) {
+    Interpolation curve(id);
+    EXPECT_TRUE(curve.is(id));
+    EXPECT_NEAR(curve.interpolate(0.0), 0.0, 1e-6) << id;
+    EXPECT_NEAR(curve.interpolate(1.0), 1.0, 1e-6) << id;
+  }
+}
+
+/////////////////////////
+TEST(InterpolationTest, setPoints)
+{
+  Interpolation bezier(i_bezier);
+  bezier.set_points({0.0, 0.0}, 1);
+  EXPECT_FLOAT_EQ(bezier.interpolate(0.5), 0.25);
+
+  // x of slow out is limited to y
+  Interpolation slowout(i_slowout);
+  slowout.set_points({0.9, 0.6}, 1);
+  EXPECT_FLOAT_EQ(slowout.interpolate(0.3), 0.3);
+
+  // sigmoid points 2 and 3 do not cross
+  Interpolation sigmoid(i_sigmoid);
+  sigmoid.set_points({0.9, 0.9}, 2);
+  EXPECT_FLOAT_EQ(sigmoid.interpolate(0.7), 0.8);
+}
+
+/////////////////////////
+TEST(InterpolationTest, tableFollowsCurve)
+{
+  for (int id = i_constant; id <= i_cbezier; ++id) {
+    Interpolation curve(id), table(id);
+    table.tabulate(1000);
+    for (int i = 0; i <= 997; ++i) {
+      float t = i / 997.0f;
+      EXPECT_NEAR(table.interpolate(t), curve.interpolate(t), 1e-4) << id;
+    }
+
+    // points set after tabulate are in the table
+    curve.set_points({0.4, 0.6}, 1);
+    table.set_points({0.4, 0.6}, 1);
+    EXPECT_NEAR(table.interpolate(0.45), curve.interpolate(0.45), 1e-4) << id;
+
+    table.tabulate(0);
+    EXPECT_EQ(table.interpolate(0.45), curve.interpolate(0.45)) << id;
+  }
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
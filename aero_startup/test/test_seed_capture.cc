@@ -0,0 +1,128 @@
+#include "aero_hardware_interface/AeroControllerProto.hh"
+#include "aero_hardware_interface/SeedCapture.hh"
+#include "aero_hardware_interface/SeedEmulator.hh"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace aero::controller;
+
+/////////////////////////
+// proto with some joints, port may be empty
+class CaptureProto : public AeroControllerProto
+{
+public:
+  explicit CaptureProto(const std::string& _port) :
+    AeroControllerProto(_port, 0)
+  {
+    for (size_t i = 0; i < 20; ++i) {
+      stroke_joint_indices_.push_back(
+          AJointIndex(0, i, i, std::string("joint") + std::to_string(i)));
+    }
+    stroke_vector_.resize(20);
+    stroke_ref_vector_.resize(20);
+    stroke_cur_vector_.resize(20);
+    status_vector_.resize(20);
+  }
+};
+
+/////////////////////////
+static std::string capture_file(const char* _name)
+{
+  return std::string("/tmp/test_seed_capture_") + _name + "_"
+    + std::to_string(::getpid()) + ".seedcap";
+}
+
+/////////////////////////
+TEST(SeedCaptureTest, fileRoundTrip)
+{
+  std::string file = capture_file("round_trip");
+  SeedFrame frame;
+  frame.set_header(CMD_GET_POS, 0);
+  frame.set_checksum();
+  uint8_t bytes[3] = {0xfd, 0xdf, 0x40};
+
+  {
+    SeedCapture capture(8);
+    ASSERT_TRUE(capture.open(file));
+    capture.record(SEED_CAPTURE_TX, frame);
+    capture.record(SEED_CAPTURE_RX, bytes, sizeof(bytes));
+  }
+
+  SeedCaptureReader reader;
+  ASSERT_TRUE(reader.open(file));
+  ASSERT_EQ(reader.size(), 2u);
+  EXPECT_EQ(reader[0].direction, SEED_CAPTURE_TX);
+  EXPECT_EQ(reader[0].length, RAW_DATA_LENGTH);
+  EXPECT_EQ(0, memcmp(reader[0].data, frame.data(), RAW_DATA_LENGTH));
+  EXPECT_EQ(reader[1].direction, SEED_CAPTURE_RX);
+  EXPECT_EQ(reader[1].length, 3);
+  EXPECT_LE(reader[0].stamp_ns, reader[1].stamp_ns);
+  reader.close();
+  ::unlink(file.c_str());
+}
+
+/////////////////////////
+TEST(SeedCaptureTest, dropsWhenFull)
+{
+  std::string file = capture_file("full");
+  SeedFrame frame;
+
+  SeedCapture capture(4);
+  ASSERT_TRUE(capture.open(file));
+  // flusher sleeps SEED_CAPTURE_FLUSH_MS, ring is full before that
+  for (int i = 0; i < 10; ++i) capture.record(SEED_CAPTURE_TX, frame);
+  capture.close();
+  EXPECT_EQ(capture.flushed() + capture.dropped(), 10u);
+  EXPECT_GT(capture.dropped(), 0u);
+  ::unlink(file.c_str());
+}
+
+/////////////////////////
+TEST(SeedCaptureTest, replayMatchesBus)
+{
+  std::string file = capture_file("replay");
+  SeedEmulatorConfig config;
+  SeedEmulator emulator(config);
+  ASSERT_TRUE(emulator.open());
+  std::thread thread([&emulator]() { emulator.run(); });
+
+  std::vector<int16_t> actual;
+  {
+    CaptureProto proto(emulator.port());
+    ASSERT_TRUE(proto.start_capture(file));
+    std::vector<int16_t> strokes(20, 0x7fff);
+    strokes[2] = 300;
+    proto.set_position(strokes, 5);
+    usleep(100 * 1000);
+    proto.update_position();
+    actual = proto.get_actual_stroke_vector();
+    // capture closes with the bus
+  }
+  emulator.stop();
+  thread.join();
+
+  SeedCaptureReader reader;
+  ASSERT_TRUE(reader.open(file));
+  CaptureProto offline("");
+  SeedFrameParser parser;
+  SeedFrame frame;
+  std::vector<int16_t> replayed;
+  size_t responses = 0;
+  for (size_t i = 0; i < reader.size(); ++i) {
+    if (reader[i].direction != SEED_CAPTURE_RX) continue;
+    parser.push(reader[i].data, reader[i].length);
+    while (parser.pop(frame)) {
+      offline.decode_frame(frame, replayed);
+      ++responses;
+    }
+  }
+  EXPECT_EQ(responses, 2u);
+  EXPECT_EQ(replayed, actual);
+  ::unlink(file.c_str());
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
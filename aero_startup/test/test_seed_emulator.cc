@@ -0,0 +1,113 @@
+#include "aero_hardware_interface/AeroControllerProto.hh"
+#include "aero_hardware_interface/SeedEmulator.hh"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace aero::controller;
+
+/////////////////////////
+// proto on emulator port with some joints
+class EmulatedProto : public AeroControllerProto
+{
+public:
+  explicit EmulatedProto(const std::string& _port) :
+    AeroControllerProto(_port, 0)
+  {
+    for (size_t i = 0; i < 20; ++i) {
+      stroke_joint_indices_.push_back(
+          AJointIndex(0, i, i, std::string("joint") + std::to_string(i)));
+    }
+    stroke_vector_.resize(20);
+    stroke_ref_vector_.resize(20);
+    stroke_cur_vector_.resize(20);
+    status_vector_.resize(20);
+  }
+};
+
+/////////////////////////
+// emulator running on its own thread
+class EmulatorThread
+{
+public:
+  explicit EmulatorThread(const SeedEmulatorConfig& _config) :
+    emulator(_config)
+  {
+    opened = emulator.open();
+    thread = std::thread([this]() { emulator.run(); });
+  }
+  ~EmulatorThread()
+  {
+    emulator.stop();
+    thread.join();
+  }
+  SeedEmulator emulator;
+  bool opened;
+  std::thread thread;
+};
+
+/////////////////////////
+TEST(SeedEmulatorTest, positionFollowsCommand)
+{
+  SeedEmulatorConfig config;
+  EmulatorThread emu(config);
+  ASSERT_TRUE(emu.opened);
+
+  EmulatedProto proto(emu.emulator.port());
+  std::vector<int16_t> strokes(20, 0x7fff);
+  strokes[3] = 1000;
+
+  // move in 100 ms, time constant is 25 ms
+  EXPECT_TRUE(proto.set_position(strokes, 10));
+  usleep(200 * 1000);
+  proto.update_position();
+
+  std::vector<int16_t> actual = proto.get_actual_stroke_vector();
+  ASSERT_EQ(actual.size(), 20u);
+  EXPECT_NEAR(actual[3], 1000, 5);
+  EXPECT_EQ(actual[4], 0);
+}
+
+/////////////////////////
+TEST(SeedEmulatorTest, recoversFromFaults)
+{
+  SeedEmulatorConfig config;
+  config.drop_rate = 0.002;
+  config.bad_checksum_rate = 0.05;
+  config.seed = 1;
+  EmulatorThread emu(config);
+  ASSERT_TRUE(emu.opened);
+
+  EmulatedProto proto(emu.emulator.port());
+  std::vector<int16_t> strokes(20, 500);
+
+  // a broken response costs that cycle only
+  int replied = 0;
+  const int cycles = 100;
+  for (int i = 0; i < cycles; ++i) {
+    if (proto.set_position(strokes, 5)) ++replied;
+  }
+  size_t broken = emu.emulator.bad_checksums() + emu.emulator.dropped_bytes();
+  EXPECT_GT(broken, 0u);
+  EXPECT_GE(replied, cycles - 2 * static_cast<int>(broken));
+}
+
+/////////////////////////
+TEST(SeedEmulatorTest, misstepStatus)
+{
+  SeedEmulatorConfig config;
+  config.misstep_rate = 1.0;
+  EmulatorThread emu(config);
+  ASSERT_TRUE(emu.opened);
+
+  EmulatedProto proto(emu.emulator.port());
+  proto.update_status();
+  EXPECT_TRUE(proto.get_status());
+  proto.reset_status();
+  EXPECT_FALSE(proto.get_status());
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
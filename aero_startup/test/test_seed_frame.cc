@@ -0,0 +1,109 @@
+#include "aero_hardware_interface/AeroControllerProto.hh"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace aero::controller;
+
+/////////////////////////
+// allocation counting hook
+static std::atomic<long> g_allocations(0);
+
+void* operator new(size_t _size)
+{
+  ++g_allocations;
+  void* ptr = std::malloc(_size);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* _ptr) noexcept
+{
+  std::free(_ptr);
+}
+
+/////////////////////////
+// proto in debug mode with some joints
+class DebugProto : public AeroControllerProto
+{
+public:
+  DebugProto() : AeroControllerProto("", 0)
+  {
+    for (size_t i = 0; i < 20; ++i) {
+      stroke_joint_indices_.push_back(
+          AJointIndex(0, i, i, std::string("joint") + std::to_string(i)));
+    }
+    stroke_vector_.resize(20);
+    stroke_ref_vector_.resize(20);
+    stroke_cur_vector_.resize(20);
+    status_vector_.resize(20);
+  }
+};
+
+/////////////////////////
+TEST(SeedFrameTest, encodeLongFrame)
+{
+  SeedFrame frame;
+  encode_short_(1234, &frame[RAW_HEADER_OFFSET]);
+  frame.set_header(CMD_MOVE_ABS_POS, 0x00);
+  frame.set_time(50);
+  frame.set_checksum();
+
+  EXPECT_EQ(frame.size(), RAW_DATA_LENGTH);
+  EXPECT_EQ(frame[0], 0xFD);
+  EXPECT_EQ(frame[1], 0xDF);
+  EXPECT_EQ(frame[2], 0x40);
+  EXPECT_EQ(frame.cmd(), CMD_MOVE_ABS_POS);
+  EXPECT_EQ(decode_short_(&frame[RAW_HEADER_OFFSET]), 1234);
+  EXPECT_EQ(decode_short_(&frame[65]), 50);
+  EXPECT_TRUE(frame.valid());
+
+  frame[10] ^= 0x01;
+  EXPECT_FALSE(frame.valid());
+}
+
+/////////////////////////
+TEST(SeedFrameTest, parserResync)
+{
+  SeedFrame sent;
+  sent.set_header(CMD_GET_POS, 0x00);
+  sent[RAW_HEADER_OFFSET] = 0x12;
+  sent.set_checksum();
+
+  SeedFrameParser parser;
+  SeedFrame received;
+  const uint8_t garbage[] = {0x00, 0xFD, 0x33, 0xFD, 0xDF, 0x40, 0x01};
+  parser.push(garbage, sizeof(garbage));
+  parser.push(sent.data(), 30);
+  EXPECT_FALSE(parser.pop(received));
+  parser.push(sent.data() + 30, sent.size() - 30);
+
+  long allocations = g_allocations;
+  ASSERT_TRUE(parser.pop(received));
+  EXPECT_EQ(g_allocations - allocations, 0);
+  EXPECT_EQ(received.size(), RAW_DATA_LENGTH);
+  EXPECT_EQ(received[RAW_HEADER_OFFSET], 0x12);
+  EXPECT_EQ(parser.size(), 0u);
+}
+
+/////////////////////////
+TEST(SeedFrameTest, noAllocationInCycle)
+{
+  DebugProto proto;
+  std::vector<int16_t> strokes(20, 100);
+
+  long allocations = g_allocations;
+  for (int i = 0; i < 10; ++i) {
+    proto.set_position_no_wait(strokes, 10);
+    proto.update_position();
+    proto.get_current(strokes);
+  }
+  EXPECT_EQ(g_allocations - allocations, 0);
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,169 @@
+#include "aero_hardware_interface/StrokeSpline.hh"
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace aero::interpolation;
+
+static const int64_t CSEC = 10000; // [usec]
+
+/////////////////////////
+// stroke 0 splined, 1 no-send at the last point, 2 never sent
+static StrokeTimeline trajectory()
+{
+  StrokeTimeline points(3);
+  points.push_back({0, 100, 0x7fff}, 0);
+  points.push_back({500, 200, 0x7fff}, 30 * CSEC);
+  points.push_back({800, 300, 0x7fff}, 50 * CSEC);
+  points.push_back({200, 400, 0x7fff}, 120 * CSEC);
+  points.push_back({300, 0x7fff, 0x7fff}, 150 * CSEC);
+  return points;
+}
+
+/////////////////////////
+static double at(const StrokeSpline& _spline, double _csec, size_t _stroke)
+{
+  int16_t strokes[3];
+  _spline.sample(_csec * CSEC, strokes);
+  return strokes[_stroke];
+}
+
+/////////////////////////
+TEST(StrokeSplineTest, passesThroughPoints)
+{
+  StrokeTimeline points = trajectory();
+  StrokeSpline spline(points);
+  ASSERT_TRUE(spline.valid());
+  EXPECT_EQ(spline.duration(), 150 * CSEC);
+  for (size_t k = 0; k < points.size(); ++k) {
+    int16_t strokes[3];
+    spline.sample(points.time(k), strokes);
+    EXPECT_EQ(strokes[0], points.stroke(k, 0)) << k;
+    EXPECT_EQ(strokes[2], 0x7fff) << k;
+  }
+
+  // clamped out of the trajectory
+  EXPECT_EQ(at(spline, -10, 0), 0);
+  EXPECT_EQ(at(spline, 200, 0), 300);
+}
+
+/////////////////////////
+TEST(StrokeSplineTest, velocityIsContinuous)
+{
+  StrokeSpline spline(trajectory());
+  // at rest at first and last point
+  EXPECT_NEAR(at(spline, 1, 0) - at(spline, 0, 0), 0.0, 2.0);
+  EXPECT_NEAR(at(spline, 150, 0) - at(spline, 149, 0), 0.0, 2.0);
+
+  // same slope on both sides of inner points, where linear blending
+  // of the points would jump
+  const double e = 0.5;
+  for (double knot : {30.0, 50.0, 120.0}) {
+    double before = (at(spline, knot, 0) - at(spline, knot - 2 * e, 0));
+    double after = (at(spline, knot + 2 * e, 0) - at(spline, knot, 0));
+    EXPECT_NEAR(before, after, 3.0) << knot;
+  }
+}
+
+/////////////////////////
+TEST(StrokeSplineTest, staysWithinPoints)
+{
+  // fast to a point at a stroke limit, then at rest there
+  const int16_t limit = 1000;
+  StrokeTimeline points(1);
+  points.push_back({0}, 0);
+  points.push_back({900}, 30 * CSEC);
+  points.push_back({limit}, 35 * CSEC);
+  points.push_back({limit}, 60 * CSEC);
+  StrokeSpline spline(points);
+  for (double csec = 0; csec <= 60; csec += 0.25) {
+    EXPECT_LE(at(spline, csec, 0), limit) << csec;
+    EXPECT_GE(at(spline, csec, 0), 0) << csec;
+  }
+  // and between the points around it
+  for (double csec = 30; csec <= 35; csec += 0.25)
+    EXPECT_GE(at(spline, csec, 0), 900) << csec;
+}
+
+/////////////////////////
+TEST(StrokeSplineTest, linearWithoutSpline)
+{
+  StrokeSpline spline(trajectory());
+  // stroke 1 has a no-send point, linear between points
+  EXPECT_EQ(at(spline, 15, 1), 150);
+  EXPECT_EQ(at(spline, 85, 1), 350);
+  EXPECT_EQ(at(spline, 140, 1), 0x7fff);
+}
+
+/////////////////////////
+TEST(StrokeSplineTest, resample)
+{
+  StrokeTimeline points = trajectory();
+  // points not after the previous one are skipped
+  StrokeTimeline skipped(3);
+  for (size_t k = 0; k < points.size(); ++k) {
+    skipped.push_back(points.point(k), points.time(k));
+    if (k == 1)
+      skipped.push_back({9999, 9999, 0x7fff}, 30 * CSEC);
+  }
+  StrokeSpline spline(skipped);
+  StrokeTimeline frames = spline.resample(10 * CSEC);
+  ASSERT_EQ(frames.size(), 16u);
+  for (size_t k = 0; k < frames.size(); ++k) {
+    EXPECT_EQ(frames.time(k), 10 * CSEC * static_cast<int64_t>(k));
+    EXPECT_EQ(frames.stroke(k, 0), at(spline, 10.0 * k, 0));
+  }
+  EXPECT_EQ(frames.stroke(3, 0), 500);
+
+  StrokeTimeline one(3);
+  one.push_back(points.point(0), 0);
+  EXPECT_FALSE(StrokeSpline(one).valid());
+  EXPECT_TRUE(StrokeSpline(one).resample(10 * CSEC).empty());
+}
+
+/////////////////////////
+TEST(StrokeSplineTest, timelineKeepsPoints)
+{
+  // beyond 655 [s] of uint16_t centiseconds
+  const int64_t hour = 3600LL * 1000 * 1000;
+  StrokeTimeline points(2);
+  for (int k = 0; k < 100; ++k)
+    points.push_back({static_cast<int16_t>(k), static_cast<int16_t>(-k)},
+                     k * hour);
+  ASSERT_EQ(points.size(), 100u);
+  EXPECT_EQ(points.duration(), 99 * hour);
+  for (int k = 0; k < 100; ++k) {
+    EXPECT_EQ(points.channel(0)[k], k);
+    EXPECT_EQ(points.stroke(k, 1), -k);
+  }
+
+  points.erase_front(90);
+  ASSERT_EQ(points.size(), 10u);
+  EXPECT_EQ(points.time(0), 90 * hour);
+  EXPECT_EQ(points.point(9), std::vector<int16_t>({99, -99}));
+
+  // new points are no-send
+  points.resize(12);
+  EXPECT_EQ(points.stroke(11, 0), 0x7fff);
+  EXPECT_EQ(points.stroke(9, 1), -99);
+  // also points dropped before
+  points.resize(5);
+  points.resize(7);
+  EXPECT_EQ(points.stroke(6, 1), 0x7fff);
+  EXPECT_EQ(points.stroke(4, 1), -94);
+
+  // reserved points are kept in place
+  StrokeTimeline reserved(2);
+  reserved.reserve(100);
+  reserved.push_back({1, 2}, 0);
+  const int16_t* channel = reserved.channel(1);
+  for (int k = 1; k < 100; ++k)
+    reserved.push_back({1, 2}, k);
+  EXPECT_EQ(reserved.channel(1), channel);
+  EXPECT_EQ(reserved.stroke(99, 1), 2);
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,491 @@
+#include "aero_hardware_interface/TrajectoryScheduler.hh"
+#include <gtest/gtest.h>
+
+using namespace aero;
+using namespace aero::controller;
+
+static const int64_t CSEC = 10000; // [usec]
+
+/////////////////////////
+// records frames sent by a scheduler
+class SentFrames
+{
+  public: TrajectoryScheduler::SendFunction function()
+  {
+    return [this](const std::vector<int16_t>& _strokes, uint16_t _csec) {
+      std::lock_guard<std::mutex> lock(mtx);
+      frames.push_back(_strokes);
+      csec.push_back(_csec);
+    };
+  }
+
+  public: std::vector<std::vector<int16_t> > get()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return frames;
+  }
+
+  public: std::vector<std::vector<int16_t> > frames;
+
+  public: std::vector<uint16_t> csec;
+
+  public: std::mutex mtx;
+};
+
+/////////////////////////
+static bool wait_idle(const TrajectoryScheduler& _scheduler, int _ms)
+{
+  for (int i = 0; i < _ms && _scheduler.active(); ++i)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  return !_scheduler.active();
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, sendsUntilLastPoint)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(3, 1, 2, sent.function());
+  interpolation::StrokeTimeline points(3);
+  points.push_back({0, 0, 0x7fff}, 0);
+  points.push_back({100, -100, 0x7fff}, 10 * CSEC);
+  points.push_back({300, 0x7fff, 0x7fff}, 20 * CSEC);
+  scheduler.submit(points, {});
+  EXPECT_TRUE(scheduler.active());
+  ASSERT_TRUE(wait_idle(scheduler, 1000));
+
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  ASSERT_GE(frames.size(), 2u);
+  EXPECT_EQ(sent.csec[0], 3);
+  int16_t last = -1;
+  for (size_t f = 0; f < frames.size(); ++f) {
+    EXPECT_EQ(frames[f][2], 0x7fff) << f; // never owned
+    EXPECT_GE(frames[f][0], last) << f;   // monotonic
+    last = frames[f][0];
+  }
+  EXPECT_EQ(frames.back()[0], 300);
+  EXPECT_EQ(frames.back()[1], 0x7fff); // no-send at the last point
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, newTrackTakesStrokes)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(2, 1, 0, sent.function());
+  interpolation::StrokeTimeline slow(2), fast(2);
+  slow.push_back({0, 0}, 0);
+  slow.push_back({1000, 1000}, 30 * CSEC);
+  fast.push_back({0x7fff, 0}, 0);
+  fast.push_back({0x7fff, -500}, 5 * CSEC);
+  scheduler.submit(slow, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  scheduler.submit(fast, {});
+  EXPECT_EQ(scheduler.number_of_tracks(), 2u);
+  ASSERT_TRUE(wait_idle(scheduler, 1000));
+
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  ASSERT_FALSE(frames.empty());
+  // slow track keeps stroke 0, stroke 1 ends where the fast track ends
+  EXPECT_EQ(frames.back()[0], 1000);
+  int16_t stroke1 = 0x7fff;
+  for (size_t f = 0; f < frames.size(); ++f)
+    if (frames[f][1] != 0x7fff) stroke1 = frames[f][1];
+  EXPECT_EQ(stroke1, -500);
+
+  // a track left without strokes is dropped
+  scheduler.submit(slow, {});
+  scheduler.submit(slow, {});
+  EXPECT_EQ(scheduler.number_of_tracks(), 1u);
+  scheduler.clear();
+  EXPECT_FALSE(scheduler.active());
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, pausesAndResumes)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(1, 1, 0, sent.function());
+  interpolation::StrokeTimeline points(1);
+  points.push_back({0}, 0);
+  points.push_back({1000}, 20 * CSEC);
+  scheduler.submit(points, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  scheduler.set_rate(0.0);
+  EXPECT_TRUE(scheduler.paused());
+  EXPECT_TRUE(scheduler.active());
+
+  size_t before = sent.get().size();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  EXPECT_LE(frames.size(), before + 1); // nothing sent while paused
+  EXPECT_LT(frames.back()[0], 1000);
+
+  scheduler.set_rate(1.0);
+  EXPECT_FALSE(scheduler.paused());
+  ASSERT_TRUE(wait_idle(scheduler, 1000));
+  EXPECT_EQ(sent.get().back()[0], 1000);
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, rateAppliesBeforeNextFrame)
+{
+  SentFrames sent;
+  // 100 [ms] frames
+  TrajectoryScheduler scheduler(1, 10, 0, sent.function());
+  interpolation::StrokeTimeline points(1);
+  points.push_back({0}, 0);
+  points.push_back({10000}, 1000 * CSEC);
+  scheduler.submit(points, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  scheduler.set_rate(0.0);
+  EXPECT_TRUE(scheduler.paused()); // at once, before the scheduler wakes
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  size_t before = sent.get().size();
+
+  // resume sends a frame without waiting for the next period
+  auto start = std::chrono::steady_clock::now();
+  scheduler.set_rate(0.5);
+  while (sent.get().size() == before &&
+         std::chrono::steady_clock::now() - start
+         < std::chrono::milliseconds(50))
+    std::this_thread::yield();
+  EXPECT_GT(sent.get().size(), before);
+  EXPECT_FALSE(scheduler.paused());
+
+  // paused at 2 [csec], a frame (10 [csec]) ahead at half speed
+  int16_t stroke = sent.get().back()[0];
+  EXPECT_GT(stroke, 60);
+  EXPECT_LT(stroke, 90);
+}
+
+/////////////////////////
+// last stroke _i sent in _frames, 0x7fff if never
+static int16_t last_sent(const std::vector<std::vector<int16_t> >& _frames,
+                         size_t _i)
+{
+  for (auto f = _frames.rbegin(); f != _frames.rend(); ++f)
+    if ((*f)[_i] != 0x7fff) return (*f)[_i];
+  return 0x7fff;
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, submitWhilePausedStartsPaused)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(2, 1, 0, sent.function());
+  interpolation::StrokeTimeline first(2), second(2);
+  first.push_back({0, 0x7fff}, 0);
+  first.push_back({1000, 0x7fff}, 20 * CSEC);
+  second.push_back({0x7fff, 0}, 0);
+  second.push_back({0x7fff, 1000}, 20 * CSEC);
+  scheduler.submit(first, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  scheduler.set_rate(0.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  size_t before = sent.get().size();
+  scheduler.submit(second, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(sent.get().size(), before); // nothing sent for the new track
+  EXPECT_TRUE(scheduler.paused());
+  EXPECT_EQ(scheduler.number_of_tracks(), 2u);
+
+  // both resume
+  scheduler.set_rate(1.0);
+  ASSERT_TRUE(wait_idle(scheduler, 1000));
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  ASSERT_GT(frames.size(), before);
+  EXPECT_EQ(last_sent(frames, 0), 1000);
+  EXPECT_EQ(last_sent(frames, 1), 1000);
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, appendWhilePausedStartsPaused)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(2, 1, 0, sent.function());
+  interpolation::StrokeTimeline moving(2), stream(2);
+  moving.push_back({0, 0x7fff}, 0);
+  moving.push_back({1000, 0x7fff}, 20 * CSEC);
+  stream.push_back({0x7fff, 0}, 0);
+  stream.push_back({0x7fff, 500}, 5 * CSEC);
+  scheduler.submit(moving, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  scheduler.set_rate(0.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  size_t before = sent.get().size();
+  scheduler.append(stream, 0, 50 * CSEC);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(sent.get().size(), before);
+  EXPECT_TRUE(scheduler.paused());
+
+  scheduler.set_rate(1.0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  ASSERT_GT(frames.size(), before);
+  EXPECT_EQ(last_sent(frames, 0), 1000);
+  EXPECT_EQ(last_sent(frames, 1), 500);
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, pauseWaitsForFrameInFlight)
+{
+  // bus commands in order, 1 for frames and 0 for the servo_on of a pause
+  std::vector<int> bus;
+  std::mutex mtx;
+  std::condition_variable cond;
+  bool blocked = false, release = false;
+  TrajectoryScheduler scheduler(1, 1, 0,
+      [&](const std::vector<int16_t>&, uint16_t) {
+        std::unique_lock<std::mutex> lock(mtx);
+        blocked = true;
+        cond.notify_all();
+        cond.wait(lock, [&]() { return release; });
+        bus.push_back(1);
+      });
+  interpolation::StrokeTimeline points(1);
+  points.push_back({0}, 0);
+  points.push_back({1000}, 100 * CSEC);
+  scheduler.submit(points, {});
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    ASSERT_TRUE(cond.wait_for(lock, std::chrono::seconds(1),
+                              [&]() { return blocked; }));
+  }
+
+  // paused while the first frame is on the bus
+  std::atomic<bool> paused(false);
+  std::thread pause([&]() {
+      scheduler.set_rate(0.0);
+      paused = true;
+      std::lock_guard<std::mutex> lock(mtx);
+      bus.push_back(0);
+    });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(paused.load()); // waits for the frame in flight
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    release = true;
+  }
+  cond.notify_all();
+  pause.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  // the frame reached the bus before servo_on, nothing after it
+  std::lock_guard<std::mutex> lock(mtx);
+  ASSERT_EQ(bus.size(), 2u);
+  EXPECT_EQ(bus[0], 1);
+  EXPECT_EQ(bus[1], 0);
+  EXPECT_TRUE(scheduler.paused());
+}
+
+/////////////////////////
+// highest stroke sent after a trajectory at 20 [stroke/csec] is preempted
+// by one holding the last stroke sent
+static int16_t preempted_peak(uint16_t _blend_csec, int16_t& _held,
+                              int16_t& _last)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(1, 1, 0, sent.function());
+  scheduler.set_blend(_blend_csec * CSEC);
+  interpolation::StrokeTimeline moving(1), holding(1);
+  moving.push_back({0}, 0);
+  moving.push_back({2000}, 100 * CSEC);
+  scheduler.submit(moving, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  size_t before = sent.get().size();
+  _held = sent.get().back()[0];
+  holding.push_back({_held}, 0);
+  holding.push_back({_held}, 50 * CSEC);
+  scheduler.submit(holding, {});
+  wait_idle(scheduler, 1000);
+
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  int16_t peak = _held;
+  for (size_t f = before; f < frames.size(); ++f)
+    peak = std::max(peak, frames[f][0]);
+  _last = frames.back()[0];
+  return peak;
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, blendsPreemptedTrack)
+{
+  int16_t held, last;
+  // switches at once, about a frame off
+  int16_t peak = preempted_peak(0, held, last);
+  EXPECT_LE(peak, held + 25);
+  EXPECT_EQ(last, held);
+
+  // keeps moving while blending, 100 [stroke] at 10 [csec]
+  peak = preempted_peak(20, held, last);
+  EXPECT_GT(peak, held + 50);
+  EXPECT_LT(peak, held + 150);
+  EXPECT_EQ(last, held);
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, preemptsWithinOneTransaction)
+{
+  // 100 [ms] frames, 5 [ms] for each bus transaction
+  SentFrames sent;
+  TrajectoryScheduler::SendFunction record = sent.function();
+  TrajectoryScheduler scheduler(2, 10, 0,
+      [&record](const std::vector<int16_t>& _strokes, uint16_t _csec) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        record(_strokes, _csec);
+      });
+  interpolation::StrokeTimeline points(2);
+  points.push_back({0, 0}, 0);
+  points.push_back({1000, 1000}, 100 * CSEC);
+  scheduler.submit(points, {});
+  std::this_thread::sleep_for(std::chrono::milliseconds(130));
+
+  points.stroke(0, 1) = 0x7fff;
+  for (int n = 0; n < 5; ++n) {
+    scheduler.submit(points, {});
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  }
+
+  PreemptionStatistics statistics = scheduler.preemption_statistics();
+  EXPECT_EQ(statistics.submits, 6u);
+  EXPECT_EQ(statistics.preemptions, 5u);
+  EXPECT_EQ(statistics.measured, 6u);
+  // at most a frame in flight and the frame of the submit
+  EXPECT_LT(statistics.max_latency_ms, 25.0);
+  EXPECT_GE(statistics.latency_ms, 5.0);
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, appendsToStream)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(2, 1, 0, sent.function());
+  // stroke 0 streamed at 50 [Hz], 2 [csec] ahead of each message
+  for (int n = 1; n <= 20; ++n) {
+    interpolation::StrokeTimeline points(2);
+    points.push_back({0, 0x7fff}, 0);
+    points.push_back({static_cast<int16_t>(n * 10), 0x7fff}, 2 * CSEC);
+    scheduler.append(points, 3 * CSEC, 20 * CSEC);
+    EXPECT_EQ(scheduler.number_of_tracks(), 1u) << n;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+  StreamStatistics statistics = scheduler.stream_statistics();
+  EXPECT_EQ(statistics.appends, 20u);
+  EXPECT_EQ(statistics.underruns, 0u);
+  // lookahead and time of the point, 50 [ms]
+  EXPECT_GE(statistics.latency_ms, 45.0);
+  EXPECT_LT(statistics.latency_ms, 70.0);
+
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  ASSERT_FALSE(frames.empty());
+  EXPECT_EQ(frames.back()[0], 200);
+  for (size_t f = 1; f < frames.size(); ++f) {
+    EXPECT_GE(frames[f][0], frames[f - 1][0]) << f;
+    EXPECT_EQ(frames[f][1], 0x7fff) << f;
+  }
+
+  // the last point is held until timeout
+  EXPECT_TRUE(scheduler.active());
+  ASSERT_TRUE(wait_idle(scheduler, 1000));
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, streamUnderrunContinues)
+{
+  SentFrames sent;
+  TrajectoryScheduler scheduler(1, 1, 0, sent.function());
+  interpolation::StrokeTimeline points(1);
+  points.push_back({0}, 0);
+  points.push_back({100}, CSEC);
+  scheduler.append(points, CSEC, 100 * CSEC);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  EXPECT_EQ(sent.get().back()[0], 100);
+
+  // late points start from the held point, not from where the phase is
+  size_t held = sent.get().size();
+  points.stroke(1, 0) = 300;
+  points.set_time(1, 10 * CSEC);
+  scheduler.append(points, CSEC, 100 * CSEC);
+  EXPECT_EQ(scheduler.number_of_tracks(), 1u);
+  EXPECT_EQ(scheduler.stream_statistics().underruns, 1u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  ASSERT_GT(frames.size(), held);
+  int16_t stroke = 100;
+  for (size_t f = held; f < frames.size(); ++f) {
+    // never back from the held point
+    EXPECT_GE(frames[f][0], stroke) << f;
+    stroke = frames[f][0];
+  }
+  EXPECT_GT(stroke, 100);
+  EXPECT_LT(stroke, 300);
+
+  // a submitted trajectory takes the strokes of the stream
+  scheduler.submit(points, {});
+  EXPECT_EQ(scheduler.number_of_tracks(), 1u);
+  scheduler.append(points, CSEC, 100 * CSEC);
+  EXPECT_EQ(scheduler.number_of_tracks(), 1u);
+  EXPECT_EQ(scheduler.stream_statistics().appends, 3u);
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, abortDropsTracks)
+{
+  SentFrames sent;
+  bool abort = false;
+  TrajectoryScheduler scheduler(1, 1, 0, sent.function(),
+                                [&abort]() { return abort; });
+  interpolation::StrokeTimeline points(1);
+  points.push_back({0}, 0);
+  points.push_back({1000}, 100 * CSEC);
+  abort = true;
+  scheduler.submit(points, {});
+  ASSERT_TRUE(wait_idle(scheduler, 1000));
+  EXPECT_TRUE(sent.get().empty());
+}
+
+/////////////////////////
+TEST(TrajectorySchedulerTest, takesStrokesOfManyTracks)
+{
+  const size_t strokes = 40;
+  SentFrames sent;
+  std::shared_ptr<ManualTrajectoryClock> clock(new ManualTrajectoryClock);
+  TrajectoryScheduler scheduler(strokes, 10, 0, sent.function(), nullptr,
+                                clock);
+  // a track per stroke
+  for (size_t i = 0; i < strokes; ++i) {
+    interpolation::StrokeTimeline points(strokes, 2);
+    points.stroke(0, i) = 0;
+    points.stroke(1, i) = 1000;
+    points.set_time(1, 100 * CSEC);
+    scheduler.submit(points, {});
+  }
+  EXPECT_EQ(scheduler.number_of_tracks(), strokes);
+
+  // one track takes the even strokes, the odd tracks keep running
+  interpolation::StrokeTimeline even(strokes, 2);
+  for (size_t i = 0; i < strokes; i += 2) {
+    even.stroke(0, i) = 0;
+    even.stroke(1, i) = -1000;
+  }
+  even.set_time(1, 100 * CSEC);
+  scheduler.submit(even, {});
+  EXPECT_EQ(scheduler.number_of_tracks(), strokes / 2 + 1);
+
+  EXPECT_TRUE(scheduler.step());
+  clock->advance(10 * CSEC);
+  EXPECT_TRUE(scheduler.step());
+  std::vector<std::vector<int16_t> > frames = sent.get();
+  ASSERT_EQ(frames.size(), 2u);
+  for (size_t i = 0; i < strokes; ++i)
+    EXPECT_EQ(frames[1][i], (i % 2 == 0 ? -200 : 200)) << i;
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,146 @@
+#include "aero_hardware_interface/TrajectorySimulator.hh"
+#include <gtest/gtest.h>
+
+using namespace aero;
+using namespace aero::controller;
+
+static const int64_t CSEC = 10000; // [usec]
+
+/////////////////////////
+static SimulatedTrajectory trajectory(int64_t _arrival_usec, bool _stream,
+                                      int16_t _to, int64_t _usec)
+{
+  SimulatedTrajectory t = {_arrival_usec, _stream,
+                           interpolation::StrokeTimeline(2), {}};
+  t.points.push_back({0, 0x7fff}, 0);
+  t.points.push_back({_to, 0x7fff}, _usec);
+  return t;
+}
+
+/////////////////////////
+TEST(TrajectorySimulatorTest, sendsEveryFrameWithTime)
+{
+  TrajectorySimulator simulator({0, 0}, 10, 2);
+  simulator.add(trajectory(0, false, 1000, 100 * CSEC));
+  simulator.run();
+
+  const std::vector<SimulatedFrame>& frames = simulator.frames();
+  ASSERT_EQ(frames.size(), 10u);
+  for (size_t f = 0; f < frames.size(); ++f) {
+    EXPECT_EQ(frames[f].usec, static_cast<int64_t>(f) * 10 * CSEC);
+    EXPECT_EQ(frames[f].csec, 12);
+    // one frame ahead
+    EXPECT_EQ(frames[f].strokes[0], static_cast<int16_t>((f + 1) * 100));
+    EXPECT_EQ(frames[f].strokes[1], 0x7fff);
+  }
+  EXPECT_EQ(simulator.duration(), 90 * CSEC);
+
+  ASSERT_EQ(simulator.reports().size(), 1u);
+  const SimulatedTrajectoryReport& r = simulator.reports()[0];
+  EXPECT_EQ(r.frames, 10u);
+  EXPECT_EQ(r.latency_usec, 0);
+  EXPECT_LT(r.max_error, 1.0);
+  EXPECT_DOUBLE_EQ(r.max_jitter_usec, 0.0);
+  EXPECT_GE(r.cpu_usec, 0.0);
+}
+
+/////////////////////////
+TEST(TrajectorySimulatorTest, followsCurves)
+{
+  TrajectorySimulator simulator({0, 0}, 10, 0);
+  SimulatedTrajectory t = trajectory(0, false, 1000, 100 * CSEC);
+  t.interpolation.push_back(nullptr);
+  t.interpolation.push_back(interpolation::InterpolationPtr(
+      new interpolation::Interpolation(interpolation::i_slowin)));
+  simulator.add(t);
+  simulator.run();
+
+  // not linear, and the error is against the curve
+  const std::vector<SimulatedFrame>& frames = simulator.frames();
+  ASSERT_EQ(frames.size(), 10u);
+  EXPECT_NE(frames[4].strokes[0], 500);
+  EXPECT_LT(simulator.reports()[0].max_error, 1.0);
+}
+
+/////////////////////////
+TEST(TrajectorySimulatorTest, preemptsBetweenFrames)
+{
+  TrajectorySimulator simulator({0, 0}, 10, 0);
+  simulator.add(trajectory(0, false, 1000, 100 * CSEC));
+  // arrives between frames, sent at once
+  simulator.add(trajectory(25 * CSEC, false, -1000, 100 * CSEC));
+  simulator.run();
+
+  const std::vector<SimulatedTrajectoryReport>& reports = simulator.reports();
+  EXPECT_EQ(reports[0].frames, 3u);
+  EXPECT_EQ(reports[1].latency_usec, 0);
+  EXPECT_EQ(reports[1].frames, 10u);
+  EXPECT_LT(reports[1].max_error, 1.0);
+
+  const std::vector<SimulatedFrame>& frames = simulator.frames();
+  ASSERT_EQ(frames.size(), 13u);
+  EXPECT_EQ(frames[3].usec, 25 * CSEC);
+  EXPECT_EQ(frames[4].usec, 35 * CSEC);
+  // the second starts from the strokes sent last (300)
+  EXPECT_LT(frames[3].strokes[0], 300);
+}
+
+/////////////////////////
+TEST(TrajectorySimulatorTest, reportsJitterOfWokenFrames)
+{
+  TrajectorySimulator simulator({0, 0}, 10, 0);
+  simulator.add(trajectory(0, false, 1000, 100 * CSEC));
+  // a second submit of other strokes wakes the scheduler between frames
+  SimulatedTrajectory other = {15 * CSEC, false,
+                               interpolation::StrokeTimeline(2), {}};
+  other.points.push_back({0x7fff, 0}, 0);
+  other.points.push_back({0x7fff, 500}, 50 * CSEC);
+  simulator.add(other);
+  simulator.run();
+
+  const SimulatedTrajectoryReport& r = simulator.reports()[0];
+  EXPECT_NEAR(r.max_jitter_usec, 5 * CSEC, 1);
+  EXPECT_GT(r.rms_jitter_usec, 0.0);
+  EXPECT_EQ(simulator.reports()[1].latency_usec, 0);
+}
+
+/////////////////////////
+TEST(TrajectorySimulatorTest, streamsWithLookahead)
+{
+  TrajectorySimulator simulator({0, 0}, 10, 0);
+  simulator.set_stream(10 * CSEC, 50 * CSEC);
+  for (int k = 0; k < 5; ++k)
+    simulator.add(trajectory(k * 10 * CSEC, true,
+                             static_cast<int16_t>((k + 1) * 100), 10 * CSEC));
+  simulator.run();
+
+  const std::vector<SimulatedFrame>& frames = simulator.frames();
+  ASSERT_FALSE(frames.empty());
+  EXPECT_EQ(frames.back().strokes[0], 500);
+  // held until the timeout after the last append
+  EXPECT_LE(simulator.duration(), 40 * CSEC + 60 * CSEC);
+  for (const SimulatedTrajectoryReport& r : simulator.reports())
+    EXPECT_GT(r.frames, 0u);
+}
+
+/////////////////////////
+TEST(TrajectorySimulatorTest, runsFasterThanRealTime)
+{
+  TrajectorySimulator simulator({0, 0}, 10, 0);
+  // ten minutes
+  simulator.add(trajectory(0, false, 10000, 60000 * CSEC));
+  auto start = std::chrono::steady_clock::now();
+  simulator.run();
+  double sec = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(simulator.frames().size(), 6000u);
+  EXPECT_LT(sec, 60.0);
+  // strokes are integers
+  EXPECT_LT(simulator.reports()[0].max_error, 2.0);
+}
+
+/////////////////////////
+int main(int argc, char **argv){
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
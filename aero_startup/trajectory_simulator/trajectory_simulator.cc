@@ -0,0 +1,275 @@
+/// @brief replay recorded joint trajectories offline through TrajectoryScheduler
+///
+/// usage: trajectory_simulator [options] FILE
+///   -r DIR    robot directory of ConversionTables (default generated
+///             conversion)
+///   -u SEC    upper_blend_window (default 0)
+///   -b SEC    lower_blend_window (default 0.2)
+///   -l SEC    stream_lookahead (default 0.1)
+///   -t SEC    stream_timeout (default 1.0)
+///   -p        print every frame
+///
+/// FILE holds trajectories as AeroControllerNode receives them,
+/// a header line per trajectory followed by its points:
+///
+///   # command or stream, arrival [s], joint names
+///   command 0.0 r_shoulder_p_joint r_elbow_joint
+///   # time_from_start [s], positions [rad]
+///   1.0 -0.5 -1.0
+///   2.0 0.0 0.0
+///
+/// `command` is submitted as on the joint trajectory topic,
+/// `stream` is appended as on command_stream (upper joints only).
+/// Both buses are simulated on a manual clock (no ROS, no bus),
+/// faster than real time, and the tracking error, jitter and CPU time
+/// of each trajectory are printed. Segments are linear (no interpolation
+/// service), and jitter only comes from frames woken by new trajectories.
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <unistd.h>
+
+#include "aero_hardware_interface/AeroControllers.hh"
+#include "aero_hardware_interface/AngleJointNames.hh"
+#include "aero_hardware_interface/Angle2StrokeBatch.hh"
+#include "aero_hardware_interface/ConversionTables.hh"
+#include "aero_hardware_interface/TrajectorySimulator.hh"
+
+using namespace aero;
+using namespace controller;
+
+/// @brief trajectory of FILE, angles in AngleJointNames order
+struct Recorded
+{
+  bool stream;
+
+  double arrival;
+
+  std::vector<bool> send;
+
+  std::vector<double> times;
+
+  /// @brief points x angle joints
+  std::vector<double> angles;
+};
+
+//////////////////////////////////////////////////
+static bool read_file(const std::string& _file,
+                      const std::vector<std::string>& _names,
+                      std::vector<Recorded>& _recorded)
+{
+  std::ifstream in(_file);
+  if (!in) {
+    std::cerr << "can not open " << _file << std::endl;
+    return false;
+  }
+
+  std::vector<int> ids;
+  std::string line;
+  for (size_t n = 1; std::getline(in, line); ++n) {
+    std::istringstream words(line);
+    std::string word;
+    if (!(words >> word) || word[0] == '#') continue;
+
+    if (word == "command" || word == "stream") {
+      Recorded r;
+      r.stream = (word == "stream");
+      r.send.assign(_names.size(), false);
+      if (!(words >> r.arrival)) {
+        std::cerr << _file << ":" << n << ": no arrival time" << std::endl;
+        return false;
+      }
+      ids.clear();
+      while (words >> word) {
+        auto it = std::find(_names.begin(), _names.end(), word);
+        if (it == _names.end()) {
+          std::cerr << _file << ":" << n << ": unknown joint " << word
+                    << std::endl;
+          return false;
+        }
+        ids.push_back(static_cast<int>(it - _names.begin()));
+        r.send[ids.back()] = true;
+      }
+      _recorded.push_back(r);
+      continue;
+    }
+
+    if (_recorded.empty()) {
+      std::cerr << _file << ":" << n << ": point before header" << std::endl;
+      return false;
+    }
+    Recorded& r = _recorded.back();
+    r.times.push_back(std::atof(word.c_str()));
+    size_t offset = r.angles.size();
+    r.angles.resize(offset + _names.size(), 0.0);
+    for (size_t j = 0; j < ids.size(); ++j)
+      if (!(words >> r.angles[offset + ids[j]])) {
+        std::cerr << _file << ":" << n << ": missing position" << std::endl;
+        return false;
+      }
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+// first point owns the strokes of the trajectory, strokes as converted
+static SimulatedTrajectory simulated(const Recorded& _recorded,
+                                     const std::vector<int16_t>& _strokes,
+                                     size_t _dof)
+{
+  SimulatedTrajectory t = {
+    static_cast<int64_t>(std::llround(_recorded.arrival * 1e6)),
+    _recorded.stream, interpolation::StrokeTimeline(_dof), {}};
+  t.points.reserve(_recorded.times.size() + 1);
+  t.points.push_back(_strokes.data(), 0);
+  for (size_t k = 0; k < _recorded.times.size(); ++k)
+    t.points.push_back(_strokes.data() + k * _dof,
+                       std::llround(_recorded.times[k] * 1e6));
+  return t;
+}
+
+//////////////////////////////////////////////////
+static void print(const std::string& _bus, const TrajectorySimulator& _sim,
+                  const std::vector<double>& _arrivals, bool _frames)
+{
+  if (_frames)
+    for (const SimulatedFrame& f : _sim.frames()) {
+      std::cout << _bus << " " << std::fixed << std::setprecision(6)
+                << f.usec * 1e-6 << " " << f.csec;
+      for (int16_t s : f.strokes) std::cout << " " << s;
+      std::cout << std::endl;
+    }
+
+  const std::vector<SimulatedTrajectoryReport>& reports = _sim.reports();
+  for (size_t k = 0; k < reports.size(); ++k) {
+    const SimulatedTrajectoryReport& r = reports[k];
+    std::cout << std::fixed << std::setprecision(3)
+              << _bus << " trajectory " << k << " at " << _arrivals[k]
+              << " [s]: " << r.frames << " frames, latency "
+              << r.latency_usec * 1e-3 << " [ms], error max "
+              << r.max_error << " rms " << r.rms_error
+              << " [stroke], jitter max " << r.max_jitter_usec * 1e-3
+              << " rms " << r.rms_jitter_usec * 1e-3 << " [ms], cpu "
+              << r.cpu_usec << " [us]" << std::endl;
+  }
+  size_t frames = _sim.frames().size();
+  std::cout << _bus << ": " << frames << " frames in "
+            << _sim.duration() * 1e-6 << " [s], cpu " << _sim.cpu_usec()
+            << " [us] (" << (frames > 0 ? _sim.cpu_usec() / frames : 0.0)
+            << " [us/frame])" << std::endl;
+}
+
+//////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  std::string robot_dir;
+  double upper_blend = 0.0, lower_blend = 0.2, lookahead = 0.1, timeout = 1.0;
+  bool frames = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "r:u:b:l:t:p")) != -1) {
+    switch (opt) {
+    case 'r': robot_dir = optarg; break;
+    case 'u': upper_blend = std::atof(optarg); break;
+    case 'b': lower_blend = std::atof(optarg); break;
+    case 'l': lookahead = std::atof(optarg); break;
+    case 't': timeout = std::atof(optarg); break;
+    case 'p': frames = true; break;
+    default:
+      std::cerr << "usage: " << argv[0]
+                << " [-r robot_dir] [-u upper_blend] [-b lower_blend]"
+                << " [-l lookahead] [-t timeout] [-p] FILE" << std::endl;
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    std::cerr << "usage: " << argv[0]
+              << " [-r robot_dir] [-u upper_blend] [-b lower_blend]"
+              << " [-l lookahead] [-t timeout] [-p] FILE" << std::endl;
+    return 1;
+  }
+
+  // controllers without port, for the number of joints only
+  std::vector<std::string> names;
+  {
+    AeroUpperController upper("");
+    AeroLowerController lower("");
+    names.resize(upper.get_number_of_angle_joints() +
+                 lower.get_number_of_angle_joints());
+  }
+  common::AngleJointNames(names);
+
+  // joints must be those of the built controllers, as in AeroControllerNode
+  std::unique_ptr<common::ConversionTables> tables;
+  if (!robot_dir.empty()) {
+    tables.reset(new common::ConversionTables);
+    if (!tables->load(robot_dir, "") ||
+        tables->angle_joint_names() != names ||
+        tables->number_of_strokes() != AERO_DOF) {
+      std::cerr << "can not use conversion of " << robot_dir << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<Recorded> recorded;
+  if (!read_file(argv[optind], names, recorded)) return 1;
+
+  // strokes of all joints at 0 before the first trajectory
+  std::vector<int16_t> upper, lower;
+  common::Angle2StrokeBatch(std::vector<double>(names.size(), 0.0),
+                            std::vector<bool>(names.size(), true),
+                            upper, lower, tables.get());
+
+  // same frames as the schedulers of AeroControllerNode
+  TrajectorySimulator upper_sim(upper, 10, 10);
+  TrajectorySimulator lower_sim(lower, 10, 10);
+  upper_sim.set_blend(static_cast<int64_t>(upper_blend * 1e6));
+  lower_sim.set_blend(static_cast<int64_t>(lower_blend * 1e6));
+  upper_sim.set_stream(static_cast<int64_t>(lookahead * 1e6),
+                       static_cast<int64_t>(timeout * 1e6));
+  std::vector<double> upper_arrivals, lower_arrivals;
+
+  for (const Recorded& r : recorded) {
+    if (r.times.empty()) continue;
+    common::Angle2StrokeBatch(r.angles, r.send, upper, lower, tables.get());
+
+    if (std::any_of(upper.begin(), upper.begin() + AERO_DOF_UPPER,
+                    [](int16_t _s) { return _s != 0x7fff; })) {
+      upper_sim.add(simulated(r, upper, AERO_DOF_UPPER));
+      upper_arrivals.push_back(r.arrival);
+    }
+    if (std::any_of(lower.begin(), lower.begin() + AERO_DOF_LOWER,
+                    [](int16_t _s) { return _s != 0x7fff; })) {
+      if (r.stream) {
+        std::cerr << "stream at " << r.arrival
+                  << " [s]: lower joints are not streamed" << std::endl;
+        continue;
+      }
+      lower_sim.add(simulated(r, lower, AERO_DOF_LOWER));
+      lower_arrivals.push_back(r.arrival);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  upper_sim.run();
+  lower_sim.run();
+  double elapsed = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  print("upper", upper_sim, upper_arrivals, frames);
+  print("lower", lower_sim, lower_arrivals, frames);
+  double simulated_sec =
+    std::max(upper_sim.duration(), lower_sim.duration()) * 1e-6;
+  std::cout << "simulated " << simulated_sec << " [s] in " << elapsed
+            << " [s] (x" << (elapsed > 0.0 ? simulated_sec / elapsed : 0.0)
+            << ")" << std::endl;
+
+  return 0;
+}